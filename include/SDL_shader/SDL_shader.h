@@ -5,12 +5,163 @@
 extern "C" {
 #endif
 
+typedef struct SDL_SHADER_Pack SDL_SHADER_Pack;
+
+typedef void *(SDLCALL *SDL_SHADER_MallocFunc)(void *userdata, size_t size);
+typedef void (SDLCALL *SDL_SHADER_FreeFunc)(void *userdata, void *mem);
+
+typedef enum SDL_SHADER_ResourceType
+{
+  SDL_SHADER_RESOURCE_SAMPLER,
+  SDL_SHADER_RESOURCE_STORAGE_TEXTURE,
+  SDL_SHADER_RESOURCE_STORAGE_BUFFER,
+  SDL_SHADER_RESOURCE_UNIFORM_BUFFER
+} SDL_SHADER_ResourceType;
+
+typedef enum SDL_SHADER_BaseType
+{
+  SDL_SHADER_BASETYPE_UNKNOWN,
+  SDL_SHADER_BASETYPE_BOOL,
+  SDL_SHADER_BASETYPE_INT,
+  SDL_SHADER_BASETYPE_UINT,
+  SDL_SHADER_BASETYPE_INT64,
+  SDL_SHADER_BASETYPE_UINT64,
+  SDL_SHADER_BASETYPE_HALF,
+  SDL_SHADER_BASETYPE_FLOAT,
+  SDL_SHADER_BASETYPE_DOUBLE,
+  SDL_SHADER_BASETYPE_STRUCT
+} SDL_SHADER_BaseType;
+
+// a member of a uniform or storage block, arrays of arrays are flattened.
+typedef struct SDL_SHADER_Member
+{
+  const char *name;
+  SDL_SHADER_BaseType base_type;
+  Uint32 offset;
+  Uint32 size;          // 0 for runtime sized arrays
+  Uint32 vecsize;       // components per column
+  Uint32 columns;       // 1 for scalars and vectors
+  Uint32 array_size;    // 0 when not an array
+  Uint32 array_stride;
+  Uint32 matrix_stride;
+  bool row_major;
+  bool runtime_array;
+  Sint32 block;         // index into blocks for struct members, -1 otherwise
+} SDL_SHADER_Member;
+
+typedef struct SDL_SHADER_Block
+{
+  const char *name;
+  Uint32 size;
+  Uint32 num_members;
+  const SDL_SHADER_Member *members;
+} SDL_SHADER_Block;
+
+// set and binding are the SPIR-V decorations. SDL_gpu numbers the resources of each type on their
+// own, the slot is the one to bind the resource to.
+typedef struct SDL_SHADER_Resource
+{
+  const char *name;
+  SDL_SHADER_ResourceType type;
+  Uint32 set;
+  Uint32 binding;
+  Uint32 slot;          // index among the resources of the same type and set, ordered by binding
+  Uint32 array_size;    // 1 for single resources, 0 for runtime sized arrays
+  bool readonly;
+  Sint32 block;         // index into blocks for buffers, -1 otherwise
+} SDL_SHADER_Resource;
+
+typedef struct SDL_SHADER_Reload
+{
+  const char *file;
+  SDL_GPUShader *old_shader;                // graphics shaders set the shader pair
+  SDL_GPUShader *new_shader;
+  SDL_GPUComputePipeline *old_pipeline;     // compute shaders set the pipeline pair
+  SDL_GPUComputePipeline *new_pipeline;
+} SDL_SHADER_Reload;
+
+typedef void (SDLCALL *SDL_SHADER_ReloadCallback)(void *userdata, const SDL_SHADER_Reload *reload);
+
+// what a thread was doing when it allocated, see SDL_SHADER_EnableMemoryTracking().
+typedef enum SDL_SHADER_MemoryStage
+{
+  SDL_SHADER_MEMORY_OTHER,
+  SDL_SHADER_MEMORY_IO,           // reading sources, blobs and packs, writing outputs
+  SDL_SHADER_MEMORY_FRONTEND,     // GLSL and HLSL to SPIR-V
+  SDL_SHADER_MEMORY_REFLECTION,
+  SDL_SHADER_MEMORY_DXIL,
+  SDL_SHADER_MEMORY_DXBC,
+  SDL_SHADER_MEMORY_MSL,
+  SDL_SHADER_MEMORY_ENCODE,       // building blobs
+  SDL_SHADER_MEMORY_CREATE,       // creating GPU shaders and pipelines
+  SDL_SHADER_MEMORY_STAGE_COUNT
+} SDL_SHADER_MemoryStage;
+
+typedef struct SDL_SHADER_MemoryStats
+{
+  Uint64 current;                                           // bytes allocated right now
+  Uint64 peak;
+  Uint64 allocations[SDL_SHADER_MEMORY_STAGE_COUNT];        // reallocations count as well
+  Uint64 bytes[SDL_SHADER_MEMORY_STAGE_COUNT];              // requested in total
+  Uint64 live_allocations[SDL_SHADER_MEMORY_STAGE_COUNT];   // not freed yet
+  Uint64 live_bytes[SDL_SHADER_MEMORY_STAGE_COUNT];
+} SDL_SHADER_MemoryStats;
+
+typedef struct SDL_SHADER_Reflection
+{
+  Uint32 num_resources;
+  const SDL_SHADER_Resource *resources;
+  Uint32 num_blocks;
+  const SDL_SHADER_Block *blocks;
+} SDL_SHADER_Reflection;
+
+// the _IO loaders read the stream front to back and only keep the code of the format the device uses,
+// so pipes and streams that don't know their size work as well.
 SDL_GPUShader* SDL_SHADER_Load(SDL_GPUDevice *device, const char *file);
 SDL_GPUShader* SDL_SHADER_Load_IO(SDL_GPUDevice* device, SDL_IOStream* src, bool closeio);
 
 SDL_GPUComputePipeline* SDL_SHADER_LoadCompute(SDL_GPUDevice *device, const char *file);
 SDL_GPUComputePipeline* SDL_SHADER_LoadCompute_IO(SDL_GPUDevice* device, SDL_IOStream* src, bool closeio);
 
+// packs hold many shaders in one file, see the --pack option. entries are named after the input file.
+SDL_SHADER_Pack* SDL_SHADER_OpenPack(const char *file);
+SDL_SHADER_Pack* SDL_SHADER_OpenPack_IO(SDL_IOStream* src, bool closeio);
+void SDL_SHADER_ClosePack(SDL_SHADER_Pack *pack);
+
+SDL_GPUShader* SDL_SHADER_LoadFromPack(SDL_GPUDevice *device, SDL_SHADER_Pack *pack, const char *name);
+SDL_GPUComputePipeline* SDL_SHADER_LoadComputeFromPack(SDL_GPUDevice *device, SDL_SHADER_Pack *pack, const char *name);
+
+// reads the reflection section of a blob compiled with --reflect, free it with SDL_SHADER_FreeReflection().
+SDL_SHADER_Reflection* SDL_SHADER_LoadReflection(const char *file);
+SDL_SHADER_Reflection* SDL_SHADER_LoadReflection_IO(SDL_IOStream* src, bool closeio);
+void SDL_SHADER_FreeReflection(SDL_SHADER_Reflection *reflection);
+
+// tracks the files of shaders loaded through SDL_SHADER_Load() and SDL_SHADER_LoadCompute() from now on.
+// changed files are reloaded by SDL_SHADER_UpdateHotReload(), which hands the new object to the callback.
+// releasing the old object is up to the application, it may still be used by in-flight pipelines.
+bool SDL_SHADER_EnableHotReload(SDL_SHADER_ReloadCallback callback, void *userdata);
+void SDL_SHADER_DisableHotReload(void);
+
+// call at a safe point, like the start of a frame. the callback runs on this thread without any lock
+// held, so it may untrack shaders or disable hot reloading.
+void SDL_SHADER_UpdateHotReload(void);
+
+// stops tracking a shader or compute pipeline, call it before releasing one.
+void SDL_SHADER_UntrackHotReload(void *handle);
+
+// route the temporary memory used while loading through custom callbacks, pass NULL to use SDL_malloc.
+void SDL_SHADER_SetAllocator(SDL_SHADER_MallocFunc malloc_func, SDL_SHADER_FreeFunc free_func, void *userdata);
+
+// use caller-owned memory for all temporary load state, pass NULL to disable.
+// the arena is rewound after every load and falls back to the allocator when it runs out.
+// it is not synchronized, so don't load from multiple threads while an arena is set.
+void SDL_SHADER_SetScratchArena(void *memory, size_t size);
+
+// installs counting allocators with SDL_SetMemoryFunctions(), call it before anything allocates through SDL,
+// like SDL_Init(). only memory allocated through SDL is seen, allocator callbacks and arenas are not.
+bool SDL_SHADER_EnableMemoryTracking(void);
+void SDL_SHADER_GetMemoryStats(SDL_SHADER_MemoryStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
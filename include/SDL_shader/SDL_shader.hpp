@@ -0,0 +1,461 @@
+#pragma once
+#include <SDL_shader/SDL_shader.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+/*
+  C++17 wrappers over the C API:
+
+    - Shader and ComputePipeline own their handle together with the device that created it and
+      release it through that device, Pack and Reflection close and free theirs. all are move-only
+    - BlobView reads the header of a blob held in memory. declared constexpr it checks a blob that
+      is embedded with #embed, xxd or a std::array at compile time
+    - Load<Formats>() creates straight from a BlobView and only looks at the formats given, by default
+      the ones the platform can use at all, so the others compile out
+*/
+
+namespace SDL_shader
+{
+  // the formats a device can ask for on this platform, at compile time
+#if defined(SDL_PLATFORM_APPLE)
+  inline constexpr SDL_GPUShaderFormat PlatformFormats = SDL_GPU_SHADERFORMAT_MSL | SDL_GPU_SHADERFORMAT_METALLIB;
+#elif defined(SDL_PLATFORM_XBOXONE) || defined(SDL_PLATFORM_XBOXSERIES)
+  inline constexpr SDL_GPUShaderFormat PlatformFormats = SDL_GPU_SHADERFORMAT_DXIL;
+#elif defined(SDL_PLATFORM_WINDOWS)
+  inline constexpr SDL_GPUShaderFormat PlatformFormats = SDL_GPU_SHADERFORMAT_SPIRV | SDL_GPU_SHADERFORMAT_DXBC | SDL_GPU_SHADERFORMAT_DXIL;
+#else
+  inline constexpr SDL_GPUShaderFormat PlatformFormats = SDL_GPU_SHADERFORMAT_SPIRV;
+#endif
+
+  namespace detail
+  {
+    inline void release(SDL_GPUDevice *device, SDL_GPUShader *shader)
+    {
+      SDL_SHADER_UntrackHotReload(shader);
+      SDL_ReleaseGPUShader(device, shader);
+    }
+
+    inline void release(SDL_GPUDevice *device, SDL_GPUComputePipeline *pipeline)
+    {
+      SDL_SHADER_UntrackHotReload(pipeline);
+      SDL_ReleaseGPUComputePipeline(device, pipeline);
+    }
+
+    // owns a handle created on a device, moving hands it over
+    template <typename T>
+    class DeviceHandle
+    {
+    public:
+      DeviceHandle() = default;
+      DeviceHandle(SDL_GPUDevice *device, T *handle) : device_(device), handle_(handle) {}
+
+      DeviceHandle(DeviceHandle &&other) noexcept : device_(other.device_), handle_(other.release()) {}
+
+      DeviceHandle &operator=(DeviceHandle &&other) noexcept
+      {
+        if (this != &other)
+        {
+          reset(other.device_, other.release());
+        }
+        return *this;
+      }
+
+      DeviceHandle(const DeviceHandle &) = delete;
+      DeviceHandle &operator=(const DeviceHandle &) = delete;
+
+      ~DeviceHandle()
+      {
+        reset();
+      }
+
+      T *get() const { return handle_; }
+      SDL_GPUDevice *device() const { return device_; }
+      explicit operator bool() const { return handle_ != nullptr; }
+
+      // gives up ownership without releasing
+      T *release()
+      {
+        T *handle = handle_;
+        handle_ = nullptr;
+        return handle;
+      }
+
+      // releases the current handle, like the old one of a hot reload, and takes the new one
+      void reset(T *handle = nullptr)
+      {
+        reset(device_, handle);
+      }
+
+      void reset(SDL_GPUDevice *device, T *handle)
+      {
+        if (handle_ != nullptr && handle_ != handle)
+        {
+          detail::release(device_, handle_);
+        }
+
+        device_ = device;
+        handle_ = handle;
+      }
+
+    private:
+      SDL_GPUDevice *device_ = nullptr;
+      T *handle_ = nullptr;
+    };
+
+    struct ClosePack
+    {
+      void operator()(SDL_SHADER_Pack *pack) const { SDL_SHADER_ClosePack(pack); }
+    };
+
+    struct FreeReflection
+    {
+      void operator()(SDL_SHADER_Reflection *reflection) const { SDL_SHADER_FreeReflection(reflection); }
+    };
+  }
+
+  using Shader = detail::DeviceHandle<SDL_GPUShader>;
+  using ComputePipeline = detail::DeviceHandle<SDL_GPUComputePipeline>;
+  using Pack = std::unique_ptr<SDL_SHADER_Pack, detail::ClosePack>;
+  using Reflection = std::unique_ptr<SDL_SHADER_Reflection, detail::FreeReflection>;
+
+  enum class Type : Uint32
+  {
+    Vertex,
+    Fragment,
+    Compute
+  };
+
+  // a blob in memory, which has to outlive the view. the header is read once on construction,
+  // the code of each format is found by walking the entries, which a constexpr view does while compiling.
+  class BlobView
+  {
+  public:
+    struct Code
+    {
+      const Uint8 *data = nullptr;
+      size_t size = 0;
+      SDL_GPUShaderFormat format = SDL_GPU_SHADERFORMAT_INVALID;
+    };
+
+    constexpr BlobView() = default;
+
+    template <size_t N>
+    constexpr BlobView(const Uint8 (&data)[N]) : BlobView(data, N) {}
+
+    template <size_t N>
+    constexpr BlobView(const std::array<Uint8, N> &data) : BlobView(data.data(), N) {}
+
+    constexpr BlobView(const Uint8 *data, size_t size) : data_(data), size_(size)
+    {
+      valid_ = parse();
+    }
+
+    constexpr bool valid() const { return valid_; }
+    constexpr SDL_GPUShaderFormat formats() const { return formats_; }
+    constexpr Type type() const { return type_; }
+    constexpr const Uint8 *data() const { return data_; }
+    constexpr size_t size() const { return size_; }
+
+    constexpr Uint32 num_samplers() const { return num_samplers_; }
+    constexpr Uint32 num_uniform_buffers() const { return num_uniform_buffers_; }
+    constexpr Uint32 num_storage_buffers() const { return num_storage_buffers_; }
+    constexpr Uint32 num_storage_textures() const { return num_storage_textures_; }
+    constexpr Uint32 num_storage_buffers_readonly() const { return num_storage_buffers_readonly_; }
+    constexpr Uint32 num_storage_textures_readonly() const { return num_storage_textures_readonly_; }
+    constexpr Uint32 thread_x() const { return thread_x_; }
+    constexpr Uint32 thread_y() const { return thread_y_; }
+    constexpr Uint32 thread_z() const { return thread_z_; }
+
+    // null terminated, not available at compile time
+    const char *entry() const
+    {
+      return valid_ ? reinterpret_cast<const char *>(data_ + entry_at_) : nullptr;
+    }
+
+    // the code of the first entry with one of the wanted formats, empty when there is none
+    constexpr Code code(SDL_GPUShaderFormat wanted) const
+    {
+      size_t at = codes_at_;
+      for (Uint32 i = 0; valid_ && i < num_shaders_; i++)
+      {
+        Uint32 format = le32(at);
+        Uint64 code_size = le64(at + 4);
+        at += 12;
+
+        if (wanted & format)
+        {
+          return Code{ data_ + at, static_cast<size_t>(code_size), format };
+        }
+
+        at += static_cast<size_t>(code_size);
+      }
+
+      return Code{};
+    }
+
+    constexpr bool has(SDL_GPUShaderFormat wanted) const
+    {
+      return code(wanted).data != nullptr;
+    }
+
+  private:
+    // entry point names are short, like in the loaders
+    static constexpr Uint32 max_entry_size = 4096;
+
+    constexpr Uint32 le32(size_t at) const
+    {
+      return static_cast<Uint32>(data_[at]) | static_cast<Uint32>(data_[at + 1]) << 8
+        | static_cast<Uint32>(data_[at + 2]) << 16 | static_cast<Uint32>(data_[at + 3]) << 24;
+    }
+
+    constexpr Uint64 le64(size_t at) const
+    {
+      return static_cast<Uint64>(le32(at)) | static_cast<Uint64>(le32(at + 4)) << 32;
+    }
+
+    // reads the next field when it fits
+    constexpr bool next32(size_t &at, Uint32 &value) const
+    {
+      if (size_ - at < 4)
+      {
+        return false;
+      }
+
+      value = le32(at);
+      at += 4;
+      return true;
+    }
+
+    constexpr bool parse()
+    {
+      if (data_ == nullptr)
+      {
+        return false;
+      }
+
+      size_t at = 0;
+      Uint32 type = 0;
+
+      if (!next32(at, formats_) || !next32(at, type) || type > static_cast<Uint32>(Type::Compute))
+      {
+        return false;
+      }
+      type_ = static_cast<Type>(type);
+
+      if (!next32(at, num_samplers_) || !next32(at, num_uniform_buffers_)
+        || !next32(at, num_storage_buffers_) || !next32(at, num_storage_textures_))
+      {
+        return false;
+      }
+
+      // the compute header has five extra fields
+      if (type_ == Type::Compute
+        && (!next32(at, num_storage_buffers_readonly_) || !next32(at, num_storage_textures_readonly_)
+        || !next32(at, thread_x_) || !next32(at, thread_y_) || !next32(at, thread_z_)))
+      {
+        return false;
+      }
+
+      Uint32 entry_size = 0;
+      if (!next32(at, num_shaders_) || !next32(at, entry_size))
+      {
+        return false;
+      }
+
+      if (entry_size == 0 || entry_size > max_entry_size || size_ - at < entry_size || data_[at + entry_size - 1] != 0)
+      {
+        return false;
+      }
+
+      entry_at_ = at;
+      at += entry_size;
+      codes_at_ = at;
+
+      // every entry has to fit, so code() never reads past the end
+      for (Uint32 i = 0; i < num_shaders_; i++)
+      {
+        if (size_ - at < 12)
+        {
+          return false;
+        }
+
+        Uint64 code_size = le64(at + 4);
+        at += 12;
+
+        if (code_size > size_ - at)
+        {
+          return false;
+        }
+
+        at += static_cast<size_t>(code_size);
+      }
+
+      return true;
+    }
+
+    const Uint8 *data_ = nullptr;
+    size_t size_ = 0;
+    bool valid_ = false;
+
+    SDL_GPUShaderFormat formats_ = 0;
+    Type type_ = Type::Vertex;
+
+    Uint32 num_samplers_ = 0;
+    Uint32 num_uniform_buffers_ = 0;
+    Uint32 num_storage_buffers_ = 0;
+    Uint32 num_storage_textures_ = 0;
+    Uint32 num_storage_buffers_readonly_ = 0;
+    Uint32 num_storage_textures_readonly_ = 0;
+    Uint32 thread_x_ = 0;
+    Uint32 thread_y_ = 0;
+    Uint32 thread_z_ = 0;
+
+    Uint32 num_shaders_ = 0;
+    size_t entry_at_ = 0;
+    size_t codes_at_ = 0;
+  };
+
+  namespace detail
+  {
+    // platforms with a single format skip asking the device
+    template <SDL_GPUShaderFormat Formats>
+    SDL_GPUShaderFormat wanted(SDL_GPUDevice *device)
+    {
+      static_assert(Formats != 0, "no shader format to load");
+
+      if constexpr ((Formats & (Formats - 1)) == 0)
+      {
+        return Formats;
+      }
+      else
+      {
+        return Formats & SDL_GetGPUShaderFormats(device);
+      }
+    }
+
+    // replace main with main0 on MSL
+    inline const char *entry(const BlobView &blob, SDL_GPUShaderFormat format)
+    {
+      return format == SDL_GPU_SHADERFORMAT_MSL && SDL_strcmp(blob.entry(), "main") == 0 ? "main0" : blob.entry();
+    }
+
+    inline bool check(const BlobView &blob, const BlobView::Code &code)
+    {
+      if (!blob.valid())
+      {
+        return SDL_SetError("the shader is invalid");
+      }
+
+      if (code.data == nullptr)
+      {
+        return SDL_SetError("the shader has no supported format");
+      }
+
+      return true;
+    }
+  }
+
+  inline Shader Load(SDL_GPUDevice *device, const char *file)
+  {
+    return Shader(device, SDL_SHADER_Load(device, file));
+  }
+
+  inline Shader Load(SDL_GPUDevice *device, SDL_IOStream *src, bool closeio)
+  {
+    return Shader(device, SDL_SHADER_Load_IO(device, src, closeio));
+  }
+
+  inline ComputePipeline LoadCompute(SDL_GPUDevice *device, const char *file)
+  {
+    return ComputePipeline(device, SDL_SHADER_LoadCompute(device, file));
+  }
+
+  inline ComputePipeline LoadCompute(SDL_GPUDevice *device, SDL_IOStream *src, bool closeio)
+  {
+    return ComputePipeline(device, SDL_SHADER_LoadCompute_IO(device, src, closeio));
+  }
+
+  // creates the shader from the code in place, without a copy. SPIR-V isn't converted by the fallback,
+  // load through SDL_IOFromConstMem() for that.
+  template <SDL_GPUShaderFormat Formats = PlatformFormats>
+  Shader Load(SDL_GPUDevice *device, const BlobView &blob)
+  {
+    BlobView::Code code = blob.code(detail::wanted<Formats>(device));
+    if (!detail::check(blob, code) || blob.type() == Type::Compute)
+    {
+      return Shader();
+    }
+
+    SDL_GPUShaderCreateInfo info = {};
+    info.entrypoint = detail::entry(blob, code.format);
+    info.num_samplers = blob.num_samplers();
+    info.num_uniform_buffers = blob.num_uniform_buffers();
+    info.num_storage_buffers = blob.num_storage_buffers();
+    info.num_storage_textures = blob.num_storage_textures();
+    info.code = code.data;
+    info.code_size = code.size;
+    info.format = code.format;
+    info.stage = blob.type() == Type::Vertex ? SDL_GPU_SHADERSTAGE_VERTEX : SDL_GPU_SHADERSTAGE_FRAGMENT;
+
+    return Shader(device, SDL_CreateGPUShader(device, &info));
+  }
+
+  template <SDL_GPUShaderFormat Formats = PlatformFormats>
+  ComputePipeline LoadCompute(SDL_GPUDevice *device, const BlobView &blob)
+  {
+    BlobView::Code code = blob.code(detail::wanted<Formats>(device));
+    if (!detail::check(blob, code) || blob.type() != Type::Compute)
+    {
+      return ComputePipeline();
+    }
+
+    SDL_GPUComputePipelineCreateInfo info = {};
+    info.entrypoint = detail::entry(blob, code.format);
+    info.num_samplers = blob.num_samplers();
+    info.num_uniform_buffers = blob.num_uniform_buffers();
+    info.num_readwrite_storage_buffers = blob.num_storage_buffers();
+    info.num_readwrite_storage_textures = blob.num_storage_textures();
+    info.num_readonly_storage_buffers = blob.num_storage_buffers_readonly();
+    info.num_readonly_storage_textures = blob.num_storage_textures_readonly();
+    info.threadcount_x = blob.thread_x();
+    info.threadcount_y = blob.thread_y();
+    info.threadcount_z = blob.thread_z();
+    info.code = code.data;
+    info.code_size = code.size;
+    info.format = code.format;
+
+    return ComputePipeline(device, SDL_CreateGPUComputePipeline(device, &info));
+  }
+
+  inline Pack OpenPack(const char *file)
+  {
+    return Pack(SDL_SHADER_OpenPack(file));
+  }
+
+  inline Pack OpenPack(SDL_IOStream *src, bool closeio)
+  {
+    return Pack(SDL_SHADER_OpenPack_IO(src, closeio));
+  }
+
+  inline Shader LoadFromPack(SDL_GPUDevice *device, const Pack &pack, const char *name)
+  {
+    return Shader(device, SDL_SHADER_LoadFromPack(device, pack.get(), name));
+  }
+
+  inline ComputePipeline LoadComputeFromPack(SDL_GPUDevice *device, const Pack &pack, const char *name)
+  {
+    return ComputePipeline(device, SDL_SHADER_LoadComputeFromPack(device, pack.get(), name));
+  }
+
+  inline Reflection LoadReflection(const char *file)
+  {
+    return Reflection(SDL_SHADER_LoadReflection(file));
+  }
+
+  inline Reflection LoadReflection(SDL_IOStream *src, bool closeio)
+  {
+    return Reflection(SDL_SHADER_LoadReflection_IO(src, closeio));
+  }
+}
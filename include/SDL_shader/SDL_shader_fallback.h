@@ -0,0 +1,18 @@
+#pragma once
+#include <SDL_shader/SDL_shader.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// optional module in the SDL_shader_fallback library, which links SDL_shadercross.
+// once enabled, shaders that hold no format the device takes are cross compiled from their
+// SPIR-V while loading, so blobs can ship with SPIR-V only. results are kept in cache_dir,
+// named after a hash of the SPIR-V, the entry point, the target format and the tool version,
+// so later launches load them instead. pass NULL to convert in memory on every load.
+bool SDL_SHADER_EnableFallback(const char *cache_dir);
+void SDL_SHADER_DisableFallback(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,4 +1,10 @@
 #include "common.h"
+#include "alloc.h"
+#include "fallback.h"
+#include "hotreload.h"
+#include "memory.h"
+#include "pack.h"
+#include "reflection.h"
 
 #include <SDL_shader/SDL_shader.h>
 #include <SDL3/SDL_filesystem.h>
@@ -7,143 +13,357 @@
 #include <stdio.h>
 #include <string.h>
 
-static Uint8 *read_le32(Uint8 *src, Uint32 *value)
+// unwanted payloads of streams that can't seek are read and dropped in chunks of this size
+#define SDL_SHADER_SKIP_CHUNK 4096
+
+// entry point names are short, a corrupt size must not allocate much
+#define SDL_SHADER_MAX_ENTRY_SIZE 4096
+
+// a blob being read from a stream, remaining limits it to its pack entry
+struct SDL_SHADER_Reader
+{
+  SDL_IOStream *src;
+  Uint64 remaining;
+};
+
+// reads exactly size bytes, pipes and network streams can hand them out in pieces
+static bool reader_read(struct SDL_SHADER_Reader *reader, void *dst, size_t size)
 {
-    Uint32 temp;
-    SDL_memcpy(&temp, src, sizeof(Uint32));
-    *value = SDL_Swap32LE(temp);
-    return src + sizeof(Uint32);
+  if (size > reader->remaining)
+  {
+    return SDL_SetError("the shader is truncated");
+  }
+
+  Uint8 *p = dst;
+  while (size > 0)
+  {
+    size_t read = SDL_ReadIO(reader->src, p, size);
+    if (read == 0)
+    {
+      return SDL_SetError("the shader is truncated");
+    }
+
+    p += read;
+    size -= read;
+    reader->remaining -= read;
+  }
+
+  return true;
 }
 
-static Uint8 *read_le64(Uint8 *src, Uint64 *value)
+static bool reader_le32(struct SDL_SHADER_Reader *reader, Uint32 *value)
 {
-    Uint64 temp;
-    SDL_memcpy(&temp, src, sizeof(Uint64));
-    *value = SDL_Swap64LE(temp);
-    return src + sizeof(Uint64);
+  Uint32 temp;
+  if (!reader_read(reader, &temp, sizeof(Uint32)))
+  {
+    return false;
+  }
+
+  *value = SDL_Swap32LE(temp);
+  return true;
 }
 
-SDL_GPUShader* SDL_SHADER_Load(SDL_GPUDevice *device, const char *file)
+static bool reader_le64(struct SDL_SHADER_Reader *reader, Uint64 *value)
 {
-  if (device == NULL)
+  Uint64 temp;
+  if (!reader_read(reader, &temp, sizeof(Uint64)))
   {
-    return NULL;
+    return false;
+  }
+
+  *value = SDL_Swap64LE(temp);
+  return true;
+}
+
+// moves past a payload, seeking when the stream can and reading it away otherwise
+static bool reader_skip(struct SDL_SHADER_Reader *reader, Uint64 size)
+{
+  if (size > reader->remaining)
+  {
+    return SDL_SetError("the shader is truncated");
   }
 
-  size_t size = 0;
-  void* data = SDL_LoadFile(file, &size);
+  if (size > 0 && size <= SDL_MAX_SINT64 && SDL_SeekIO(reader->src, (Sint64)size, SDL_IO_SEEK_CUR) >= 0)
+  {
+    reader->remaining -= size;
+    return true;
+  }
 
-  SDL_GPUShader* shader = SDL_SHADER_Load_IO(device, SDL_IOFromConstMem(data, size), true);
+  Uint8 chunk[SDL_SHADER_SKIP_CHUNK];
+  while (size > 0)
+  {
+    size_t part = size < sizeof(chunk) ? (size_t)size : sizeof(chunk);
+    if (!reader_read(reader, chunk, part))
+    {
+      return false;
+    }
 
-  SDL_free(data);
+    size -= part;
+  }
 
-  return shader;
+  return true;
 }
 
+// converts spirv for devices that want a format a blob doesn't hold, see fallback.h
+static Fallback_Func fallback;
 
-SDL_GPUShader* SDL_SHADER_Load_IO(SDL_GPUDevice* device, SDL_IOStream* src, bool closeio)
+void fallback_register(Fallback_Func func)
 {
-  SDL_GPUShader *gpuShader = NULL;
-  size_t size = SDL_GetIOSize(src);
-  void* data = SDL_malloc(size);
+  fallback = func;
+}
+
+// reads the blob header and the code of the first wanted format, skipping everything before it.
+// without one the SPIR-V goes through the fallback, when registered.
+// only the entry name and the chosen code are held in scratch memory, free both with scratch_free.
+static bool read_blob(SDL_IOStream *src, Uint64 size, SDL_GPUShaderFormat wanted, struct SDL_SHADER_Blob *blob, struct SDL_SHADER_Code *code)
+{
+  struct SDL_SHADER_Reader reader = { src, size };
 
-  // try to load data
-  if (!SDL_ReadIO(src, data, size))
+  if (!reader_le32(&reader, &blob->formats) || !reader_le32(&reader, &blob->type))
   {
-    if (closeio)
-    {
-      SDL_CloseIO(src);
-    }
-    return NULL;
+    return false;
   }
 
-  // start reading data
-  struct SDL_SHADER_Blob blob = {0};
-  Uint8 *p = data;
-  p = read_le32(p, &blob.formats);
-  p = read_le32(p, &blob.type);
-  blob.num_shaders = 0;
+  if (!reader_le32(&reader, &blob->num_samplers) || !reader_le32(&reader, &blob->num_uniform_buffers)
+    || !reader_le32(&reader, &blob->num_storage_buffers) || !reader_le32(&reader, &blob->num_storage_textures))
+  {
+    return false;
+  }
 
-  // skip compute shaders
-  if (blob.type == SDL_SHADER_TYPE_COMPUTE)
+  // the compute header has five extra fields
+  if (blob->type == SDL_SHADER_TYPE_COMPUTE
+    && (!reader_le32(&reader, &blob->num_storage_buffers_readonly) || !reader_le32(&reader, &blob->num_storage_textures_readonly)
+    || !reader_le32(&reader, &blob->thread_x) || !reader_le32(&reader, &blob->thread_y) || !reader_le32(&reader, &blob->thread_z)))
   {
-    if (closeio)
+    return false;
+  }
+
+  if (!reader_le32(&reader, &blob->num_shaders) || !reader_le32(&reader, &blob->entry_size))
+  {
+    return false;
+  }
+
+  if (blob->entry_size == 0 || blob->entry_size > SDL_SHADER_MAX_ENTRY_SIZE)
+  {
+    return SDL_SetError("the shader has an invalid entry point");
+  }
+
+  blob->entry = scratch_alloc(blob->entry_size);
+  if (blob->entry == NULL || !reader_read(&reader, blob->entry, blob->entry_size) || blob->entry[blob->entry_size - 1] != '\0')
+  {
+    return false;
+  }
+
+  // the header tells whether a wanted format follows, only then the SPIR-V has to be held on to.
+  // the fallback makes shader code, never sections
+  bool convert = fallback != NULL && !(blob->formats & wanted) && (wanted & ~SDL_SHADER_SECTION_REFLECTION) != 0;
+
+  // kept until the blob ends
+  struct SDL_SHADER_Code spirv = {0};
+  bool found = false;
+
+  for (Uint32 i = 0; i < blob->num_shaders && !found; i++)
+  {
+    Uint32 format;
+    Uint64 code_size;
+
+    if (!reader_le32(&reader, &format) || !reader_le64(&reader, &code_size))
     {
-      SDL_CloseIO(src);
+      scratch_free(spirv.code);
+      return false;
+    }
+
+    if (!(wanted & format) && !(convert && format == SDL_GPU_SHADERFORMAT_SPIRV && spirv.code == NULL))
+    {
+      if (!reader_skip(&reader, code_size))
+      {
+        scratch_free(spirv.code);
+        return false;
+      }
+
+      continue;
+    }
+
+    // the rest of the stream is never touched
+    if (code_size > reader.remaining || code_size > SIZE_MAX)
+    {
+      scratch_free(spirv.code);
+      return SDL_SetError("the shader is truncated");
+    }
+
+    found = (wanted & format) != 0;
+
+    struct SDL_SHADER_Code *dst = found ? code : &spirv;
+    dst->format = format;
+    dst->code_size = (size_t)code_size;
+    dst->code = scratch_alloc(dst->code_size ? dst->code_size : 1);
+
+    if (dst->code == NULL || !reader_read(&reader, dst->code, dst->code_size))
+    {
+      scratch_free(spirv.code);
+      return false;
     }
-    return NULL;
   }
 
-  p = read_le32(p, &blob.num_samplers);
-  p = read_le32(p, &blob.num_uniform_buffers);
-  p = read_le32(p, &blob.num_storage_buffers);
-  p = read_le32(p, &blob.num_storage_textures);
-  p = read_le32(p, &blob.num_shaders);
-  p = read_le32(p, &blob.entry_size);
-  
-  blob.entry = (char*)p;
-  p += blob.entry_size * sizeof(char);
+  if (found)
+  {
+    scratch_free(spirv.code);
+    return true;
+  }
 
+  if (spirv.code != NULL)
+  {
+    bool converted = fallback(blob, &spirv, wanted, code);
+    scratch_free(spirv.code);
+    return converted;
+  }
 
-  blob.shaders = SDL_malloc(blob.num_shaders * sizeof(struct SDL_SHADER_Code*));
+  return SDL_SetError("the shader has no supported format");
+}
 
-  for (int i = 0; i < blob.num_shaders; i++)
-  { 
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct SDL_SHADER_Code));
-    p = read_le32(p, &shader->format);
-    p = read_le64(p, &shader->code_size);
-    shader->code = p;
-    p += shader->code_size;
-    blob.shaders[i] = shader;
+// creates a graphics shader from a blob read by read_blob
+static SDL_GPUShader *create_shader(SDL_GPUDevice *device, const struct SDL_SHADER_Blob *blob, const struct SDL_SHADER_Code *code)
+{
+  // skip compute shaders
+  if (blob->type == SDL_SHADER_TYPE_COMPUTE)
+  {
+    return NULL;
   }
 
   SDL_GPUShaderCreateInfo info = {0};
-  info.entrypoint = blob.entry;
-  info.num_samplers = blob.num_samplers;
-  info.num_uniform_buffers = blob.num_uniform_buffers;
-  info.num_storage_buffers = blob.num_storage_buffers;
-  info.num_storage_textures = blob.num_storage_textures;
-  
-  if (blob.type == SDL_SHADER_TYPE_VERTEX)
+  info.entrypoint = blob->entry;
+  info.num_samplers = blob->num_samplers;
+  info.num_uniform_buffers = blob->num_uniform_buffers;
+  info.num_storage_buffers = blob->num_storage_buffers;
+  info.num_storage_textures = blob->num_storage_textures;
+  info.code = code->code;
+  info.code_size = code->code_size;
+  info.format = code->format;
+
+  if (blob->type == SDL_SHADER_TYPE_VERTEX)
   {
     info.stage = SDL_GPU_SHADERSTAGE_VERTEX;
   }
-  else if (blob.type == SDL_SHADER_TYPE_FRAGMENT)
+  else if (blob->type == SDL_SHADER_TYPE_FRAGMENT)
   {
     info.stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
   }
 
-  info.code = NULL;
+  // replace main with main0 on MSL
+  if (info.format == SDL_GPU_SHADERFORMAT_MSL && SDL_strcmp(blob->entry, "main") == 0)
+  {
+    info.entrypoint = "main0";
+  }
 
-  for (int i = 0; i < blob.num_shaders; i++)
+  return SDL_CreateGPUShader(device, &info);
+}
+
+// creates a compute pipeline from a blob read by read_blob
+static SDL_GPUComputePipeline *create_compute(SDL_GPUDevice *device, const struct SDL_SHADER_Blob *blob, const struct SDL_SHADER_Code *code)
+{
+  // skip graphics shaders
+  if (blob->type != SDL_SHADER_TYPE_COMPUTE)
   {
-    struct SDL_SHADER_Code *shader = blob.shaders[i];
-    if (SDL_GetGPUShaderFormats(device) & shader->format)
-    {
-      info.code = shader->code;
-      info.code_size = shader->code_size;
-      info.format = shader->format;
-      break;
-    }
+    return NULL;
   }
 
-  if (info.code != NULL)
+  SDL_GPUComputePipelineCreateInfo info = {0};
+  info.entrypoint = blob->entry;
+  info.num_samplers = blob->num_samplers;
+  info.num_uniform_buffers = blob->num_uniform_buffers;
+  info.num_readwrite_storage_buffers = blob->num_storage_buffers;
+  info.num_readwrite_storage_textures = blob->num_storage_textures;
+  info.num_readonly_storage_buffers = blob->num_storage_buffers_readonly;
+  info.num_readonly_storage_textures = blob->num_storage_textures_readonly;
+  info.threadcount_x = blob->thread_x;
+  info.threadcount_y = blob->thread_y;
+  info.threadcount_z = blob->thread_z;
+  info.props = 0;
+  info.code = code->code;
+  info.code_size = code->code_size;
+  info.format = code->format;
+
+  // replace main with main0 on MSL
+  if (info.format == SDL_GPU_SHADERFORMAT_MSL && SDL_strcmp(blob->entry, "main") == 0)
   {
-    // replace main with main0 on MSL
-    if (info.format == SDL_GPU_SHADERFORMAT_MSL && SDL_strcmp(blob.entry, "main") == 0)
-    {
-      info.entrypoint = "main0";
-    }
-    
-    gpuShader = SDL_CreateGPUShader(device, &info);
+    info.entrypoint = "main0";
   }
 
-  // free the memory
-  for (int i = 0; i < blob.num_shaders; i++) 
+  return SDL_CreateGPUComputePipeline(device, &info);
+}
+
+// streams a blob of at most size bytes and creates a shader from it
+static SDL_GPUShader *load_shader(SDL_GPUDevice *device, SDL_IOStream *src, Uint64 size)
+{
+  size_t mark = scratch_mark();
+  struct SDL_SHADER_Blob blob = {0};
+  struct SDL_SHADER_Code code = {0};
+
+  SDL_GPUShader *gpuShader = NULL;
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  bool read = read_blob(src, size, SDL_GetGPUShaderFormats(device), &blob, &code);
+
+  memory_stage(SDL_SHADER_MEMORY_CREATE);
+  if (read)
+  {
+    gpuShader = create_shader(device, &blob, &code);
+  }
+  memory_stage(stage);
+
+  scratch_free(code.code);
+  scratch_free(blob.entry);
+  scratch_release(mark);
+  return gpuShader;
+}
+
+// streams a blob of at most size bytes and creates a compute pipeline from it
+static SDL_GPUComputePipeline *load_compute(SDL_GPUDevice *device, SDL_IOStream *src, Uint64 size)
+{
+  size_t mark = scratch_mark();
+  struct SDL_SHADER_Blob blob = {0};
+  struct SDL_SHADER_Code code = {0};
+
+  SDL_GPUComputePipeline *pipeline = NULL;
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  bool read = read_blob(src, size, SDL_GetGPUShaderFormats(device), &blob, &code);
+
+  memory_stage(SDL_SHADER_MEMORY_CREATE);
+  if (read)
   {
-    SDL_free(blob.shaders[i]);
+    pipeline = create_compute(device, &blob, &code);
   }
-  SDL_free(blob.shaders);
+  memory_stage(stage);
+
+  scratch_free(code.code);
+  scratch_free(blob.entry);
+  scratch_release(mark);
+  return pipeline;
+}
+
+SDL_GPUShader* SDL_SHADER_Load(SDL_GPUDevice *device, const char *file)
+{
+  if (device == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_IOStream *src = SDL_IOFromFile(file, "rb");
+  if (src == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_GPUShader *gpuShader = SDL_SHADER_Load_IO(device, src, true);
+  hotreload_track(device, file, gpuShader, false);
+
+  return gpuShader;
+}
+
+
+SDL_GPUShader* SDL_SHADER_Load_IO(SDL_GPUDevice* device, SDL_IOStream* src, bool closeio)
+{
+  // the size isn't needed, so pipes and compressed streams work too
+  SDL_GPUShader *gpuShader = load_shader(device, src, SDL_MAX_UINT64);
 
   // close the IOStream
   if (closeio)
@@ -161,12 +381,14 @@ SDL_GPUComputePipeline* SDL_SHADER_LoadCompute(SDL_GPUDevice *device, const char
     return NULL;
   }
 
-  size_t size = 0;
-  void* data = SDL_LoadFile(file, &size);
-
-  SDL_GPUComputePipeline* pipeline = SDL_SHADER_LoadCompute_IO(device, SDL_IOFromConstMem(data, size), true);
+  SDL_IOStream *src = SDL_IOFromFile(file, "rb");
+  if (src == NULL)
+  {
+    return NULL;
+  }
 
-  SDL_free(data);
+  SDL_GPUComputePipeline *pipeline = SDL_SHADER_LoadCompute_IO(device, src, true);
+  hotreload_track(device, file, pipeline, true);
 
   return pipeline;
 }
@@ -174,14 +396,99 @@ SDL_GPUComputePipeline* SDL_SHADER_LoadCompute(SDL_GPUDevice *device, const char
 
 SDL_GPUComputePipeline* SDL_SHADER_LoadCompute_IO(SDL_GPUDevice* device, SDL_IOStream* src, bool closeio)
 {
-  SDL_GPUComputePipeline *pipeline = NULL;
-  size_t size = SDL_GetIOSize(src);
-  void* data = SDL_malloc(size);
+  SDL_GPUComputePipeline *pipeline = load_compute(device, src, SDL_MAX_UINT64);
 
-  // try to load data
-  if (!SDL_ReadIO(src, data, size))
+  // close the IOStream
+  if (closeio)
+  {
+    SDL_CloseIO(src);
+  }
+
+  return pipeline;
+}
+
+SDL_SHADER_Reflection* SDL_SHADER_LoadReflection(const char *file)
+{
+  SDL_IOStream *src = SDL_IOFromFile(file, "rb");
+  if (src == NULL)
+  {
+    return NULL;
+  }
+
+  return SDL_SHADER_LoadReflection_IO(src, true);
+}
+
+SDL_SHADER_Reflection* SDL_SHADER_LoadReflection_IO(SDL_IOStream* src, bool closeio)
+{
+  SDL_SHADER_Reflection *reflection = NULL;
+  size_t mark = scratch_mark();
+
+  // the code of every format is skipped, the section comes last
+  struct SDL_SHADER_Blob blob = {0};
+  struct SDL_SHADER_Code code = {0};
+
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  bool read = read_blob(src, SDL_MAX_UINT64, SDL_SHADER_SECTION_REFLECTION, &blob, &code);
+
+  memory_stage(SDL_SHADER_MEMORY_REFLECTION);
+  if (read)
+  {
+    reflection = reflection_decode(code.code, code.code_size);
+  }
+  else
+  {
+    SDL_SetError("the shader has no reflection section");
+  }
+  memory_stage(stage);
+
+  // free the memory
+  scratch_free(code.code);
+  scratch_free(blob.entry);
+  scratch_release(mark);
+
+  // close the IOStream
+  if (closeio)
+  {
+    SDL_CloseIO(src);
+  }
+
+  return reflection;
+}
+
+void SDL_SHADER_FreeReflection(SDL_SHADER_Reflection *reflection)
+{
+  SDL_free(reflection);
+}
+
+struct SDL_SHADER_Pack
+{
+  SDL_IOStream *io;
+  bool closeio;
+  struct Pack pack;
+};
+
+SDL_SHADER_Pack* SDL_SHADER_OpenPack(const char *file)
+{
+  SDL_IOStream *src = SDL_IOFromFile(file, "rb");
+  if (src == NULL)
+  {
+    return NULL;
+  }
+
+  return SDL_SHADER_OpenPack_IO(src, true);
+}
+
+SDL_SHADER_Pack* SDL_SHADER_OpenPack_IO(SDL_IOStream* src, bool closeio)
+{
+  if (src == NULL)
+  {
+    SDL_SetError("the pack stream is NULL");
+    return NULL;
+  }
+
+  SDL_SHADER_Pack *pack = SDL_malloc(sizeof(SDL_SHADER_Pack));
+  if (pack == NULL)
   {
-    SDL_free(data);
     if (closeio)
     {
       SDL_CloseIO(src);
@@ -189,103 +496,74 @@ SDL_GPUComputePipeline* SDL_SHADER_LoadCompute_IO(SDL_GPUDevice* device, SDL_IOS
     return NULL;
   }
 
-  // start reading data
-  struct SDL_SHADER_Blob blob = {0};
-  Uint8 *p = data;
-  p = read_le32(p, &blob.formats);
-  p = read_le32(p, &blob.type);
-  blob.num_shaders = 0;
+  pack->io = src;
+  pack->closeio = closeio;
 
-  // skip graphics shaders
-  if (blob.type != SDL_SHADER_TYPE_COMPUTE)
+  if (!pack_read(src, &pack->pack))
   {
     if (closeio)
     {
       SDL_CloseIO(src);
     }
+    SDL_free(pack);
     return NULL;
   }
 
-  p = read_le32(p, &blob.num_samplers);
-  p = read_le32(p, &blob.num_uniform_buffers);
-  p = read_le32(p, &blob.num_storage_buffers);
-  p = read_le32(p, &blob.num_storage_textures);
-  p = read_le32(p, &blob.num_storage_buffers_readonly);
-  p = read_le32(p, &blob.num_storage_textures_readonly);
-  p = read_le32(p, &blob.thread_x);
-  p = read_le32(p, &blob.thread_y);
-  p = read_le32(p, &blob.thread_z);
-  p = read_le32(p, &blob.num_shaders);
-  p = read_le32(p, &blob.entry_size);
-  
-  blob.entry = (char*)p;
-  p += blob.entry_size * sizeof(char);
-
-  blob.shaders = SDL_malloc(blob.num_shaders * sizeof(struct SDL_SHADER_Code*));
-
-  for (int i = 0; i < blob.num_shaders; i++)
-  { 
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct SDL_SHADER_Code));
-    p = read_le32(p, &shader->format);
-    p = read_le64(p, &shader->code_size);
-    shader->code = p;
-    p += shader->code_size;
-    blob.shaders[i] = shader;
-    
-    char* c = (char*)shader->code;
+  return pack;
+}
+
+void SDL_SHADER_ClosePack(SDL_SHADER_Pack *pack)
+{
+  if (pack == NULL)
+  {
+    return;
   }
 
-  SDL_GPUComputePipelineCreateInfo info = {0};
-  info.entrypoint = blob.entry;
-  info.num_samplers = blob.num_samplers;
-  info.num_uniform_buffers = blob.num_uniform_buffers;
-  info.num_readwrite_storage_buffers = blob.num_storage_buffers;
-  info.num_readwrite_storage_textures = blob.num_storage_textures;
-  info.num_readonly_storage_buffers = blob.num_storage_buffers_readonly;
-  info.num_readonly_storage_textures = blob.num_storage_textures_readonly;
-  info.threadcount_x = blob.thread_x;
-  info.threadcount_y = blob.thread_y;
-  info.threadcount_z = blob.thread_z;
-  info.props = 0;
+  if (pack->closeio)
+  {
+    SDL_CloseIO(pack->io);
+  }
 
-  info.code = NULL;
+  pack_free(&pack->pack);
+  SDL_free(pack);
+}
 
-  for (int i = 0; i < blob.num_shaders; i++)
+// moves the pack stream to the start of a blob
+static struct Pack_Entry *seek_packed(SDL_SHADER_Pack *pack, const char *name)
+{
+  struct Pack_Entry *entry = pack_find(&pack->pack, name);
+  if (entry == NULL)
   {
-    struct SDL_SHADER_Code* shader = blob.shaders[i];
-    if (SDL_GetGPUShaderFormats(device) & shader->format)
-    {
-      info.code = shader->code;
-      info.code_size = shader->code_size;
-      info.format = shader->format;
-      break;
-    }
+    SDL_SetError("\"%s\" is not in the pack", name);
+    return NULL;
   }
 
-  if (info.code != NULL)
+  if (SDL_SeekIO(pack->io, (Sint64)entry->offset, SDL_IO_SEEK_SET) < 0)
   {
-    // replace main with main0 on MSL
-    if (info.format == SDL_GPU_SHADERFORMAT_MSL && SDL_strcmp(blob.entry, "main") == 0)
-    {
-      info.entrypoint = "main0";
-    }
-
-    pipeline = SDL_CreateGPUComputePipeline(device, &info);
+    return NULL;
   }
 
-  // free the memory
-  for (int i = 0; i < blob.num_shaders; i++) 
+  return entry;
+}
+
+SDL_GPUShader* SDL_SHADER_LoadFromPack(SDL_GPUDevice *device, SDL_SHADER_Pack *pack, const char *name)
+{
+  if (device == NULL || pack == NULL)
   {
-    SDL_free(blob.shaders[i]);
+    return NULL;
   }
-  SDL_free(blob.shaders);
 
-  // close the IOStream
-  if (closeio)
+  struct Pack_Entry *entry = seek_packed(pack, name);
+  return entry != NULL ? load_shader(device, pack->io, entry->size) : NULL;
+}
+
+SDL_GPUComputePipeline* SDL_SHADER_LoadComputeFromPack(SDL_GPUDevice *device, SDL_SHADER_Pack *pack, const char *name)
+{
+  if (device == NULL || pack == NULL)
   {
-    SDL_CloseIO(src);
+    return NULL;
   }
 
-  return pipeline;
+  struct Pack_Entry *entry = seek_packed(pack, name);
+  return entry != NULL ? load_compute(device, pack->io, entry->size) : NULL;
 }
-
@@ -0,0 +1,108 @@
+#include "alloc.h"
+
+#include <SDL_shader/SDL_shader.h>
+
+#define SCRATCH_ALIGNMENT 16
+
+struct Allocator
+{
+  SDL_SHADER_MallocFunc malloc_func;
+  SDL_SHADER_FreeFunc free_func;
+  void *userdata;
+
+  Uint8 *arena;
+  size_t arena_size;
+  size_t arena_offset;
+};
+
+static struct Allocator allocator = {0};
+
+void SDL_SHADER_SetAllocator(SDL_SHADER_MallocFunc malloc_func, SDL_SHADER_FreeFunc free_func, void *userdata)
+{
+  // both callbacks are required, otherwise fall back to SDL_malloc
+  if (malloc_func == NULL || free_func == NULL)
+  {
+    malloc_func = NULL;
+    free_func = NULL;
+    userdata = NULL;
+  }
+
+  allocator.malloc_func = malloc_func;
+  allocator.free_func = free_func;
+  allocator.userdata = userdata;
+}
+
+void SDL_SHADER_SetScratchArena(void *memory, size_t size)
+{
+  if (memory == NULL)
+  {
+    size = 0;
+  }
+
+  allocator.arena = memory;
+  allocator.arena_size = size;
+  allocator.arena_offset = 0;
+}
+
+void *scratch_alloc(size_t size)
+{
+  if (size == 0)
+  {
+    size = 1;
+  }
+
+  // bump allocate from the arena
+  if (allocator.arena != NULL)
+  {
+    size_t offset = (allocator.arena_offset + SCRATCH_ALIGNMENT - 1) & ~(size_t)(SCRATCH_ALIGNMENT - 1);
+    if (offset <= allocator.arena_size && size <= allocator.arena_size - offset)
+    {
+      allocator.arena_offset = offset + size;
+      return allocator.arena + offset;
+    }
+  }
+
+  // the arena is missing or full
+  if (allocator.malloc_func != NULL)
+  {
+    return allocator.malloc_func(allocator.userdata, size);
+  }
+
+  return SDL_malloc(size);
+}
+
+void scratch_free(void *mem)
+{
+  if (mem == NULL)
+  {
+    return;
+  }
+
+  // arena memory is only released through scratch_release()
+  Uint8 *p = mem;
+  if (allocator.arena != NULL && p >= allocator.arena && p < allocator.arena + allocator.arena_size)
+  {
+    return;
+  }
+
+  if (allocator.free_func != NULL)
+  {
+    allocator.free_func(allocator.userdata, mem);
+    return;
+  }
+
+  SDL_free(mem);
+}
+
+size_t scratch_mark(void)
+{
+  return allocator.arena_offset;
+}
+
+void scratch_release(size_t mark)
+{
+  if (mark <= allocator.arena_offset)
+  {
+    allocator.arena_offset = mark;
+  }
+}
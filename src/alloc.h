@@ -0,0 +1,11 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+// temporary memory used while loading shaders.
+// comes from the scratch arena when one is set, otherwise from the allocator callbacks.
+void *scratch_alloc(size_t size);
+void scratch_free(void *mem);
+
+// everything allocated from the arena after a mark is released at once
+size_t scratch_mark(void);
+void scratch_release(size_t mark);
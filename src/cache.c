@@ -0,0 +1,78 @@
+#include "cache.h"
+
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_timer.h>
+
+// the entry file, named by the key in hex. free with SDL_free
+static char *entry_path(const char *folder, const Uint8 key[HASH_SIZE])
+{
+  static const char digits[] = "0123456789abcdef";
+
+  char name[HASH_SIZE * 2 + 1];
+  for (int i = 0; i < HASH_SIZE; i++)
+  {
+    name[i * 2] = digits[key[i] >> 4];
+    name[i * 2 + 1] = digits[key[i] & 15];
+  }
+  name[HASH_SIZE * 2] = '\0';
+
+  char *path;
+  size_t len = SDL_strlen(folder);
+  bool separated = len > 0 && (folder[len - 1] == '/' || folder[len - 1] == '\\');
+
+  if (SDL_asprintf(&path, "%s%s%s", folder, separated ? "" : "/", name) < 0)
+  {
+    return NULL;
+  }
+
+  return path;
+}
+
+void *cache_load(const char *folder, const Uint8 key[HASH_SIZE], size_t *size)
+{
+  char *path = entry_path(folder, key);
+  if (path == NULL)
+  {
+    return NULL;
+  }
+
+  void *data = SDL_LoadFile(path, size);
+  SDL_free(path);
+  return data;
+}
+
+bool cache_store(const char *folder, const Uint8 key[HASH_SIZE], const void *data, size_t size)
+{
+  char *path = entry_path(folder, key);
+  if (path == NULL)
+  {
+    return false;
+  }
+
+  // unique per thread and process, jobs of a build may store the same entry at once
+  char *tmp;
+  if (SDL_asprintf(&tmp, "%s.%" SDL_PRIu64 ".%" SDL_PRIu64 ".tmp", path, SDL_GetCurrentThreadID(), SDL_GetTicksNS()) < 0)
+  {
+    SDL_free(path);
+    return false;
+  }
+
+  bool saved = SDL_SaveFile(tmp, data, size);
+  if (!saved)
+  {
+    SDL_CreateDirectory(folder);
+    saved = SDL_SaveFile(tmp, data, size);
+  }
+
+  bool stored = saved && SDL_RenamePath(tmp, path);
+  if (!stored)
+  {
+    SDL_RemovePath(tmp);
+  }
+
+  SDL_free(tmp);
+  SDL_free(path);
+  return stored;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include "hash.h"
+
+/*
+  a folder of files named after the hash of whatever produced them. compile
+  keeps the spirv of its front-end passes here, so a build that only changes
+  its formats goes straight to the back-ends. entries are written through a
+  temporary file and a rename, so several processes can share a folder.
+*/
+
+// loads an entry, NULL when it isn't cached. free with SDL_free
+void *cache_load(const char *folder, const Uint8 key[HASH_SIZE], size_t *size);
+
+// stores an entry, creating the folder when needed
+bool cache_store(const char *folder, const Uint8 key[HASH_SIZE], const void *data, size_t size);
@@ -0,0 +1,293 @@
+#include "codegen.h"
+#include "compile.h"
+
+#include <SDL3/SDL_iostream.h>
+
+// copies name into dst as a valid C identifier
+static void identifier(char *dst, size_t dst_size, const char *name, const char *fallback, Uint32 index)
+{
+  if (name == NULL || *name == '\0')
+  {
+    SDL_snprintf(dst, dst_size, "%s%u", fallback, index);
+    return;
+  }
+
+  size_t pos = 0;
+  if (SDL_isdigit(*name) && pos + 1 < dst_size)
+  {
+    dst[pos++] = '_';
+  }
+
+  for (const char *c = name; *c != '\0' && pos + 1 < dst_size; c++)
+  {
+    dst[pos++] = SDL_isalnum(*c) ? *c : '_';
+  }
+
+  dst[pos] = '\0';
+}
+
+static const char *scalar_name(SDL_SHADER_BaseType type, Uint32 *size)
+{
+  switch (type)
+  {
+    case SDL_SHADER_BASETYPE_BOOL: *size = 4; return "uint32_t";
+    case SDL_SHADER_BASETYPE_INT: *size = 4; return "int32_t";
+    case SDL_SHADER_BASETYPE_UINT: *size = 4; return "uint32_t";
+    case SDL_SHADER_BASETYPE_INT64: *size = 8; return "int64_t";
+    case SDL_SHADER_BASETYPE_UINT64: *size = 8; return "uint64_t";
+    case SDL_SHADER_BASETYPE_HALF: *size = 2; return "uint16_t";
+    case SDL_SHADER_BASETYPE_FLOAT: *size = 4; return "float";
+    case SDL_SHADER_BASETYPE_DOUBLE: *size = 8; return "double";
+    default: *size = 1; return "uint8_t";
+  }
+}
+
+// the size a block has to be padded to, array elements are padded to their stride
+static Uint32 padded_size(const SDL_SHADER_Reflection *reflection, Sint32 index)
+{
+  Uint32 size = reflection->blocks[index].size;
+
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    const SDL_SHADER_Block *block = &reflection->blocks[i];
+    for (Uint32 j = 0; j < block->num_members; j++)
+    {
+      const SDL_SHADER_Member *member = &block->members[j];
+      if (member->block == index && member->array_stride > size)
+      {
+        size = member->array_stride;
+      }
+    }
+  }
+
+  return size;
+}
+
+static void write_member(SDL_IOStream *io, const SDL_SHADER_Reflection *reflection, const char *prefix, const SDL_SHADER_Member *member, const char *name)
+{
+  char type[256];
+  Uint32 scalar_size;
+
+  if (member->base_type == SDL_SHADER_BASETYPE_STRUCT)
+  {
+    char block_name[128];
+    identifier(block_name, sizeof(block_name), reflection->blocks[member->block].name, "block", (Uint32)member->block);
+    SDL_snprintf(type, sizeof(type), "%s_%s", prefix, block_name);
+    scalar_size = padded_size(reflection, member->block);
+  }
+  else
+  {
+    SDL_strlcpy(type, scalar_name(member->base_type, &scalar_size), sizeof(type));
+  }
+
+  // columns (or rows when row major) are padded up to the matrix stride
+  Uint32 vectors = member->row_major ? member->vecsize : member->columns;
+  Uint32 element_size;
+  if (member->base_type == SDL_SHADER_BASETYPE_STRUCT)
+  {
+    element_size = scalar_size;
+  }
+  else if (member->columns > 1)
+  {
+    element_size = vectors * member->matrix_stride;
+  }
+  else
+  {
+    element_size = member->vecsize * scalar_size;
+  }
+
+  // array elements are padded up to the array stride
+  if (member->array_size)
+  {
+    Uint32 stride = member->array_stride;
+
+    if (member->columns > 1 || member->base_type == SDL_SHADER_BASETYPE_STRUCT ? stride != element_size : (stride < element_size || stride % scalar_size != 0))
+    {
+      SDL_IOprintf(io, "  uint8_t %s[%u][%u]; // %s elements with a %u byte stride\n", name, member->array_size, stride, type, stride);
+      return;
+    }
+
+    if (member->columns > 1)
+    {
+      SDL_IOprintf(io, "  %s %s[%u][%u][%u];\n", type, name, member->array_size, vectors, member->matrix_stride / scalar_size);
+    }
+    else if (member->base_type == SDL_SHADER_BASETYPE_STRUCT)
+    {
+      SDL_IOprintf(io, "  %s %s[%u];\n", type, name, member->array_size);
+    }
+    else if (stride == scalar_size)
+    {
+      SDL_IOprintf(io, "  %s %s[%u];\n", type, name, member->array_size);
+    }
+    else
+    {
+      SDL_IOprintf(io, "  %s %s[%u][%u];\n", type, name, member->array_size, stride / scalar_size);
+    }
+    return;
+  }
+
+  if (member->columns > 1)
+  {
+    SDL_IOprintf(io, "  %s %s[%u][%u];\n", type, name, vectors, member->matrix_stride / scalar_size);
+  }
+  else if (member->vecsize > 1)
+  {
+    SDL_IOprintf(io, "  %s %s[%u];\n", type, name, member->vecsize);
+  }
+  else
+  {
+    SDL_IOprintf(io, "  %s %s;\n", type, name);
+  }
+}
+
+static void write_block(SDL_IOStream *io, const SDL_SHADER_Reflection *reflection, const char *prefix, Sint32 index, bool *written)
+{
+  if (written[index])
+  {
+    return;
+  }
+  written[index] = true;
+
+  const SDL_SHADER_Block *block = &reflection->blocks[index];
+
+  // nested structs go first
+  for (Uint32 i = 0; i < block->num_members; i++)
+  {
+    if (block->members[i].block >= 0)
+    {
+      write_block(io, reflection, prefix, block->members[i].block, written);
+    }
+  }
+
+  char block_name[128];
+  char struct_name[256];
+  identifier(block_name, sizeof(block_name), block->name, "block", (Uint32)index);
+  SDL_snprintf(struct_name, sizeof(struct_name), "%s_%s", prefix, block_name);
+
+  SDL_IOprintf(io, "typedef struct %s\n{\n", struct_name);
+
+  Uint32 cursor = 0;
+  Uint32 pad = 0;
+  const SDL_SHADER_Member *runtime_array = NULL;
+  bool *emitted = SDL_calloc(block->num_members + 1, sizeof(bool));
+
+  for (Uint32 i = 0; i < block->num_members; i++)
+  {
+    const SDL_SHADER_Member *member = &block->members[i];
+    char member_name[128];
+    identifier(member_name, sizeof(member_name), member->name, "member", i);
+
+    // runtime sized arrays can't be part of a struct, only their offset is kept
+    if (member->runtime_array)
+    {
+      runtime_array = member;
+      continue;
+    }
+
+    if (member->offset < cursor)
+    {
+      SDL_IOprintf(io, "  // %s overlaps the previous member and was skipped\n", member_name);
+      continue;
+    }
+
+    if (member->offset > cursor)
+    {
+      SDL_IOprintf(io, "  uint8_t _pad%u[%u];\n", pad++, member->offset - cursor);
+    }
+
+    write_member(io, reflection, prefix, member, member_name);
+    cursor = member->offset + member->size;
+    emitted[i] = true;
+  }
+
+  Uint32 size = padded_size(reflection, index);
+  if (size > cursor && runtime_array == NULL)
+  {
+    SDL_IOprintf(io, "  uint8_t _pad%u[%u];\n", pad++, size - cursor);
+    cursor = size;
+  }
+
+  // C doesn't allow empty structs
+  if (cursor == 0)
+  {
+    SDL_IOprintf(io, "  uint8_t _unused;\n");
+  }
+
+  SDL_IOprintf(io, "} %s;\n\n", struct_name);
+
+  // layout checks
+  for (Uint32 i = 0; i < block->num_members; i++)
+  {
+    const SDL_SHADER_Member *member = &block->members[i];
+    char member_name[128];
+    identifier(member_name, sizeof(member_name), member->name, "member", i);
+
+    if (emitted[i])
+    {
+      SDL_IOprintf(io, "SDL_SHADER_LAYOUT_ASSERT(offsetof(%s, %s) == %u);\n", struct_name, member_name, member->offset);
+    }
+    else if (member->runtime_array)
+    {
+      SDL_IOprintf(io, "#define %s_%s_OFFSET %u\n", struct_name, member_name, member->offset);
+      SDL_IOprintf(io, "#define %s_%s_STRIDE %u\n", struct_name, member_name, member->array_stride);
+    }
+  }
+
+  SDL_free(emitted);
+
+  if (runtime_array == NULL)
+  {
+    SDL_IOprintf(io, "SDL_SHADER_LAYOUT_ASSERT(sizeof(%s) == %u);\n", struct_name, size);
+  }
+
+  SDL_IOprintf(io, "\n");
+}
+
+char *codegen_header(const SDL_SHADER_Reflection *reflection, const char *prefix, size_t *size)
+{
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  if (io == NULL)
+  {
+    return NULL;
+  }
+
+  char name[128];
+  identifier(name, sizeof(name), prefix, "shader", 0);
+
+  SDL_IOprintf(io, "// generated by sdlshader, do not edit.\n");
+  SDL_IOprintf(io, "#pragma once\n\n");
+  SDL_IOprintf(io, "#include <stddef.h>\n");
+  SDL_IOprintf(io, "#include <stdint.h>\n\n");
+  SDL_IOprintf(io, "#ifndef SDL_SHADER_LAYOUT_ASSERT\n");
+  SDL_IOprintf(io, "#ifdef __cplusplus\n");
+  SDL_IOprintf(io, "#define SDL_SHADER_LAYOUT_ASSERT(x) static_assert(x, #x)\n");
+  SDL_IOprintf(io, "#else\n");
+  SDL_IOprintf(io, "#define SDL_SHADER_LAYOUT_ASSERT(x) _Static_assert(x, #x)\n");
+  SDL_IOprintf(io, "#endif\n");
+  SDL_IOprintf(io, "#endif\n\n");
+
+  // resource slots, set and binding are the SPIR-V ones, the slot is what SDL_gpu binds to
+  for (Uint32 i = 0; i < reflection->num_resources; i++)
+  {
+    const SDL_SHADER_Resource *resource = &reflection->resources[i];
+    char resource_name[128];
+    identifier(resource_name, sizeof(resource_name), resource->name, "resource", i);
+    SDL_IOprintf(io, "#define %s_%s_SET %u\n", name, resource_name, resource->set);
+    SDL_IOprintf(io, "#define %s_%s_BINDING %u\n", name, resource_name, resource->binding);
+    SDL_IOprintf(io, "#define %s_%s_SLOT %u\n", name, resource_name, resource->slot);
+  }
+
+  if (reflection->num_resources > 0)
+  {
+    SDL_IOprintf(io, "\n");
+  }
+
+  bool *written = SDL_calloc(reflection->num_blocks + 1, sizeof(bool));
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    write_block(io, reflection, name, (Sint32)i, written);
+  }
+  SDL_free(written);
+
+  return take_text(io, size);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <SDL_shader/SDL_shader.h>
+
+// generates a C/C++ header with a struct for every reflected block.
+// structs are named <prefix>_<block>, padding is explicit and every offset is statically asserted.
+char *codegen_header(const SDL_SHADER_Reflection *reflection, const char *prefix, size_t *size);
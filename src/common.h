@@ -9,6 +9,10 @@ enum
   SDL_SHADER_TYPE_COMPUTE
 };
 
+// code entries with this format hold the reflection section instead of shader code.
+// no device supports it, so loaders that don't know about it skip it.
+#define SDL_SHADER_SECTION_REFLECTION (1u << 31)
+
 struct SDL_SHADER_Code
 {
   size_t code_size;
@@ -0,0 +1,966 @@
+#include "compile.h"
+#include "cache.h"
+#include "hash.h"
+#include "link.h"
+#include "memory.h"
+#include "reflection.h"
+#include "specialize.h"
+#include "spirv.h"
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_endian.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+#include <shaderc/shaderc.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+
+// shared by every compile instead of starting a new compiler per shader
+static shaderc_compiler_t compiler;
+
+// errors of the current thread are collected here while capturing
+static SDL_TLSID capture;
+
+// folder of cached front-end results, NULL when not caching
+static char *cache_folder;
+
+// errors printed so far, captured ones belong to whoever captures them
+static SDL_AtomicInt failures;
+
+bool compile_init(void)
+{
+  if (!SDL_ShaderCross_Init())
+  {
+    return false;
+  }
+
+  compiler = shaderc_compiler_initialize();
+  return compiler != NULL;
+}
+
+void compile_quit(void)
+{
+  shaderc_compiler_release(compiler);
+  compiler = NULL;
+  SDL_ShaderCross_Quit();
+
+  SDL_free(cache_folder);
+  cache_folder = NULL;
+}
+
+void compile_versions(Uint32 versions[COMPILE_NUM_VERSIONS])
+{
+  SDL_memset(versions, 0, COMPILE_NUM_VERSIONS * sizeof(Uint32));
+
+#ifdef SDL_SHADERCROSS_MAJOR_VERSION
+  versions[0] = SDL_SHADERCROSS_MAJOR_VERSION;
+  versions[1] = SDL_SHADERCROSS_MINOR_VERSION;
+  versions[2] = SDL_SHADERCROSS_MICRO_VERSION;
+#endif
+
+  unsigned int spv_version = 0;
+  unsigned int spv_revision = 0;
+  shaderc_get_spv_version(&spv_version, &spv_revision);
+  versions[3] = spv_version;
+  versions[4] = spv_revision;
+}
+
+void compile_cache(const char *folder)
+{
+  SDL_free(cache_folder);
+  cache_folder = folder != NULL ? SDL_strdup(folder) : NULL;
+}
+
+static void compile_message(bool failure, const char *fmt, va_list args)
+{
+  char **text = SDL_GetTLS(&capture);
+  if (text == NULL)
+  {
+    vprintf(fmt, args);
+
+    if (failure)
+    {
+      SDL_AtomicIncRef(&failures);
+    }
+  }
+  else
+  {
+    char *message;
+    if (SDL_vasprintf(&message, fmt, args) >= 0)
+    {
+      char *joined;
+      if (SDL_asprintf(&joined, "%s%s", *text != NULL ? *text : "", message) >= 0)
+      {
+        SDL_free(*text);
+        *text = joined;
+      }
+
+      SDL_free(message);
+    }
+  }
+}
+
+void compile_error(const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  compile_message(true, fmt, args);
+  va_end(args);
+}
+
+void compile_warning(const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  compile_message(false, fmt, args);
+  va_end(args);
+}
+
+int compile_failures(void)
+{
+  return SDL_GetAtomicInt(&failures);
+}
+
+void compile_capture_begin(char **text)
+{
+  *text = NULL;
+  SDL_SetTLS(&capture, text, NULL);
+}
+
+void compile_capture_end(void)
+{
+  SDL_SetTLS(&capture, NULL, NULL);
+}
+
+Uint8 *write_le32(Uint8 *dst, Uint32 value)
+{
+  Uint32 tmp = SDL_Swap32LE(value);
+  SDL_memcpy(dst, &tmp, sizeof(Uint32));
+  return dst + sizeof(Uint32);
+}
+
+Uint8 *write_le64(Uint8 *dst, Uint64 value)
+{
+  Uint64 tmp = SDL_Swap64LE(value);
+  SDL_memcpy(dst, &tmp, sizeof(Uint64));
+  return dst + sizeof(Uint64);
+}
+
+// the fixed part of the header followed by the entry name
+static bool write_header(struct SDL_SHADER_Encoder *encoder)
+{
+  struct SDL_SHADER_Blob *blob = &encoder->blob;
+  Uint8 header[13 * sizeof(Uint32)];
+
+  Uint8* p = header;
+  p = write_le32(p, blob->formats);
+  p = write_le32(p, blob->type);
+  p = write_le32(p, blob->num_samplers);
+  p = write_le32(p, blob->num_uniform_buffers);
+  p = write_le32(p, blob->num_storage_buffers);
+  p = write_le32(p, blob->num_storage_textures);
+
+  if (blob->type == SDL_SHADER_TYPE_COMPUTE)
+  {
+    p = write_le32(p, blob->num_storage_buffers_readonly);
+    p = write_le32(p, blob->num_storage_textures_readonly);
+    p = write_le32(p, blob->thread_x);
+    p = write_le32(p, blob->thread_y);
+    p = write_le32(p, blob->thread_z);
+  }
+
+  p = write_le32(p, blob->num_shaders);
+  p = write_le32(p, blob->entry_size);
+
+  size_t header_size = (size_t)(p - header);
+  return SDL_WriteIO(encoder->io, header, header_size) == header_size
+      && SDL_WriteIO(encoder->io, blob->entry, blob->entry_size) == blob->entry_size;
+}
+
+bool encode_begin(struct SDL_SHADER_Encoder *encoder, SDL_IOStream *io, const struct SDL_SHADER_Blob *blob)
+{
+  encoder->io = io;
+  encoder->blob = *blob;
+  encoder->blob.num_shaders = 0;
+  encoder->blob.shaders = NULL;
+  encoder->start = SDL_TellIO(io);
+
+  return encoder->start >= 0 && write_header(encoder);
+}
+
+bool encode_put(struct SDL_SHADER_Encoder *encoder, SDL_GPUShaderFormat format, const void *code, size_t code_size)
+{
+  Uint8 entry[sizeof(Uint32) + sizeof(Uint64)];
+  write_le64(write_le32(entry, format), code_size);
+
+  if (SDL_WriteIO(encoder->io, entry, sizeof(entry)) != sizeof(entry) || (code_size > 0 && SDL_WriteIO(encoder->io, code, code_size) != code_size))
+  {
+    return false;
+  }
+
+  encoder->blob.num_shaders++;
+  return true;
+}
+
+bool encode_end(struct SDL_SHADER_Encoder *encoder)
+{
+  Sint64 end = SDL_TellIO(encoder->io);
+
+  return end >= 0
+      && SDL_SeekIO(encoder->io, encoder->start, SDL_IO_SEEK_SET) >= 0
+      && write_header(encoder)
+      && SDL_SeekIO(encoder->io, end, SDL_IO_SEEK_SET) >= 0;
+}
+
+void* take_memory(SDL_IOStream *io, size_t *size)
+{
+  *size = (size_t)SDL_GetIOSize(io);
+
+  SDL_PropertiesID props = SDL_GetIOProperties(io);
+  void* memory = SDL_GetPointerProperty(props, SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL);
+  SDL_SetPointerProperty(props, SDL_PROP_IOSTREAM_DYNAMIC_MEMORY_POINTER, NULL);
+
+  SDL_CloseIO(io);
+  return memory;
+}
+
+char* take_text(SDL_IOStream *io, size_t *size)
+{
+  // the terminator goes into the stream too, so the memory can be handed out as it is
+  if (SDL_WriteIO(io, "", 1) != 1)
+  {
+    SDL_CloseIO(io);
+    return NULL;
+  }
+
+  size_t text_size;
+  char* text = take_memory(io, &text_size);
+
+  if (size != NULL)
+  {
+    *size = text_size - 1;
+  }
+
+  return text;
+}
+
+void* encode(struct SDL_SHADER_Blob *blob, size_t *size)
+{
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_ENCODE);
+
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  struct SDL_SHADER_Encoder encoder;
+  bool encoded = io != NULL && encode_begin(&encoder, io, blob);
+
+  for (Uint32 i = 0; encoded && i < blob->num_shaders; i++)
+  {
+    encoded = encode_put(&encoder, blob->shaders[i]->format, blob->shaders[i]->code, blob->shaders[i]->code_size);
+  }
+
+  void* bin = NULL;
+  if (encoded && encode_end(&encoder))
+  {
+    bin = take_memory(io, size);
+  }
+  else if (io != NULL)
+  {
+    SDL_CloseIO(io);
+  }
+
+  memory_stage(stage);
+  return bin;
+}
+
+const Uint8 *read_le32(const Uint8 *src, Uint32 *value)
+{
+  Uint32 tmp;
+  SDL_memcpy(&tmp, src, sizeof(Uint32));
+  *value = SDL_Swap32LE(tmp);
+  return src + sizeof(Uint32);
+}
+
+const Uint8 *read_le64(const Uint8 *src, Uint64 *value)
+{
+  Uint64 tmp;
+  SDL_memcpy(&tmp, src, sizeof(Uint64));
+  *value = SDL_Swap64LE(tmp);
+  return src + sizeof(Uint64);
+}
+
+bool decode(const void *data, size_t size, struct SDL_SHADER_Blob *blob)
+{
+  const Uint8 *p = data;
+  const Uint8 *end = p + size;
+
+  SDL_zerop(blob);
+
+  if (size < 2 * sizeof(Uint32))
+  {
+    return false;
+  }
+
+  p = read_le32(p, &blob->formats);
+  p = read_le32(p, &blob->type);
+
+  // the compute header has five extra fields
+  size_t fields = blob->type == SDL_SHADER_TYPE_COMPUTE ? 11 : 6;
+  if (blob->type > SDL_SHADER_TYPE_COMPUTE || (size_t)(end - p) < fields * sizeof(Uint32))
+  {
+    return false;
+  }
+
+  p = read_le32(p, &blob->num_samplers);
+  p = read_le32(p, &blob->num_uniform_buffers);
+  p = read_le32(p, &blob->num_storage_buffers);
+  p = read_le32(p, &blob->num_storage_textures);
+
+  if (blob->type == SDL_SHADER_TYPE_COMPUTE)
+  {
+    p = read_le32(p, &blob->num_storage_buffers_readonly);
+    p = read_le32(p, &blob->num_storage_textures_readonly);
+    p = read_le32(p, &blob->thread_x);
+    p = read_le32(p, &blob->thread_y);
+    p = read_le32(p, &blob->thread_z);
+  }
+
+  Uint32 num_shaders;
+  p = read_le32(p, &num_shaders);
+  p = read_le32(p, &blob->entry_size);
+
+  if (blob->entry_size == 0 || blob->entry_size > (size_t)(end - p) || p[blob->entry_size - 1] != '\0')
+  {
+    return false;
+  }
+
+  blob->entry = (char*)p;
+  p += blob->entry_size;
+
+  // every entry takes at least its format and size, which bounds the count before allocating
+  if (num_shaders > (size_t)(end - p) / (sizeof(Uint32) + sizeof(Uint64)))
+  {
+    return false;
+  }
+
+  // the pointers and the codes they point to share one allocation
+  struct SDL_SHADER_Code **shaders = SDL_malloc((num_shaders ? num_shaders : 1) * (sizeof(void*) + sizeof(struct SDL_SHADER_Code)));
+  struct SDL_SHADER_Code *codes = (struct SDL_SHADER_Code*)&shaders[num_shaders];
+
+  for (Uint32 i = 0; i < num_shaders; i++)
+  {
+    Uint32 format;
+    Uint64 code_size;
+
+    if ((size_t)(end - p) < sizeof(Uint32) + sizeof(Uint64))
+    {
+      SDL_free(shaders);
+      return false;
+    }
+
+    p = read_le32(p, &format);
+    p = read_le64(p, &code_size);
+
+    if (code_size > (Uint64)(end - p))
+    {
+      SDL_free(shaders);
+      return false;
+    }
+
+    codes[i].format = format;
+    codes[i].code_size = code_size;
+    codes[i].code = (void*)p;
+    shaders[i] = &codes[i];
+    p += code_size;
+  }
+
+  blob->num_shaders = num_shaders;
+  blob->shaders = shaders;
+  return true;
+}
+
+// convert the shader type to the stage used SDL_Shadercross
+static SDL_ShaderCross_ShaderStage shadercross_stage(SDL_SHADER_Type type)
+{
+  if (type == SDL_SHADER_TYPE_VERTEX)
+  {
+    return SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+  }
+  else if (type == SDL_SHADER_TYPE_FRAGMENT)
+  {
+    return SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+  }
+
+  return SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+}
+
+static shaderc_shader_kind shaderc_kind(SDL_SHADER_Type type)
+{
+  if (type == SDL_SHADER_TYPE_VERTEX)
+  {
+    return shaderc_glsl_vertex_shader;
+  }
+  else if (type == SDL_SHADER_TYPE_FRAGMENT)
+  {
+    return shaderc_glsl_fragment_shader;
+  }
+
+  return shaderc_glsl_compute_shader;
+}
+
+static shaderc_compile_options_t glsl_options(const struct SDL_SHADER_Settings *settings, bool defines)
+{
+  shaderc_compile_options_t options = shaderc_compile_options_initialize();
+
+  for (size_t i = 0; defines && i < settings->defines->size; i++)
+  {
+    char* define = vector_get(settings->defines, i);
+    char* value = SDL_strchr(define, '=');
+
+    if (value == NULL)
+    {
+      shaderc_compile_options_add_macro_definition(options, define, SDL_strlen(define), NULL, 0);
+    }
+    else
+    {
+      shaderc_compile_options_add_macro_definition(options, define, value - define, value + 1, SDL_strlen(value + 1));
+    }
+  }
+
+  return options;
+}
+
+// runs the GLSL preprocessor once, so several entry points can skip it
+static char* preprocess_glsl(void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entry, size_t *size)
+{
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_FRONTEND);
+
+  shaderc_compile_options_t options = glsl_options(settings, true);
+  shaderc_compilation_result_t result = shaderc_compile_into_preprocessed_text(compiler, code, code_size, shaderc_kind(entry->type), settings->filename, entry->name, options);
+
+  char* text = NULL;
+  if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success)
+  {
+    compile_error("ERROR: GLSL: %s\n", shaderc_result_get_error_message(result));
+  }
+  else
+  {
+    *size = shaderc_result_get_length(result);
+    text = SDL_malloc(*size);
+    SDL_memcpy(text, shaderc_result_get_bytes(result), *size);
+  }
+
+  shaderc_result_release(result);
+  shaderc_compile_options_release(options);
+
+  memory_stage(stage);
+  return text;
+}
+
+// front-end, turns the source of one entry point into spirv. preprocessed GLSL already has the defines applied
+// the back-ends and reflection trust the module, so at least make sure it is one
+static bool is_spirv(const void* code, size_t code_size)
+{
+  Uint32 magic = 0;
+  if (code_size >= SPIRV_HEADER_WORDS * 4 && code_size % 4 == 0)
+  {
+    read_le32(code, &magic);
+  }
+
+  return magic == SPIRV_MAGIC;
+}
+
+static void* compile_spirv(void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entry, bool preprocessed, size_t *spirv_size)
+{
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_FRONTEND);
+
+  void* spirv = NULL;
+  *spirv_size = 0;
+
+  if (settings->lang == SDL_SHADER_LANG_GLSL)
+  {
+    // compile GLSL to SPIRV
+    shaderc_compile_options_t options = glsl_options(settings, !preprocessed);
+    shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, code, code_size, shaderc_kind(entry->type), settings->filename, entry->name, options);
+
+    if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success) 
+    {
+      compile_error("ERROR: GLSL: %s\n", shaderc_result_get_error_message(result));
+    }
+    else
+    {
+      *spirv_size = shaderc_result_get_length(result);
+      spirv = SDL_malloc(*spirv_size);
+      SDL_memcpy(spirv, (uint8_t*)shaderc_result_get_bytes(result), *spirv_size);
+    }
+
+    shaderc_result_release(result);
+    shaderc_compile_options_release(options);
+  }
+  else if (settings->lang == SDL_SHADER_LANG_HLSL)
+  {
+    // the define list ends with an empty entry
+    size_t num_defines = settings->defines->size;
+    SDL_ShaderCross_HLSL_Define* defines = SDL_calloc(num_defines + 1, sizeof(SDL_ShaderCross_HLSL_Define));
+
+    for (size_t i = 0; i < num_defines; i++)
+    {
+      char* define = vector_get(settings->defines, i);
+      char* value = SDL_strchr(define, '=');
+
+      if (value == NULL)
+      {
+        defines[i].name = SDL_strdup(define);
+      }
+      else
+      {
+        defines[i].name = SDL_strndup(define, value - define);
+        defines[i].value = SDL_strdup(value + 1);
+      }
+    }
+
+    // compile HLSL to SPIRV
+    SDL_ShaderCross_HLSL_Info hlsl_info = {0};
+    hlsl_info.source = code;
+    hlsl_info.entrypoint = entry->name;
+    hlsl_info.shader_stage = shadercross_stage(entry->type);
+    hlsl_info.defines = defines;
+    hlsl_info.include_dir = NULL;
+    hlsl_info.props = 0;
+   
+    spirv = SDL_ShaderCross_CompileSPIRVFromHLSL(&hlsl_info, spirv_size);
+  
+    if (spirv == NULL)
+    {
+      compile_error("ERROR: HLSL: %s\n",  SDL_GetError());
+    }
+
+    for (size_t i = 0; i < num_defines; i++)
+    {
+      SDL_free(defines[i].name);
+      SDL_free(defines[i].value);
+    }
+
+    SDL_free(defines);
+  }
+  else if (!is_spirv(code, code_size))
+  {
+    compile_error("ERROR: \"%s\" is not SPIR-V.\n", settings->filename);
+  }
+  else
+  {
+    spirv = SDL_malloc(code_size);
+    SDL_memcpy(spirv, code, code_size);
+    *spirv_size = code_size;
+  }
+
+  memory_stage(stage);
+  return spirv;
+}
+
+// bump when the options or the cache format change, the compiler versions are in the key already
+#define CACHE_VERSION 1
+
+// everything the spirv of an entry depends on, the file name only shows up in errors
+static void spirv_key(const void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entry, Uint8 key[HASH_SIZE])
+{
+  // the spirv changes with the compilers, an update must not pick up what the old ones made
+  Uint32 versions[COMPILE_NUM_VERSIONS];
+  compile_versions(versions);
+
+  struct Hash hash;
+  hash_begin(&hash);
+  hash_update_le32(&hash, CACHE_VERSION);
+  for (int i = 0; i < COMPILE_NUM_VERSIONS; i++)
+  {
+    hash_update_le32(&hash, versions[i]);
+  }
+
+  hash_update_le32(&hash, settings->lang);
+  hash_update_le32(&hash, entry->type);
+  hash_update_string(&hash, entry->name);
+
+  hash_update_le32(&hash, settings->defines->size);
+  for (size_t i = 0; i < settings->defines->size; i++)
+  {
+    hash_update_string(&hash, vector_get(settings->defines, i));
+  }
+
+  hash_update(&hash, code, code_size);
+  hash_end(&hash, key);
+}
+
+// compile_spirv through the cache, the key comes from the original code even when the source was preprocessed
+static void* cached_spirv(void* code, size_t code_size, void* source, size_t source_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entry, bool preprocessed, size_t *spirv_size)
+{
+  // spirv inputs have no front-end to skip
+  if (cache_folder == NULL || settings->lang == SDL_SHADER_LANG_SPIRV)
+  {
+    return compile_spirv(source, source_size, settings, entry, preprocessed, spirv_size);
+  }
+
+  Uint8 key[HASH_SIZE];
+  spirv_key(code, code_size, settings, entry, key);
+
+  // anything that isn't a spirv module is a broken entry and gets compiled again
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  void* spirv = cache_load(cache_folder, key, spirv_size);
+  memory_stage(stage);
+
+  if (spirv != NULL && is_spirv(spirv, *spirv_size))
+  {
+    return spirv;
+  }
+
+  SDL_free(spirv);
+
+  spirv = compile_spirv(source, source_size, settings, entry, preprocessed, spirv_size);
+
+  stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  if (spirv != NULL && !cache_store(cache_folder, key, spirv, *spirv_size))
+  {
+    compile_warning("WARNING: could not cache \"%s\": %s\n", settings->filename, SDL_GetError());
+  }
+  memory_stage(stage);
+
+  return spirv;
+}
+
+// bakes the spec constants of the settings into the spirv, which is replaced unless it is the caller's code
+static void* specialize_spirv(void* spirv, const void* code, const struct SDL_SHADER_Settings *settings, size_t *spirv_size)
+{
+  if (spirv == NULL || settings->constants == NULL || settings->constants->size == 0)
+  {
+    return spirv;
+  }
+
+  size_t size = 0;
+  void* specialized = spirv_specialize(spirv, *spirv_size, settings->constants, &size);
+
+  if (specialized == NULL)
+  {
+    compile_error("ERROR: could not specialize \"%s\": %s\n", settings->filename, SDL_GetError());
+  }
+
+  if (spirv != code)
+  {
+    SDL_free(spirv);
+  }
+
+  *spirv_size = size;
+  return specialized;
+}
+
+// appends the code of a back-end to the blob and frees it, a failed back-end only loses its format
+static bool put_code(struct SDL_SHADER_Encoder *encoder, SDL_GPUShaderFormat format, const char *name, void *code, size_t code_size)
+{
+  if (code == NULL)
+  {
+    compile_error("ERROR: %s: %s\n", name, SDL_GetError());
+    return true;
+  }
+
+  bool encoded = encode_put(encoder, format, code, code_size);
+  encoder->blob.formats |= format;
+  SDL_free(code);
+  return encoded;
+}
+
+// back-end, cross compiles the spirv of one entry point into every format and encodes the blob. the spirv stays with the caller
+static void* compile_backend(void* spirv, size_t spirv_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entry, SDL_SHADER_Reflection **reflection, size_t *size)
+{
+  SDL_SHADER_Type type = entry->type;
+  SDL_GPUShaderFormat formats = settings->formats;
+  bool reflect = settings->reflect;
+
+  struct SDL_SHADER_Blob blob = {0};
+  blob.type = type;
+  blob.entry_size = SDL_strlen(entry->name) + 1; // the 1 is for \0
+  blob.entry = entry->name;
+  blob.formats = 0; // filled in as the back-ends succeed
+
+  // shader info
+  SDL_ShaderCross_SPIRV_Info spirv_info = {0};
+  spirv_info.shader_stage = shadercross_stage(type);
+  spirv_info.bytecode = spirv;
+  spirv_info.bytecode_size = spirv_size;
+  spirv_info.entrypoint = entry->name;
+
+  // reflection
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_REFLECTION);
+  if (type == SDL_SHADER_TYPE_COMPUTE)
+  {
+    SDL_ShaderCross_ComputePipelineMetadata* metadata = SDL_ShaderCross_ReflectComputeSPIRV(spirv, spirv_size, 0);
+    if (metadata == NULL)
+    {
+      compile_error("ERROR: could not reflect \"%s\": %s\n", settings->filename, SDL_GetError());
+      memory_stage(stage);
+      return NULL;
+    }
+
+    blob.num_samplers = metadata->num_samplers;
+    blob.num_uniform_buffers = metadata->num_uniform_buffers;
+    blob.num_storage_buffers = metadata->num_readwrite_storage_buffers;
+    blob.num_storage_textures = metadata->num_readwrite_storage_textures;
+    blob.num_storage_buffers_readonly = metadata->num_readonly_storage_buffers;
+    blob.num_storage_textures_readonly = metadata->num_readonly_storage_textures;
+    blob.thread_x = metadata->threadcount_x;
+    blob.thread_y = metadata->threadcount_y;
+    blob.thread_z = metadata->threadcount_z;
+
+    // shadercross only reads the LocalSize literals and misses a size made of spec constants
+    Uint32 threads[3];
+    if (spirv_workgroup_size(spirv, spirv_size, threads))
+    {
+      blob.thread_x = threads[0];
+      blob.thread_y = threads[1];
+      blob.thread_z = threads[2];
+    }
+
+    SDL_free(metadata);
+  }
+  else
+  {
+    SDL_ShaderCross_GraphicsShaderMetadata* metadata = SDL_ShaderCross_ReflectGraphicsSPIRV(spirv, spirv_size, 0);
+    if (metadata == NULL)
+    {
+      compile_error("ERROR: could not reflect \"%s\": %s\n", settings->filename, SDL_GetError());
+      memory_stage(stage);
+      return NULL;
+    }
+
+    blob.num_samplers = metadata->resource_info.num_samplers;
+    blob.num_uniform_buffers = metadata->resource_info.num_uniform_buffers;
+    blob.num_storage_buffers = metadata->resource_info.num_storage_buffers;
+    blob.num_storage_textures = metadata->resource_info.num_storage_textures;
+   
+    SDL_free(metadata);
+  }
+
+  // every back-end goes into the blob as soon as it is done, so only one of them is held at a time
+  memory_stage(SDL_SHADER_MEMORY_ENCODE);
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  struct SDL_SHADER_Encoder encoder;
+  bool encoded = io != NULL && encode_begin(&encoder, io, &blob);
+
+  // DXIL
+  if (encoded && (formats & SDL_GPU_SHADERFORMAT_DXIL))
+  {
+    size_t code_size = 0;
+    memory_stage(SDL_SHADER_MEMORY_DXIL);
+    void* code = SDL_ShaderCross_CompileDXILFromSPIRV(&spirv_info, &code_size);
+    memory_stage(SDL_SHADER_MEMORY_ENCODE);
+    encoded = put_code(&encoder, SDL_GPU_SHADERFORMAT_DXIL, "DXIL", code, code_size);
+  }
+
+  // DXBC
+  if (encoded && (formats & SDL_GPU_SHADERFORMAT_DXBC))
+  {
+    size_t code_size = 0;
+    memory_stage(SDL_SHADER_MEMORY_DXBC);
+    void* code = SDL_ShaderCross_CompileDXBCFromSPIRV(&spirv_info, &code_size);
+    memory_stage(SDL_SHADER_MEMORY_ENCODE);
+    encoded = put_code(&encoder, SDL_GPU_SHADERFORMAT_DXBC, "DXBC", code, code_size);
+  }
+
+  // MSL
+  if (encoded && (formats & SDL_GPU_SHADERFORMAT_MSL))
+  {
+    memory_stage(SDL_SHADER_MEMORY_MSL);
+    char* code = SDL_ShaderCross_TranspileMSLFromSPIRV(&spirv_info);
+    memory_stage(SDL_SHADER_MEMORY_ENCODE);
+    encoded = put_code(&encoder, SDL_GPU_SHADERFORMAT_MSL, "MSL", code, code != NULL ? SDL_strlen(code) + 1 : 0);
+  }
+
+  // SPIRV, it belongs to the caller
+  if (encoded && (formats & SDL_GPU_SHADERFORMAT_SPIRV))
+  {
+    encoded = encode_put(&encoder, SDL_GPU_SHADERFORMAT_SPIRV, spirv, spirv_size);
+    encoder.blob.formats |= SDL_GPU_SHADERFORMAT_SPIRV;
+  }
+
+  // reflection section, it comes after all the code so loaders can stop early
+  if (encoded && (reflect || reflection != NULL))
+  {
+    memory_stage(SDL_SHADER_MEMORY_REFLECTION);
+
+    struct SPIRV_Module module;
+    if (spirv_parse(&module, spirv_info.bytecode, spirv_info.bytecode_size))
+    {
+      SDL_SHADER_Reflection *resources = spirv_reflect(&module);
+
+      if (reflect)
+      {
+        size_t section_size;
+        Uint8 *section = reflection_encode(resources, &section_size);
+
+        memory_stage(SDL_SHADER_MEMORY_ENCODE);
+        encoded = encode_put(&encoder, SDL_SHADER_SECTION_REFLECTION, section, section_size);
+        memory_stage(SDL_SHADER_MEMORY_REFLECTION);
+
+        SDL_free(section);
+      }
+
+      // the names point into the module, so hand out a copy that owns them
+      if (reflection != NULL)
+      {
+        size_t section_size;
+        Uint8 *section = reflection_encode(resources, &section_size);
+        *reflection = reflection_decode(section, section_size);
+        SDL_free(section);
+      }
+
+      reflection_free(resources);
+      spirv_free(&module);
+    }
+    else
+    {
+      compile_error("ERROR: reflection: %s\n", SDL_GetError());
+    }
+  }
+
+  // the header goes out again with the formats that compiled
+  memory_stage(SDL_SHADER_MEMORY_ENCODE);
+
+  void* bin = NULL;
+  if (encoded && encode_end(&encoder))
+  {
+    bin = take_memory(io, size);
+  }
+  else
+  {
+    compile_error("ERROR: could not encode \"%s\": %s\n", settings->filename, SDL_GetError());
+
+    if (io != NULL)
+    {
+      SDL_CloseIO(io);
+    }
+  }
+
+  memory_stage(stage);
+  return bin;
+}
+
+bool compile_entries(void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entries, int num_entries, SDL_SHADER_Reflection **reflections, void **bins, size_t *sizes)
+{
+  bool success = true;
+
+  // GLSL only knows main, so every entry shares the preprocessed source and just picks a stage
+  void* source = code;
+  size_t source_size = code_size;
+  bool preprocessed = false;
+
+  if (settings->lang == SDL_SHADER_LANG_GLSL && num_entries > 1)
+  {
+    source = preprocess_glsl(code, code_size, settings, &entries[0], &source_size);
+    preprocessed = source != NULL;
+  }
+
+  // spirv inputs skip compile_spirv, so they are checked here once for every entry
+  bool valid = settings->lang != SDL_SHADER_LANG_SPIRV || is_spirv(code, code_size);
+  if (!valid)
+  {
+    compile_error("ERROR: \"%s\" is not SPIR-V.\n", settings->filename);
+  }
+
+  for (int i = 0; i < num_entries; i++)
+  {
+    bins[i] = NULL;
+    sizes[i] = 0;
+
+    if (reflections != NULL)
+    {
+      reflections[i] = NULL;
+    }
+
+    if (source == NULL || !valid)
+    {
+      success = false;
+      continue;
+    }
+
+    // a spirv module can hold several entry points, all of them cross compile from the same one
+    size_t spirv_size = code_size;
+    void* spirv = code;
+
+    if (settings->lang != SDL_SHADER_LANG_SPIRV)
+    {
+      spirv = cached_spirv(code, code_size, source, source_size, settings, &entries[i], preprocessed, &spirv_size);
+    }
+
+    // after the cache, so every set of constants shares one front-end pass
+    spirv = specialize_spirv(spirv, code, settings, &spirv_size);
+
+    // failed to compile spirv
+    if (spirv == NULL)
+    {
+      success = false;
+      continue;
+    }
+
+    bins[i] = compile_backend(spirv, spirv_size, settings, &entries[i], reflections != NULL ? &reflections[i] : NULL, &sizes[i]);
+
+    if (spirv != code)
+    {
+      SDL_free(spirv);
+    }
+  }
+
+  if (preprocessed)
+  {
+    SDL_free(source);
+  }
+
+  return success;
+}
+
+bool compile_linked(void* codes[2], size_t code_sizes[2], const struct SDL_SHADER_Settings *settings[2], SDL_SHADER_Reflection **reflections, void **bins, size_t *sizes)
+{
+  void* spirv[2];
+  size_t spirv_sizes[2];
+  struct SDL_SHADER_Entry entries[2];
+
+  for (int i = 0; i < 2; i++)
+  {
+    entries[i].name = settings[i]->entry;
+    entries[i].type = settings[i]->type;
+    spirv[i] = cached_spirv(codes[i], code_sizes[i], codes[i], code_sizes[i], settings[i], &entries[i], false, &spirv_sizes[i]);
+    spirv[i] = specialize_spirv(spirv[i], NULL, settings[i], &spirv_sizes[i]);
+  }
+
+  // unlinked shaders still work, they just keep their unused varyings
+  if (spirv[0] != NULL && spirv[1] != NULL && !spirv_link(&spirv[0], &spirv_sizes[0], &spirv[1], &spirv_sizes[1]))
+  {
+    compile_warning("WARNING: could not link \"%s\" with \"%s\": %s\n", settings[0]->filename, settings[1]->filename, SDL_GetError());
+  }
+
+  bool success = true;
+  for (int i = 0; i < 2; i++)
+  {
+    bins[i] = NULL;
+    sizes[i] = 0;
+
+    if (reflections != NULL)
+    {
+      reflections[i] = NULL;
+    }
+
+    if (spirv[i] != NULL)
+    {
+      bins[i] = compile_backend(spirv[i], spirv_sizes[i], settings[i], &entries[i], reflections != NULL ? &reflections[i] : NULL, &sizes[i]);
+      SDL_free(spirv[i]);
+    }
+
+    success &= bins[i] != NULL;
+  }
+
+  return success;
+}
+
+void* compile(void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size)
+{
+  struct SDL_SHADER_Entry entry = { settings->entry, settings->type };
+
+  void* bin;
+  compile_entries(code, code_size, settings, &entry, 1, reflection, &bin, size);
+  return bin;
+}
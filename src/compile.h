@@ -0,0 +1,112 @@
+#pragma once
+#include "common.h"
+#include "vector.h"
+
+#include <SDL_shader/SDL_shader.h>
+
+typedef uint32_t SDL_SHADER_Lang;
+enum {
+  SDL_SHADER_LANG_UNKNOWN,
+  SDL_SHADER_LANG_GLSL,
+  SDL_SHADER_LANG_SPIRV,
+  SDL_SHADER_LANG_HLSL
+};
+
+// everything a single compile needs
+struct SDL_SHADER_Settings
+{
+  SDL_SHADER_Type type;
+  SDL_SHADER_Lang lang;
+  SDL_GPUShaderFormat formats;
+  char *entry;
+  char *filename;
+  struct Vector *defines; // "NAME" or "NAME=VALUE"
+  struct Vector *constants; // "ID=VALUE" or "NAME=VALUE" spec constants to bake, may be NULL
+  bool reflect;
+};
+
+// one entry point of a source, a source can hold several
+struct SDL_SHADER_Entry
+{
+  char *name;
+  SDL_SHADER_Type type;
+};
+
+#define SDL_SHADER_MAX_ENTRIES 16
+
+// starts the compilers once for every compile that follows
+bool compile_init(void);
+void compile_quit(void);
+
+// the versions of shadercross and shaderc, builds only match between the same ones
+#define COMPILE_NUM_VERSIONS 5
+void compile_versions(Uint32 versions[COMPILE_NUM_VERSIONS]);
+
+// keeps the spirv of every front-end pass in the folder and reuses it, so only the back-ends
+// run when the source and defines are unchanged. NULL turns it off, see cache.h
+void compile_cache(const char *folder);
+
+// prints an error, or collects it when the calling thread is capturing
+void compile_error(const char *fmt, ...);
+
+// the same for messages that don't fail the compile
+void compile_warning(const char *fmt, ...);
+
+// how many errors were printed instead of captured, for the exit status
+int compile_failures(void);
+
+// collects the errors of the calling thread into text until compile_capture_end, free the text with SDL_free
+void compile_capture_begin(char **text);
+void compile_capture_end(void);
+
+Uint8 *write_le32(Uint8 *dst, Uint32 value);
+Uint8 *write_le64(Uint8 *dst, Uint64 value);
+
+const Uint8 *read_le32(const Uint8 *src, Uint32 *value);
+const Uint8 *read_le64(const Uint8 *src, Uint64 *value);
+
+// hand out the memory of a dynamic stream and close it, free with SDL_free. text ends in a NUL
+// that the size leaves out, size may be NULL
+void *take_memory(SDL_IOStream *io, size_t *size);
+char *take_text(SDL_IOStream *io, size_t *size);
+
+// serializes a blob into the file format read by the library
+void *encode(struct SDL_SHADER_Blob *blob, size_t *size);
+
+/*
+  writes a blob to a stream piece by piece, so code can be freed as soon as it
+  is written: encode_begin writes the header, encode_put appends one code entry
+  and encode_end seeks back to fill in the final count and the formats of
+  encoder->blob, which may change in between.
+*/
+struct SDL_SHADER_Encoder
+{
+  SDL_IOStream *io;
+  Sint64 start;
+  struct SDL_SHADER_Blob blob;
+};
+
+bool encode_begin(struct SDL_SHADER_Encoder *encoder, SDL_IOStream *io, const struct SDL_SHADER_Blob *blob);
+bool encode_put(struct SDL_SHADER_Encoder *encoder, SDL_GPUShaderFormat format, const void *code, size_t code_size);
+bool encode_end(struct SDL_SHADER_Encoder *encoder);
+
+// reads a blob written by encode, the code keeps pointing into data. free blob->shaders with SDL_free
+bool decode(const void *data, size_t size, struct SDL_SHADER_Blob *blob);
+
+// compiles a shader into an encoded blob, optionally handing out its reflection
+void *compile(void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size);
+
+/*
+  compiles several entry points of one source into a blob each, the type and
+  entry of the settings are ignored. the front-end work is shared where the
+  language allows it: GLSL is preprocessed once and a SPIR-V module is cross
+  compiled for every entry it holds. HLSL still needs a front-end pass per entry.
+
+  bins, sizes and reflections (optional) get one slot per entry, a failed entry
+  leaves its slot NULL and makes the result false.
+*/
+bool compile_entries(void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entries, int num_entries, SDL_SHADER_Reflection **reflections, void **bins, size_t *sizes);
+
+// compiles a vertex (index 0) and fragment (index 1) shader that are used together, linking their spirv
+// in between so the vertex shader only computes what the fragment shader reads. see link.h
+bool compile_linked(void *codes[2], size_t code_sizes[2], const struct SDL_SHADER_Settings *settings[2], SDL_SHADER_Reflection **reflections, void **bins, size_t *sizes);
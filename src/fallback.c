@@ -0,0 +1,175 @@
+#include "fallback.h"
+#include "alloc.h"
+#include "cache.h"
+
+#include <SDL_shader/SDL_shader_fallback.h>
+#include <SDL3_shadercross/SDL_shadercross.h>
+
+// bump when the conversion changes, cached results of older versions are ignored
+#define FALLBACK_VERSION 1
+
+struct Fallback
+{
+  bool enabled;
+  char *cache_dir;
+};
+
+static struct Fallback state = {0};
+
+// the format converted to, in the order the compiler builds them
+static SDL_GPUShaderFormat pick_format(SDL_GPUShaderFormat wanted)
+{
+  if (wanted & SDL_GPU_SHADERFORMAT_DXIL)
+  {
+    return SDL_GPU_SHADERFORMAT_DXIL;
+  }
+  if (wanted & SDL_GPU_SHADERFORMAT_DXBC)
+  {
+    return SDL_GPU_SHADERFORMAT_DXBC;
+  }
+  if (wanted & SDL_GPU_SHADERFORMAT_MSL)
+  {
+    return SDL_GPU_SHADERFORMAT_MSL;
+  }
+  return 0;
+}
+
+// everything the converted code depends on
+static void convert_key(const struct SDL_SHADER_Blob *blob, const struct SDL_SHADER_Code *spirv, SDL_GPUShaderFormat format, Uint8 key[HASH_SIZE])
+{
+  struct Hash hash;
+  hash_begin(&hash);
+  hash_update_le32(&hash, FALLBACK_VERSION);
+#ifdef SDL_SHADERCROSS_MAJOR_VERSION
+  hash_update_le32(&hash, SDL_SHADERCROSS_MAJOR_VERSION);
+  hash_update_le32(&hash, SDL_SHADERCROSS_MINOR_VERSION);
+  hash_update_le32(&hash, SDL_SHADERCROSS_MICRO_VERSION);
+#endif
+  hash_update_le32(&hash, format);
+  hash_update_le32(&hash, blob->type);
+  hash_update_string(&hash, blob->entry);
+  hash_update(&hash, spirv->code, spirv->code_size);
+  hash_end(&hash, key);
+}
+
+// moves converted code into scratch memory, which is what the loader frees
+static bool hand_out(void *data, size_t size, SDL_GPUShaderFormat format, struct SDL_SHADER_Code *code)
+{
+  code->format = format;
+  code->code_size = size;
+  code->code = scratch_alloc(size ? size : 1);
+
+  if (code->code != NULL)
+  {
+    SDL_memcpy(code->code, data, size);
+  }
+
+  SDL_free(data);
+  return code->code != NULL;
+}
+
+static bool convert(const struct SDL_SHADER_Blob *blob, const struct SDL_SHADER_Code *spirv, SDL_GPUShaderFormat wanted, struct SDL_SHADER_Code *code)
+{
+  SDL_GPUShaderFormat format = pick_format(wanted);
+  if (format == 0)
+  {
+    return SDL_SetError("the shader has no supported format");
+  }
+
+  Uint8 key[HASH_SIZE];
+  convert_key(blob, spirv, format, key);
+
+  if (state.cache_dir != NULL)
+  {
+    size_t size;
+    void *data = cache_load(state.cache_dir, key, &size);
+    if (data != NULL && size > 0)
+    {
+      return hand_out(data, size, format, code);
+    }
+
+    SDL_free(data);
+  }
+
+  SDL_ShaderCross_SPIRV_Info info = {0};
+  info.bytecode = spirv->code;
+  info.bytecode_size = spirv->code_size;
+  info.entrypoint = blob->entry;
+
+  if (blob->type == SDL_SHADER_TYPE_VERTEX)
+  {
+    info.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+  }
+  else if (blob->type == SDL_SHADER_TYPE_FRAGMENT)
+  {
+    info.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+  }
+  else
+  {
+    info.shader_stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+  }
+
+  size_t size = 0;
+  void *data = NULL;
+
+  if (format == SDL_GPU_SHADERFORMAT_DXIL)
+  {
+    data = SDL_ShaderCross_CompileDXILFromSPIRV(&info, &size);
+  }
+  else if (format == SDL_GPU_SHADERFORMAT_DXBC)
+  {
+    data = SDL_ShaderCross_CompileDXBCFromSPIRV(&info, &size);
+  }
+  else
+  {
+    data = SDL_ShaderCross_TranspileMSLFromSPIRV(&info);
+    size = data != NULL ? SDL_strlen(data) + 1 : 0;
+  }
+
+  if (data == NULL)
+  {
+    return false;
+  }
+
+  // a failed store only costs the next launch another conversion
+  if (state.cache_dir != NULL)
+  {
+    cache_store(state.cache_dir, key, data, size);
+  }
+
+  return hand_out(data, size, format, code);
+}
+
+bool SDL_SHADER_EnableFallback(const char *cache_dir)
+{
+  if (!state.enabled)
+  {
+    if (!SDL_ShaderCross_Init())
+    {
+      return false;
+    }
+
+    state.enabled = true;
+  }
+
+  SDL_free(state.cache_dir);
+  state.cache_dir = cache_dir != NULL ? SDL_strdup(cache_dir) : NULL;
+
+  fallback_register(convert);
+  return true;
+}
+
+void SDL_SHADER_DisableFallback(void)
+{
+  if (!state.enabled)
+  {
+    return;
+  }
+
+  fallback_register(NULL);
+  SDL_ShaderCross_Quit();
+
+  SDL_free(state.cache_dir);
+  state.cache_dir = NULL;
+  state.enabled = false;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include "common.h"
+
+/*
+  lets blobs that only hold SPIR-V load on devices that want another format.
+  the optional SDL_shader_fallback library registers a converter here, so the
+  core library never links SDL_shadercross. the converter gets the header of
+  the blob and its SPIR-V, and fills code with scratch memory.
+*/
+typedef bool (*Fallback_Func)(const struct SDL_SHADER_Blob *blob, const struct SDL_SHADER_Code *spirv, SDL_GPUShaderFormat wanted, struct SDL_SHADER_Code *code);
+
+// pass NULL to stop converting
+void fallback_register(Fallback_Func func);
@@ -0,0 +1,152 @@
+#include "hash.h"
+
+#include <SDL3/SDL_endian.h>
+
+static const Uint32 round_constants[64] =
+{
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTATE(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void hash_block(struct Hash *hash, const Uint8 *block)
+{
+  Uint32 w[64];
+  for (int i = 0; i < 16; i++)
+  {
+    w[i] = ((Uint32)block[i * 4] << 24) | ((Uint32)block[i * 4 + 1] << 16) | ((Uint32)block[i * 4 + 2] << 8) | block[i * 4 + 3];
+  }
+
+  for (int i = 16; i < 64; i++)
+  {
+    Uint32 s0 = ROTATE(w[i - 15], 7) ^ ROTATE(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    Uint32 s1 = ROTATE(w[i - 2], 17) ^ ROTATE(w[i - 2], 19) ^ (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  Uint32 a = hash->state[0], b = hash->state[1], c = hash->state[2], d = hash->state[3];
+  Uint32 e = hash->state[4], f = hash->state[5], g = hash->state[6], h = hash->state[7];
+
+  for (int i = 0; i < 64; i++)
+  {
+    Uint32 s1 = ROTATE(e, 6) ^ ROTATE(e, 11) ^ ROTATE(e, 25);
+    Uint32 choice = (e & f) ^ (~e & g);
+    Uint32 t1 = h + s1 + choice + round_constants[i] + w[i];
+    Uint32 s0 = ROTATE(a, 2) ^ ROTATE(a, 13) ^ ROTATE(a, 22);
+    Uint32 majority = (a & b) ^ (a & c) ^ (b & c);
+    Uint32 t2 = s0 + majority;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  hash->state[0] += a;
+  hash->state[1] += b;
+  hash->state[2] += c;
+  hash->state[3] += d;
+  hash->state[4] += e;
+  hash->state[5] += f;
+  hash->state[6] += g;
+  hash->state[7] += h;
+}
+
+void hash_begin(struct Hash *hash)
+{
+  hash->state[0] = 0x6a09e667;
+  hash->state[1] = 0xbb67ae85;
+  hash->state[2] = 0x3c6ef372;
+  hash->state[3] = 0xa54ff53a;
+  hash->state[4] = 0x510e527f;
+  hash->state[5] = 0x9b05688c;
+  hash->state[6] = 0x1f83d9ab;
+  hash->state[7] = 0x5be0cd19;
+  hash->length = 0;
+  hash->buffer_size = 0;
+}
+
+void hash_update(struct Hash *hash, const void *data, size_t size)
+{
+  const Uint8 *src = data;
+  hash->length += size;
+
+  // top up a partial block first
+  if (hash->buffer_size > 0)
+  {
+    size_t count = SDL_min(size, 64 - hash->buffer_size);
+    SDL_memcpy(hash->buffer + hash->buffer_size, src, count);
+    hash->buffer_size += count;
+    src += count;
+    size -= count;
+
+    if (hash->buffer_size < 64)
+    {
+      return;
+    }
+
+    hash_block(hash, hash->buffer);
+    hash->buffer_size = 0;
+  }
+
+  while (size >= 64)
+  {
+    hash_block(hash, src);
+    src += 64;
+    size -= 64;
+  }
+
+  SDL_memcpy(hash->buffer, src, size);
+  hash->buffer_size = size;
+}
+
+void hash_end(struct Hash *hash, Uint8 digest[HASH_SIZE])
+{
+  Uint64 bits = hash->length * 8;
+
+  // a single 1 bit, zeros up to 56 bytes into a block, then the big endian bit length
+  Uint8 padding[72] = { 0x80 };
+  size_t padding_size = (hash->buffer_size < 56 ? 56 : 120) - hash->buffer_size;
+  for (int i = 0; i < 8; i++)
+  {
+    padding[padding_size + i] = (Uint8)(bits >> (56 - i * 8));
+  }
+
+  hash_update(hash, padding, padding_size + 8);
+
+  for (int i = 0; i < 8; i++)
+  {
+    digest[i * 4] = (Uint8)(hash->state[i] >> 24);
+    digest[i * 4 + 1] = (Uint8)(hash->state[i] >> 16);
+    digest[i * 4 + 2] = (Uint8)(hash->state[i] >> 8);
+    digest[i * 4 + 3] = (Uint8)hash->state[i];
+  }
+}
+
+void hash_update_le32(struct Hash *hash, Uint32 value)
+{
+  Uint32 tmp = SDL_Swap32LE(value);
+  hash_update(hash, &tmp, sizeof(tmp));
+}
+
+void hash_update_string(struct Hash *hash, const char *string)
+{
+  Uint32 size = string != NULL ? (Uint32)SDL_strlen(string) : 0xffffffffu;
+  hash_update_le32(hash, size);
+
+  if (string != NULL)
+  {
+    hash_update(hash, string, size);
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+#define HASH_SIZE 32
+
+// SHA-256, used to key cached compile results by their inputs
+struct Hash
+{
+  Uint32 state[8];
+  Uint64 length;
+  Uint8 buffer[64];
+  Uint32 buffer_size;
+};
+
+void hash_begin(struct Hash *hash);
+void hash_update(struct Hash *hash, const void *data, size_t size);
+void hash_end(struct Hash *hash, Uint8 digest[HASH_SIZE]);
+
+// hashes a Uint32 in a fixed byte order
+void hash_update_le32(struct Hash *hash, Uint32 value);
+
+// hashes a string with its length, so consecutive strings can't run into each other
+void hash_update_string(struct Hash *hash, const char *string);
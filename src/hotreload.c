@@ -0,0 +1,358 @@
+#include "hotreload.h"
+
+#include <SDL_shader/SDL_shader.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_timer.h>
+
+#ifdef SDL_PLATFORM_LINUX
+#include <errno.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+// how often files are polled on platforms without file notifications
+#define HOTRELOAD_POLL_INTERVAL_NS (250 * SDL_NS_PER_MS)
+
+struct Tracked
+{
+  SDL_GPUDevice *device;
+  char *file;
+  char *name;        // the file name without its directory
+  void *handle;
+  bool compute;
+  bool dirty;
+  int watch;
+  SDL_Time modify_time;
+};
+
+struct HotReload
+{
+  bool enabled;
+  SDL_SHADER_ReloadCallback callback;
+  void *userdata;
+
+  SDL_Mutex *mutex;
+  struct Tracked *tracked;
+  Uint32 num_tracked;
+
+  int inotify;
+  Uint64 last_poll;
+};
+
+static struct HotReload hotreload = {0};
+
+// a changed file picked up under the mutex, reloaded once it is released
+struct Change
+{
+  SDL_GPUDevice *device;
+  char *file;
+  void *handle;
+  bool compute;
+};
+
+bool SDL_SHADER_EnableHotReload(SDL_SHADER_ReloadCallback callback, void *userdata)
+{
+  if (callback == NULL)
+  {
+    return SDL_SetError("a reload callback is required");
+  }
+
+  if (hotreload.mutex == NULL)
+  {
+    hotreload.mutex = SDL_CreateMutex();
+    hotreload.inotify = -1;
+
+#ifdef SDL_PLATFORM_LINUX
+    hotreload.inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+  }
+
+  hotreload.callback = callback;
+  hotreload.userdata = userdata;
+  hotreload.enabled = true;
+  return true;
+}
+
+void SDL_SHADER_DisableHotReload(void)
+{
+  if (hotreload.mutex == NULL)
+  {
+    return;
+  }
+
+#ifdef SDL_PLATFORM_LINUX
+  if (hotreload.inotify >= 0)
+  {
+    close(hotreload.inotify);
+  }
+#endif
+
+  for (Uint32 i = 0; i < hotreload.num_tracked; i++)
+  {
+    SDL_free(hotreload.tracked[i].file);
+  }
+
+  SDL_free(hotreload.tracked);
+  SDL_DestroyMutex(hotreload.mutex);
+  SDL_zero(hotreload);
+}
+
+void hotreload_track(SDL_GPUDevice *device, const char *file, void *handle, bool compute)
+{
+  if (!hotreload.enabled || handle == NULL)
+  {
+    return;
+  }
+
+  SDL_LockMutex(hotreload.mutex);
+
+  hotreload.tracked = SDL_realloc(hotreload.tracked, (hotreload.num_tracked + 1) * sizeof(struct Tracked));
+  struct Tracked *tracked = &hotreload.tracked[hotreload.num_tracked];
+  hotreload.num_tracked += 1;
+
+  SDL_zerop(tracked);
+  tracked->device = device;
+  tracked->file = SDL_strdup(file);
+  tracked->handle = handle;
+  tracked->compute = compute;
+  tracked->watch = -1;
+
+  // split the directory from the file name
+  size_t name_start = 0;
+  for (size_t i = 0; tracked->file[i] != '\0'; i++)
+  {
+    if (tracked->file[i] == '/' || tracked->file[i] == '\\')
+    {
+      name_start = i + 1;
+    }
+  }
+  tracked->name = &tracked->file[name_start];
+
+  SDL_PathInfo info;
+  if (SDL_GetPathInfo(file, &info))
+  {
+    tracked->modify_time = info.modify_time;
+  }
+
+#ifdef SDL_PLATFORM_LINUX
+  // watch the directory, files replaced through a rename would drop a watch on the file itself
+  if (hotreload.inotify >= 0)
+  {
+    char *dir = name_start > 0 ? SDL_strndup(tracked->file, name_start) : SDL_strdup(".");
+    tracked->watch = inotify_add_watch(hotreload.inotify, dir, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    SDL_free(dir);
+  }
+#endif
+
+  SDL_UnlockMutex(hotreload.mutex);
+}
+
+void SDL_SHADER_UntrackHotReload(void *handle)
+{
+  if (hotreload.mutex == NULL || handle == NULL)
+  {
+    return;
+  }
+
+  SDL_LockMutex(hotreload.mutex);
+
+  for (Uint32 i = 0; i < hotreload.num_tracked; i++)
+  {
+    if (hotreload.tracked[i].handle == handle)
+    {
+      // the watch is shared by the whole directory, so it stays
+      SDL_free(hotreload.tracked[i].file);
+      hotreload.tracked[i] = hotreload.tracked[hotreload.num_tracked - 1];
+      hotreload.num_tracked -= 1;
+      break;
+    }
+  }
+
+  SDL_UnlockMutex(hotreload.mutex);
+}
+
+// marks tracked files that changed since the last update
+static void find_changes(void)
+{
+#ifdef SDL_PLATFORM_LINUX
+  if (hotreload.inotify >= 0)
+  {
+    char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+      ssize_t length = read(hotreload.inotify, buffer, sizeof(buffer));
+      if (length <= 0)
+      {
+        break;
+      }
+
+      for (char *p = buffer; p < buffer + length;)
+      {
+        const struct inotify_event *event = (const struct inotify_event*)p;
+        p += sizeof(struct inotify_event) + event->len;
+
+        if (event->len == 0)
+        {
+          continue;
+        }
+
+        for (Uint32 i = 0; i < hotreload.num_tracked; i++)
+        {
+          struct Tracked *tracked = &hotreload.tracked[i];
+          if (tracked->watch == event->wd && SDL_strcmp(tracked->name, event->name) == 0)
+          {
+            tracked->dirty = true;
+          }
+        }
+      }
+    }
+  }
+#endif
+
+  // without notifications, or for files whose directory couldn't be watched, poll the modify times
+  Uint64 now = SDL_GetTicksNS();
+  if (hotreload.last_poll != 0 && now - hotreload.last_poll < HOTRELOAD_POLL_INTERVAL_NS)
+  {
+    return;
+  }
+  hotreload.last_poll = now;
+
+  for (Uint32 i = 0; i < hotreload.num_tracked; i++)
+  {
+    struct Tracked *tracked = &hotreload.tracked[i];
+    SDL_PathInfo info;
+
+    if (hotreload.inotify >= 0 && tracked->watch >= 0)
+    {
+      continue;
+    }
+
+    if (SDL_GetPathInfo(tracked->file, &info) && info.modify_time != tracked->modify_time)
+    {
+      tracked->modify_time = info.modify_time;
+      tracked->dirty = true;
+    }
+  }
+}
+
+// swaps the handle of a tracked shader, false when it isn't tracked anymore
+static bool replace_handle(void *old_handle, void *new_handle)
+{
+  bool replaced = false;
+  SDL_LockMutex(hotreload.mutex);
+
+  for (Uint32 i = 0; i < hotreload.num_tracked && !replaced; i++)
+  {
+    if (hotreload.tracked[i].handle == old_handle)
+    {
+      hotreload.tracked[i].handle = new_handle;
+      replaced = true;
+    }
+  }
+
+  SDL_UnlockMutex(hotreload.mutex);
+  return replaced;
+}
+
+// loads a changed file again and hands the new object to the callback
+static void reload_change(const struct Change *change)
+{
+  // the _IO loaders don't track, so the new object only replaces the old handle
+  SDL_IOStream *src = SDL_IOFromFile(change->file, "rb");
+  if (src == NULL)
+  {
+    return;
+  }
+
+  SDL_SHADER_Reload reload = {0};
+  reload.file = change->file;
+
+  if (change->compute)
+  {
+    reload.old_pipeline = change->handle;
+    reload.new_pipeline = SDL_SHADER_LoadCompute_IO(change->device, src, true);
+  }
+  else
+  {
+    reload.old_shader = change->handle;
+    reload.new_shader = SDL_SHADER_Load_IO(change->device, src, true);
+  }
+
+  // a half written or broken file keeps the old object
+  if (reload.new_shader == NULL && reload.new_pipeline == NULL)
+  {
+    return;
+  }
+
+  // untracked by another thread while loading, nobody would release the new object
+  if (!replace_handle(change->handle, reload.new_shader != NULL ? (void*)reload.new_shader : (void*)reload.new_pipeline))
+  {
+    if (reload.new_shader != NULL)
+    {
+      SDL_ReleaseGPUShader(change->device, reload.new_shader);
+    }
+    else
+    {
+      SDL_ReleaseGPUComputePipeline(change->device, reload.new_pipeline);
+    }
+
+    return;
+  }
+
+  hotreload.callback(hotreload.userdata, &reload);
+}
+
+void SDL_SHADER_UpdateHotReload(void)
+{
+  if (!hotreload.enabled)
+  {
+    return;
+  }
+
+  SDL_LockMutex(hotreload.mutex);
+  find_changes();
+
+  struct Change *changes = NULL;
+  Uint32 num_changes = 0;
+
+  for (Uint32 i = 0; i < hotreload.num_tracked; i++)
+  {
+    struct Tracked *tracked = &hotreload.tracked[i];
+    if (!tracked->dirty)
+    {
+      continue;
+    }
+
+    tracked->dirty = false;
+
+    struct Change *grown = SDL_realloc(changes, (num_changes + 1) * sizeof(struct Change));
+    if (grown == NULL)
+    {
+      break;
+    }
+
+    changes = grown;
+    changes[num_changes].device = tracked->device;
+    changes[num_changes].file = SDL_strdup(tracked->file);
+    changes[num_changes].handle = tracked->handle;
+    changes[num_changes].compute = tracked->compute;
+    num_changes += 1;
+  }
+
+  SDL_UnlockMutex(hotreload.mutex);
+
+  // nothing is locked while the callback runs, so it may untrack shaders or disable hot reloading
+  for (Uint32 i = 0; i < num_changes; i++)
+  {
+    if (hotreload.enabled && changes[i].file != NULL)
+    {
+      reload_change(&changes[i]);
+    }
+
+    SDL_free(changes[i].file);
+  }
+
+  SDL_free(changes);
+}
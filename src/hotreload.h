@@ -0,0 +1,5 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+
+// remembers where a shader was loaded from when hot reloading is enabled
+void hotreload_track(SDL_GPUDevice *device, const char *file, void *handle, bool compute);
@@ -0,0 +1,163 @@
+#include "jobserver.h"
+
+#include <SDL3/SDL_platform.h>
+
+#ifndef SDL_PLATFORM_WINDOWS
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+// the value of the last --jobserver-auth or --jobserver-fds flag, free with SDL_free
+static char *find_auth(const char *flags)
+{
+  const char *names[] = { "--jobserver-auth=", "--jobserver-fds=" };
+  const char *found = NULL;
+
+  for (int i = 0; i < SDL_arraysize(names); i++)
+  {
+    size_t name_size = SDL_strlen(names[i]);
+
+    // later flags win, make appends the one that counts
+    for (const char *p = SDL_strstr(flags, names[i]); p != NULL; p = SDL_strstr(p + 1, names[i]))
+    {
+      if (found == NULL || p > found)
+      {
+        found = p + name_size;
+      }
+    }
+  }
+
+  if (found == NULL)
+  {
+    return NULL;
+  }
+
+  size_t size = 0;
+  while (found[size] != '\0' && found[size] != ' ')
+  {
+    size++;
+  }
+
+  return SDL_strndup(found, size);
+}
+
+bool jobserver_open(struct Jobserver *jobserver)
+{
+  jobserver->read = -1;
+  jobserver->write = -1;
+  jobserver->owned = false;
+
+  const char *flags = SDL_getenv("MAKEFLAGS");
+  if (flags == NULL)
+  {
+    return false;
+  }
+
+  char *auth = find_auth(flags);
+  if (auth == NULL)
+  {
+    return false;
+  }
+
+  if (SDL_strncmp(auth, "fifo:", 5) == 0)
+  {
+    // a private descriptor, so it can be made non-blocking without affecting make
+    int fd = open(auth + 5, O_RDWR | O_NONBLOCK);
+    if (fd >= 0)
+    {
+      jobserver->read = fd;
+      jobserver->write = fd;
+      jobserver->owned = true;
+    }
+  }
+  else
+  {
+    char *separator = SDL_strchr(auth, ',');
+    int read_fd = (int)SDL_strtol(auth, NULL, 10);
+    int write_fd = separator != NULL ? (int)SDL_strtol(separator + 1, NULL, 10) : -1;
+
+    // make only passes the pipe to recipes it knows are sub makes, closed ones are ignored
+    if (read_fd >= 0 && write_fd >= 0 && fcntl(read_fd, F_GETFD) != -1 && fcntl(write_fd, F_GETFD) != -1)
+    {
+      jobserver->read = read_fd;
+      jobserver->write = write_fd;
+
+#ifdef SDL_PLATFORM_LINUX
+      // reopening through /proc gives a private description that can be non-blocking
+      char path[64];
+      SDL_snprintf(path, sizeof(path), "/proc/self/fd/%d", read_fd);
+
+      int fd = open(path, O_RDONLY | O_NONBLOCK);
+      if (fd >= 0)
+      {
+        jobserver->read = fd;
+        jobserver->owned = true;
+      }
+#endif
+    }
+  }
+
+  SDL_free(auth);
+  return jobserver->read >= 0;
+}
+
+void jobserver_close(struct Jobserver *jobserver)
+{
+  if (jobserver->owned)
+  {
+    close(jobserver->read);
+  }
+
+  jobserver->read = -1;
+  jobserver->write = -1;
+}
+
+int jobserver_acquire(struct Jobserver *jobserver, int timeout_ms)
+{
+  struct pollfd poll_info = { jobserver->read, POLLIN, 0 };
+  if (poll(&poll_info, 1, timeout_ms) <= 0)
+  {
+    return -1;
+  }
+
+  // another process may have taken the token in the meantime. on a descriptor
+  // shared with make this blocks until the next one is released
+  unsigned char token;
+  ssize_t count = read(jobserver->read, &token, 1);
+  return count == 1 ? token : -1;
+}
+
+void jobserver_release(struct Jobserver *jobserver, int token)
+{
+  unsigned char byte = (unsigned char)token;
+  while (write(jobserver->write, &byte, 1) < 0 && errno == EINTR)
+  {
+  }
+}
+
+#else
+
+bool jobserver_open(struct Jobserver *jobserver)
+{
+  // make on windows hands out a named semaphore instead, not supported yet
+  jobserver->read = -1;
+  jobserver->write = -1;
+  jobserver->owned = false;
+  return false;
+}
+
+void jobserver_close(struct Jobserver *jobserver)
+{
+}
+
+int jobserver_acquire(struct Jobserver *jobserver, int timeout_ms)
+{
+  return -1;
+}
+
+void jobserver_release(struct Jobserver *jobserver, int token)
+{
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+/*
+  shares the job slots of a GNU make jobserver found in MAKEFLAGS, so running
+  inside "make -j" doesn't oversubscribe the machine. both the fifo style
+  (--jobserver-auth=fifo:PATH) and the pipe style (--jobserver-auth=R,W) work.
+
+  every process implicitly owns one slot, a token has to be read from the
+  jobserver for each job that runs next to it and written back when it ends.
+*/
+
+struct Jobserver
+{
+  int read;       // -1 when there is no jobserver
+  int write;
+  bool owned;     // the read descriptor was opened here and gets closed again
+};
+
+// false when not running under a jobserver
+bool jobserver_open(struct Jobserver *jobserver);
+void jobserver_close(struct Jobserver *jobserver);
+
+// waits up to timeout_ms for a token, returns the token or -1
+int jobserver_acquire(struct Jobserver *jobserver, int timeout_ms);
+void jobserver_release(struct Jobserver *jobserver, int token);
@@ -0,0 +1,562 @@
+#include "link.h"
+#include "spirv.h"
+
+#include <SDL3/SDL_error.h>
+
+#define LINK_MAX_LOCATIONS 256
+
+#define LINK_STORAGE_FUNCTION 7
+
+struct Link_Module
+{
+  struct SPIRV_Module module;
+  size_t functions;  // word offset of the first function
+  Uint32 glsl;       // the GLSL.std.450 import, its instructions have no side effects
+  bool *removed;     // per id
+  bool *pending;     // per id, scratch for remove_write_only
+  Uint32 *uses;      // per id, scratch for remove_dead_code
+};
+
+static bool is_annotation(Uint32 opcode)
+{
+  return opcode == SPIRV_OP_NAME || opcode == SPIRV_OP_MEMBER_NAME || opcode == SPIRV_OP_DECORATE || opcode == SPIRV_OP_MEMBER_DECORATE
+      || opcode == SPIRV_OP_DECORATE_ID || opcode == SPIRV_OP_DECORATE_STRING || opcode == SPIRV_OP_MEMBER_DECORATE_STRING;
+}
+
+static bool is_access_chain(Uint32 opcode)
+{
+  return opcode == SPIRV_OP_ACCESS_CHAIN || opcode == SPIRV_OP_IN_BOUNDS_ACCESS_CHAIN;
+}
+
+// instructions with a result type and id that can go once nothing uses their result
+static bool is_pure(const struct Link_Module *lm, const Uint32 *inst, Uint32 word_count)
+{
+  Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+  if (word_count < 3)
+  {
+    return false;
+  }
+
+  if (opcode == SPIRV_OP_EXT_INST)
+  {
+    return word_count >= 4 && lm->glsl != 0 && inst[3] == lm->glsl;
+  }
+
+  return opcode == SPIRV_OP_LOAD
+      || is_access_chain(opcode)
+      || (opcode >= 77 && opcode <= 84)    // OpVectorExtractDynamic .. OpTranspose
+      || (opcode >= 86 && opcode <= 98)    // OpSampledImage .. OpImageRead
+      || (opcode >= 100 && opcode <= 107)  // OpImage .. OpImageQuerySamples
+      || (opcode >= 109 && opcode <= 124)  // conversions
+      || (opcode >= 126 && opcode <= 152)  // arithmetic
+      || (opcode >= 154 && opcode <= 191)  // relational and logical
+      || (opcode >= 194 && opcode <= 205)  // bit operations
+      || (opcode >= 207 && opcode <= 215)  // derivatives
+      || opcode == 245;                    // OpPhi
+}
+
+static bool is_removed(const struct Link_Module *lm, Uint32 id)
+{
+  return id < lm->module.bound && lm->removed[id];
+}
+
+// instructions left out of the linked module
+static bool is_dropped(const struct Link_Module *lm, const Uint32 *inst, Uint32 word_count)
+{
+  Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+  if (opcode == SPIRV_OP_STORE)
+  {
+    return word_count >= 3 && is_removed(lm, inst[1]);
+  }
+
+  if (opcode == SPIRV_OP_VARIABLE || is_pure(lm, inst, word_count))
+  {
+    return word_count >= 3 && is_removed(lm, inst[2]);
+  }
+
+  if (is_annotation(opcode))
+  {
+    return word_count >= 2 && is_removed(lm, inst[1]);
+  }
+
+  return false;
+}
+
+static bool link_open(struct Link_Module *lm, const void *code, size_t code_size, Uint32 execution_model)
+{
+  SDL_zerop(lm);
+
+  if (!spirv_parse(&lm->module, code, code_size))
+  {
+    return false;
+  }
+
+  lm->removed = SDL_calloc(lm->module.bound, sizeof(bool));
+  lm->pending = SDL_calloc(lm->module.bound, sizeof(bool));
+  lm->uses = SDL_calloc(lm->module.bound, sizeof(Uint32));
+  lm->functions = lm->module.word_count;
+
+  const Uint32 *inst;
+  Uint32 word_count;
+  int num_entries = 0;
+  bool matches = false;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+    if (opcode == SPIRV_OP_ENTRY_POINT && word_count >= 3)
+    {
+      num_entries++;
+      matches = inst[1] == execution_model;
+    }
+    else if (opcode == SPIRV_OP_EXT_INST_IMPORT && word_count >= 3 && SDL_strcmp((const char*)&inst[2], "GLSL.std.450") == 0)
+    {
+      lm->glsl = inst[1];
+    }
+    else if (opcode == SPIRV_OP_FUNCTION)
+    {
+      lm->functions = pos;
+      break;
+    }
+  }
+
+  // removing an output of one entry point could break another
+  return num_entries == 1 && matches;
+}
+
+static void link_close(struct Link_Module *lm)
+{
+  spirv_free(&lm->module);
+  SDL_free(lm->removed);
+  SDL_free(lm->pending);
+  SDL_free(lm->uses);
+}
+
+// how many locations a varying of this type takes, 0 when unknown
+static Uint32 location_count(const struct SPIRV_Module *module, Uint32 type)
+{
+  const Uint32 *inst = type < module->bound ? module->ids[type].inst : NULL;
+  if (inst == NULL)
+  {
+    return 0;
+  }
+
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_TYPE_BOOL:
+    case SPIRV_OP_TYPE_INT:
+    case SPIRV_OP_TYPE_FLOAT:
+      return 1;
+
+    case SPIRV_OP_TYPE_VECTOR:
+    {
+      // 64 bit vectors with more than two components take two
+      const Uint32 *component = inst[2] < module->bound ? module->ids[inst[2]].inst : NULL;
+      return component != NULL && component[2] == 64 && inst[3] > 2 ? 2 : 1;
+    }
+
+    case SPIRV_OP_TYPE_MATRIX:
+      return inst[3] * location_count(module, inst[2]);
+
+    case SPIRV_OP_TYPE_ARRAY:
+    {
+      Uint32 length;
+      return spirv_constant(module, inst[3], &length) ? length * location_count(module, inst[2]) : 0;
+    }
+
+    default:
+      return 0;
+  }
+}
+
+// a user varying of the given storage class, with its first location and how many it takes
+static bool is_varying(const struct SPIRV_Module *module, Uint32 id, Uint32 storage_class, Uint32 *location, Uint32 *count)
+{
+  Uint32 storage;
+  Uint32 type = spirv_variable_type(module, id, &storage);
+
+  if (type == 0 || storage != storage_class || !(module->ids[id].flags & SPIRV_FLAG_LOCATION) || (module->ids[id].flags & SPIRV_FLAG_BUILTIN))
+  {
+    return false;
+  }
+
+  *location = module->ids[id].location;
+  *count = location_count(module, type);
+  return true;
+}
+
+// true when any instruction in a function mentions the id
+static bool is_referenced(const struct Link_Module *lm, Uint32 id)
+{
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  for (size_t pos = lm->functions; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    for (Uint32 i = 1; i < word_count; i++)
+    {
+      if (inst[i] == id)
+      {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// removes a variable that is only ever stored to, along with the access chains into it and the stores
+static bool remove_write_only(struct Link_Module *lm, Uint32 variable)
+{
+  Uint32 bound = lm->module.bound;
+  bool *pending = lm->pending;
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  pending[variable] = true;
+
+  // pointers into the variable, chains always come after their base
+  for (size_t pos = lm->functions; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    if (is_access_chain(SPIRV_OPCODE(inst[0])) && word_count >= 4 && inst[3] < bound && pending[inst[3]] && inst[2] < bound && !is_dropped(lm, inst, word_count))
+    {
+      pending[inst[2]] = true;
+    }
+  }
+
+  bool write_only = true;
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+    if (!write_only)
+    {
+      break;
+    }
+
+    // the entry point interface and annotations are fixed up when copying
+    if (is_dropped(lm, inst, word_count) || is_annotation(opcode) || opcode == SPIRV_OP_ENTRY_POINT)
+    {
+      continue;
+    }
+
+    if (opcode == SPIRV_OP_STORE && word_count >= 3 && inst[1] < bound && pending[inst[1]])
+    {
+      write_only = !(inst[2] < bound && pending[inst[2]]);
+      continue;
+    }
+
+    if ((is_access_chain(opcode) || opcode == SPIRV_OP_VARIABLE) && word_count >= 3 && inst[2] < bound && pending[inst[2]])
+    {
+      continue;
+    }
+
+    for (Uint32 i = 1; i < word_count; i++)
+    {
+      if (inst[i] < bound && pending[inst[i]])
+      {
+        write_only = false;
+        break;
+      }
+    }
+  }
+
+  // clear the scratch marks, they become removals when nothing reads the variable
+  for (size_t pos = lm->functions; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    if (is_access_chain(SPIRV_OPCODE(inst[0])) && word_count >= 3 && inst[2] < bound && pending[inst[2]])
+    {
+      pending[inst[2]] = false;
+      lm->removed[inst[2]] |= write_only;
+    }
+  }
+
+  pending[variable] = false;
+  lm->removed[variable] |= write_only;
+  return write_only;
+}
+
+// removes pure instructions nobody uses and function variables nobody reads, until nothing changes
+static void remove_dead_code(struct Link_Module *lm)
+{
+  Uint32 bound = lm->module.bound;
+  const Uint32 *inst;
+  Uint32 word_count;
+  bool changed = true;
+
+  while (changed)
+  {
+    changed = false;
+    SDL_memset(lm->uses, 0, bound * sizeof(Uint32));
+
+    for (size_t pos = SPIRV_HEADER_WORDS; pos < lm->module.word_count; pos += word_count)
+    {
+      inst = &lm->module.words[pos];
+      word_count = SPIRV_WORD_COUNT(inst[0]);
+      if (is_dropped(lm, inst, word_count) || is_annotation(SPIRV_OPCODE(inst[0])))
+      {
+        continue;
+      }
+
+      // pure instructions only use their operands, their type stays anyway
+      for (Uint32 i = is_pure(lm, inst, word_count) ? 3 : 1; i < word_count; i++)
+      {
+        if (inst[i] < bound)
+        {
+          lm->uses[inst[i]]++;
+        }
+      }
+    }
+
+    for (size_t pos = lm->functions; pos < lm->module.word_count; pos += word_count)
+    {
+      inst = &lm->module.words[pos];
+      word_count = SPIRV_WORD_COUNT(inst[0]);
+      if (is_dropped(lm, inst, word_count))
+      {
+        continue;
+      }
+
+      if (is_pure(lm, inst, word_count) && inst[2] < bound && lm->uses[inst[2]] == 0)
+      {
+        lm->removed[inst[2]] = true;
+        changed = true;
+      }
+      else if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_VARIABLE && word_count >= 4 && inst[3] == LINK_STORAGE_FUNCTION && inst[2] < bound)
+      {
+        changed |= remove_write_only(lm, inst[2]);
+      }
+    }
+  }
+}
+
+static bool has_zero_byte(Uint32 word)
+{
+  return (word & 0xFF) == 0 || (word & 0xFF00) == 0 || (word & 0xFF0000) == 0 || (word & 0xFF000000) == 0;
+}
+
+// copies the module without the removed instructions, free with SDL_free
+static Uint32 *link_copy(const struct Link_Module *lm, size_t *size)
+{
+  Uint32 *copy = SDL_malloc(lm->module.word_count * sizeof(Uint32));
+  size_t count = SPIRV_HEADER_WORDS;
+  SDL_memcpy(copy, lm->module.words, SPIRV_HEADER_WORDS * sizeof(Uint32));
+
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < lm->module.word_count; pos += word_count)
+  {
+    inst = &lm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    if (is_dropped(lm, inst, word_count))
+    {
+      continue;
+    }
+
+    if (SPIRV_OPCODE(inst[0]) != SPIRV_OP_ENTRY_POINT)
+    {
+      SDL_memcpy(&copy[count], inst, word_count * sizeof(Uint32));
+      count += word_count;
+      continue;
+    }
+
+    // the interface list follows the name
+    size_t start = count;
+    Uint32 i = 0;
+    bool name_end = false;
+
+    for (; i < word_count && i < 3; i++)
+    {
+      copy[count++] = inst[i];
+    }
+
+    for (; i < word_count && !name_end; i++)
+    {
+      copy[count++] = inst[i];
+      name_end = has_zero_byte(inst[i]);
+    }
+
+    for (; i < word_count; i++)
+    {
+      if (!is_removed(lm, inst[i]))
+      {
+        copy[count++] = inst[i];
+      }
+    }
+
+    copy[start] = ((Uint32)(count - start) << 16) | SPIRV_OP_ENTRY_POINT;
+  }
+
+  *size = count * sizeof(Uint32);
+  return copy;
+}
+
+// moves the locations both stages use next to each other, keeping their order
+static void compact_locations(Uint32 *vertex, size_t vertex_size, Uint32 *fragment, size_t fragment_size)
+{
+  struct SPIRV_Module modules[2];
+  Uint32 *words[2] = { vertex, fragment };
+  Uint32 storage[2] = { SPIRV_STORAGE_OUTPUT, SPIRV_STORAGE_INPUT };
+
+  if (!spirv_parse(&modules[0], vertex, vertex_size))
+  {
+    return;
+  }
+
+  if (!spirv_parse(&modules[1], fragment, fragment_size))
+  {
+    spirv_free(&modules[0]);
+    return;
+  }
+
+  bool used[LINK_MAX_LOCATIONS] = {0};
+  bool valid = true;
+
+  for (int m = 0; m < 2 && valid; m++)
+  {
+    for (Uint32 id = 1; id < modules[m].bound && valid; id++)
+    {
+      Uint32 location, count;
+      if (!is_varying(&modules[m], id, storage[m], &location, &count))
+      {
+        continue;
+      }
+
+      valid = count > 0 && location < LINK_MAX_LOCATIONS && count <= LINK_MAX_LOCATIONS - location;
+      for (Uint32 i = 0; valid && i < count; i++)
+      {
+        used[location + i] = true;
+      }
+    }
+
+    // packed components share locations, leave those alone
+    for (size_t pos = SPIRV_HEADER_WORDS; pos < modules[m].word_count && valid; pos += SPIRV_WORD_COUNT(words[m][pos]))
+    {
+      const Uint32 *inst = &words[m][pos];
+      valid = !(SPIRV_OPCODE(inst[0]) == SPIRV_OP_DECORATE && SPIRV_WORD_COUNT(inst[0]) >= 3 && inst[2] == SPIRV_DECORATION_COMPONENT);
+    }
+  }
+
+  Uint32 remap[LINK_MAX_LOCATIONS];
+  Uint32 next = 0;
+  for (Uint32 i = 0; i < LINK_MAX_LOCATIONS; i++)
+  {
+    remap[i] = used[i] ? next++ : i;
+  }
+
+  for (int m = 0; m < 2 && valid; m++)
+  {
+    for (size_t pos = SPIRV_HEADER_WORDS; pos < modules[m].word_count; pos += SPIRV_WORD_COUNT(words[m][pos]))
+    {
+      Uint32 *inst = &words[m][pos];
+      Uint32 location, count;
+
+      if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_DECORATE && SPIRV_WORD_COUNT(inst[0]) >= 4 && inst[2] == SPIRV_DECORATION_LOCATION
+        && is_varying(&modules[m], inst[1], storage[m], &location, &count))
+      {
+        inst[3] = remap[inst[3]];
+      }
+    }
+  }
+
+  spirv_free(&modules[0]);
+  spirv_free(&modules[1]);
+}
+
+bool spirv_link(void **vertex, size_t *vertex_size, void **fragment, size_t *fragment_size)
+{
+  struct Link_Module vs, fs;
+  bool vs_valid = link_open(&vs, *vertex, *vertex_size, SPIRV_EXECUTION_MODEL_VERTEX);
+  bool fs_valid = link_open(&fs, *fragment, *fragment_size, SPIRV_EXECUTION_MODEL_FRAGMENT);
+  bool linked = vs_valid && fs_valid;
+
+  if (!linked)
+  {
+    SDL_SetError("only single vertex and fragment entry points can be linked");
+  }
+
+  // the locations the fragment shader actually reads
+  bool live[LINK_MAX_LOCATIONS] = {0};
+
+  for (Uint32 id = 1; linked && id < fs.module.bound; id++)
+  {
+    Uint32 location, count;
+    if (!is_varying(&fs.module, id, SPIRV_STORAGE_INPUT, &location, &count))
+    {
+      continue;
+    }
+
+    if (count == 0 || location >= LINK_MAX_LOCATIONS || count > LINK_MAX_LOCATIONS - location)
+    {
+      linked = SDL_SetError("fragment input %u has an unsupported type", location);
+    }
+    else if (!is_referenced(&fs, id))
+    {
+      fs.removed[id] = true;
+    }
+    else
+    {
+      for (Uint32 i = 0; i < count; i++)
+      {
+        live[location + i] = true;
+      }
+    }
+  }
+
+  // vertex outputs nobody reads, unknown types are kept
+  for (Uint32 id = 1; linked && id < vs.module.bound; id++)
+  {
+    Uint32 location, count;
+    if (!is_varying(&vs.module, id, SPIRV_STORAGE_OUTPUT, &location, &count) || count == 0)
+    {
+      continue;
+    }
+
+    bool read = false;
+    for (Uint32 i = 0; i < count && !read; i++)
+    {
+      read = location + i >= LINK_MAX_LOCATIONS || live[location + i];
+    }
+
+    if (!read)
+    {
+      remove_write_only(&vs, id);
+    }
+  }
+
+  if (linked)
+  {
+    remove_dead_code(&vs);
+
+    size_t linked_vertex_size, linked_fragment_size;
+    Uint32 *linked_vertex = link_copy(&vs, &linked_vertex_size);
+    Uint32 *linked_fragment = link_copy(&fs, &linked_fragment_size);
+
+    compact_locations(linked_vertex, linked_vertex_size, linked_fragment, linked_fragment_size);
+
+    SDL_free(*vertex);
+    SDL_free(*fragment);
+    *vertex = linked_vertex;
+    *vertex_size = linked_vertex_size;
+    *fragment = linked_fragment;
+    *fragment_size = linked_fragment_size;
+  }
+
+  link_close(&vs);
+  link_close(&fs);
+  return linked;
+}
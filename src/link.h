@@ -0,0 +1,17 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+/*
+  links the SPIR-V of a vertex and a fragment shader that are used together:
+
+    - vertex outputs the fragment shader never reads are removed, together with
+      every instruction that only existed to compute them
+    - fragment inputs that are never read are removed
+    - the remaining locations of both stages are compacted to start at 0
+
+  vertex inputs and fragment outputs keep their locations. both modules are
+  replaced by linked copies and the old ones are freed with SDL_free. returns
+  false and leaves them untouched when they can't be linked, like modules with
+  several entry points or varyings in blocks.
+*/
+bool spirv_link(void **vertex, size_t *vertex_size, void **fragment, size_t *fragment_size);
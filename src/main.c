@@ -1,24 +1,40 @@
+#include "cache.h"
+#include "codegen.h"
 #include "common.h"
+#include "jobserver.h"
+#include "compile.h"
+#include "hash.h"
+#include "manifest.h"
+#include "memory.h"
+#include "pack.h"
+#include "scan.h"
+#include "server.h"
+#include "stats.h"
+#include "strip.h"
 #include "vector.h"
 
 #include <SDL3/SDL_gpu.h>
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_cpuinfo.h>
 #include <SDL3/SDL_filesystem.h>
-#include <SDL3_shadercross/SDL_shadercross.h>
-#include <SDL3/SDL_endian.h>
-#include <shaderc/shaderc.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_platform.h>
+#include <SDL3/SDL_thread.h>
+#include <SDL3/SDL_time.h>
+#include <SDL3/SDL_timer.h>
 
+#include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
-typedef uint32_t SDL_SHADER_Lang;
-enum {
-  SDL_SHADER_LANG_UNKNOWN,
-  SDL_SHADER_LANG_GLSL,
-  SDL_SHADER_LANG_SPIRV,
-  SDL_SHADER_LANG_HLSL
-};
+#ifdef SDL_PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 struct SDL_SHADER_Input 
 {
@@ -27,6 +43,13 @@ struct SDL_SHADER_Input
   SDL_SHADER_Type type;
   SDL_SHADER_Lang lang;
   SDL_Time last_modified;
+
+  // per input settings from a manifest, the command line ones are used when unset
+  char *entry;
+  char *target;
+  SDL_GPUShaderFormat formats;
+  struct Vector *defines;
+  struct Vector *constants;
 };
 
 struct SDL_SHADER_Output 
@@ -35,30 +58,95 @@ struct SDL_SHADER_Output
   bool folder;
 };
 
+// a folder that gets a copy of every output with only some formats
+struct SDL_SHADER_Slice
+{
+  SDL_GPUShaderFormat formats;
+  char *folder;
+};
+
 struct SDL_SHADER_State
 {
   struct Vector *inputs;
   struct Vector *outputs;
+  struct Vector *includes;
+  struct Vector *excludes;
+  struct Vector *defines;
+  struct Vector *constants;
+  struct Vector *manifests;
+  struct Vector *slices;
   
   SDL_SHADER_Type shader_type;
   SDL_GPUShaderFormat shader_formats;
   
   char* extension;
   char* entry;
+  char* pack;
+  char* socket;
+  char* cache;
+  char* stats_json;
+  int jobs;
+  SDL_SHADER_Lang lang;
+  FILE* data; // the real stdout when blobs are written there
+  float compact_threshold;
+
+  // opened before any other descriptor, see main
+  struct Jobserver jobserver;
+  bool has_jobserver;
+
+  // errors printed by any thread, the exit status
+  SDL_AtomicInt failures;
   
   bool recompile;
+  bool server;
+  bool remote;
+  bool stream;
+  bool strip;
+  bool link;
+  bool memory;
+  bool stats;
+  bool verify;
+  bool recursive;
+  bool skip_unchanged;
+  bool reflect;
+  bool header;
   bool sync;
   bool silent;
   bool is_output;
   bool is_extension;
   bool is_entry;
+  bool is_pack;
+  bool is_compact;
+  bool is_include;
+  bool is_exclude;
+  bool is_define;
+  bool is_spec;
+  bool is_manifest;
+  bool is_socket;
+  bool is_cache;
+  bool is_jobs;
+  bool is_lang;
+  bool is_slice;
+  bool is_stats_json;
 };
 
+// prints an error and remembers that the run failed
+void print_error(struct SDL_SHADER_State *state, const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+
+  SDL_AtomicIncRef(&state->failures);
+}
+
 void print_help()
 {
   printf("%s", "sdlshader"); 
   printf("%s", "\n\tUSAGE:");
-  printf("%s", "\n\t\tsdlshader -[vertex/fragment/compute] <input> -o <output> [options]\n\n");
+  printf("%s", "\n\t\tsdlshader -[vertex/fragment/compute] <input> -o <output> [options]\n");
+  printf("%s", "\t\tsdlshader strip --[spv/msl/dxil/dxbc] <blobs or packs> -o <output>\n\n");
   printf("%s", "\t\t<input>:  \tone or multiple GLSL, SPIRV, OR HLSL shader files or folders.\n");
   printf("%s", "\t\t<output>: \trespective output files or folder.\n");
   printf("%s", "\t\tFolders are marked with a \"/\", \"\\\", or \".\". For example \"test/\" is a folder." );
@@ -82,312 +170,448 @@ void print_help()
   printf("%s", "\t\t-h, --help: shows this message\n");
   printf("%s", "\t\t-o, --out/output: where the output is going.\n");
   printf("%s", "\t\t-e, --entry: the entry point of the shader code, defaults to \"main\".\n");
+  printf("%s", "\t\t\tseveral entry points of one source are compiled together with \"<name>:<stage>,...\" like \"VSMain:vertex,PSMain:fragment\",\n");
+  printf("%s", "\t\t\teach gets its own output named after the entry, like \"shader.VSMain.bin\".\n");
+  printf("%s", "\t\t-D <name[=value]>: defines a preprocessor macro for every input, can be repeated.\n");
+  printf("%s", "\t\t--spec <id|name=value>: bakes a specialization constant into every input, folding the branches it decides. can be repeated.\n");
+  printf("%s", "\t\t--manifest <file>: compiles every shader listed in the file, one per line:\n");
+  printf("%s", "\t\t\t<input> [stage=vertex/fragment/compute] [entry=<name[:stage],...>] [define=<name[=value]>] [spec=<id|name=value>] [formats=spv,msl,dxil,dxbc] [output=<file>]\n");
   printf("%s", "\t\t--extension: the output extension when using folders, defaults to \".bin\".\n");
+  printf("%s", "\t\t-r, --recursive: also scans the sub folders of input folders, outputs keep the folder structure. linked folders are skipped.\n");
+  printf("%s", "\t\t--include <glob>: only takes files matching the pattern from the input folders that follow, can be repeated.\n");
+  printf("%s", "\t\t--exclude <glob>: skips files and folders matching the pattern in the input folders that follow, can be repeated.\n");
+  printf("%s", "\t\t\tpatterns support \"*\", \"?\" and \"**\", without a \"/\" they match the file name only.\n");
+  printf("%s", "\t\t--pack <file>: stores every output in a single pack file, only changed shaders are rewritten.\n");
+  printf("%s", "\t\t--compact <ratio>: compacts the pack once unused space passes this fraction of it, defaults to 0.5.\n");
+  printf("%s", "\t\t--slice <formats>=<folder>: also writes a copy of every output with only these formats into the folder, can be repeated.\n");
+  printf("%s", "\t\t\tlike \"--slice spv=build/vulkan/ --slice dxil,dxbc=build/d3d/\", -o is optional then.\n");
+  printf("%s", "\t\tstrip: copies compiled blobs or packs keeping only the formats given, without recompiling.\n");
+  printf("%s", "\t\t-: reads the input from stdin or writes the output to stdout, messages go to stderr then.\n");
+  printf("%s", "\t\t--lang <glsl/hlsl/spv>: the language of inputs without a known extension, like stdin.\n");
+  printf("%s", "\t\t--stream: compiles requests from stdin until it closes, each a line of settings then the source ending in a NUL byte.\n");
+  printf("%s", "\t\t\tsettings are key=value like in manifests, plus name=<file name for errors>.\n");
+  printf("%s", "\t\t\teach response is a line \"ok <size>\" followed by the blob, or \"error <size>\" followed by the errors.\n");
+  printf("%s", "\t\t-j, --jobs <count>: how many shaders compile at once, defaults to the number of cores. inside \"make -j\" the jobserver limits it further.\n");
+  printf("%s", "\t\t--server: runs a compile server that keeps the compilers warm and caches results for other invocations.\n");
+  printf("%s", "\t\t--remote: sends compiles to a running server, compiles locally when there is none.\n");
+  printf("%s", "\t\t--socket <path>: the socket of the server, defaults to \"$XDG_RUNTIME_DIR/sdlshader.sock\" or a private folder in /tmp.\n");
   printf("%s", "\t\t--silent: disables all outputs, except errors.\n");
   printf("%s", "\t\t--recompile: wipe and recompile cached shaders.\n");
+  printf("%s", "\t\t--cache <folder>: keeps the SPIR-V of every source in the folder, later builds that only change formats or outputs just run the back-ends.\n");
+  printf("%s", "\t\t--stats: prints instruction, register, loop and branch counts, resources and output sizes of every compiled shader, heaviest first. every input is compiled so the report is complete.\n");
+  printf("%s", "\t\t--stats-json <file>: writes the same figures as JSON, sorted by name so reports of two builds diff well.\n");
+  printf("%s", "\t\t--verify-reproducible: compiles every input twice without the SPIR-V cache and reports outputs that aren't byte identical and exits with 1, outputs are optional.\n");
+  printf("%s", "\t\t--memory: counts every allocation and prints the peak heap use, allocations per stage and what is still allocated at exit.\n");
+  printf("%s", "\t\t--link: compiles each vertex shader together with the fragment shader right after it and removes the varyings it never reads.\n");
+  printf("%s", "\t\t--skip-unchanged: leaves outputs that are byte identical untouched, keeping their modify time. the --cache folder remembers them as up to date, without it they are compiled again next time.\n");
+  printf("%s", "\t\t--reflect: stores resource names, bindings and block layouts in the output.\n");
+  printf("%s", "\t\t--header: writes a C/C++ header with the uniform and storage block structs next to each output.\n");
  //printf("%s", "\t\t--sync-folders [DANGEROUS!]: delete any content of the target folder that doesn't match any corresponding input.\n\n");
 }
 
-Uint8 *write_le32(Uint8 *dst, Uint32 value)
-{
-  Uint32 tmp = SDL_Swap32LE(value);
-  SDL_memcpy(dst, &tmp, sizeof(Uint32));
-  return dst + sizeof(Uint32);
-}
-
-Uint8 *write_le64(Uint8 *dst, Uint64 value)
-{
-  Uint64 tmp = SDL_Swap64LE(value);
-  SDL_memcpy(dst, &tmp, sizeof(Uint64));
-  return dst + sizeof(Uint64);
-}
-
-void* encode(struct SDL_SHADER_Blob *blob, size_t *size)
+// adds an input, relative is the path inside a scanned folder or NULL for a single file
+struct SDL_SHADER_Input *add_input(struct SDL_SHADER_State *state, char* path, const char* relative, SDL_Time last_modified)
 {
-  // calculate file size
-  size_t bin_size = 0;
-  bin_size += 8 * sizeof(Uint32);
-  bin_size += sizeof(char) * blob->entry_size + 1;
-  bin_size += blob->num_shaders * (sizeof(size_t) + sizeof(SDL_GPUShaderFormat));
-
-  if (blob->type == SDL_SHADER_TYPE_COMPUTE)
+  struct SDL_SHADER_Input *input = SDL_malloc(sizeof(struct SDL_SHADER_Input));
+  input->path = path;
+  input->type = state->shader_type;
+  input->last_modified = last_modified;
+  input->entry = NULL;
+  input->target = NULL;
+  input->formats = 0;
+  input->defines = NULL;
+  input->constants = NULL;
+
+  // set the shader langauge based on file extension
+  size_t len = SDL_strlen(path);
+  if (len > 6 && SDL_strcmp(&path[len - 5], ".glsl") == 0)
+  {
+    input->lang = SDL_SHADER_LANG_GLSL;
+  }
+  else if (len > 6 && SDL_strcmp(&path[len - 5], ".hlsl") == 0)
+  {
+    input->lang = SDL_SHADER_LANG_HLSL;
+  }
+  else if (len > 5 && SDL_strcmp(&path[len - 4], ".spv") == 0)
+  {
+    input->lang = SDL_SHADER_LANG_SPIRV;
+  }
+  else 
   {
-    bin_size += 5 * sizeof(Uint32);
+    input->lang = SDL_SHADER_LANG_UNKNOWN;
   }
 
-  for (int i = 0; i < blob->num_shaders; i++) 
+  // the size of the extension string
+  int extension_offset = 0;
+  if (input->lang == SDL_SHADER_LANG_GLSL || input->lang == SDL_SHADER_LANG_HLSL)
+  {
+    extension_offset = 5;
+  }
+  else if (input->lang == SDL_SHADER_LANG_SPIRV)
   {
-    bin_size += blob->shaders[i]->code_size;
+    extension_offset = 4;
   }
 
-  // prepare the binary blob
-  Uint8* bin = SDL_malloc(bin_size);
-  size_t pos = 0;
+  int base_size = 0;
+  if (relative != NULL)
+  {
+    // relative path without the extension, keeps the folder structure in the output
+    base_size = SDL_strlen(relative) - extension_offset + 1;
+    input->base = SDL_calloc(base_size, sizeof(char));
+    SDL_strlcat(input->base, relative, base_size);
+  }
+  else 
+  {
+    // skip to the last \ or / 
+    int filename_start = -1;
+    for (int i = 0; i < len; i++) 
+    {
+      if (path[i] == '/' || path[i] == '\\')
+      {
+        filename_start = i;
+      }
+    }
 
-  Uint8* p = bin;
-  p = write_le32(p, blob->formats);
-  p = write_le32(p, blob->type);
-  p = write_le32(p, blob->num_samplers);
-  p = write_le32(p, blob->num_uniform_buffers);
-  p = write_le32(p, blob->num_storage_buffers);
-  p = write_le32(p, blob->num_storage_textures);
+    // filename without the extension
+    base_size = len - filename_start - extension_offset;
+    input->base = SDL_calloc(base_size, sizeof(char));
+    SDL_strlcat(input->base, &path[filename_start + 1], base_size);
+  }
 
-  if (blob->type == SDL_SHADER_TYPE_COMPUTE)
+  // figure out the shader type based on file name
+  if (base_size > 6 && SDL_strcmp(&input->base[base_size - 6], ".vert") == 0)
+  {
+    input->type = SDL_SHADER_TYPE_VERTEX;
+  }
+  else if (base_size > 6 && SDL_strcmp(&input->base[base_size - 6], ".frag") == 0)
+  {
+    input->type = SDL_SHADER_TYPE_FRAGMENT;
+  }
+  else if (base_size > 6 && SDL_strcmp(&input->base[base_size - 6], ".comp") == 0)
   {
-    p = write_le32(p, blob->num_storage_buffers_readonly);
-    p = write_le32(p, blob->num_storage_textures_readonly);
-    p = write_le32(p, blob->thread_x);
-    p = write_le32(p, blob->thread_y);
-    p = write_le32(p, blob->thread_z);
+    input->type = SDL_SHADER_TYPE_COMPUTE;
   }
 
-  p = write_le32(p, blob->num_shaders);
-  p = write_le32(p, blob->entry_size);
+  vector_push(state->inputs, input);
+  return input;
+}
 
-  SDL_memcpy(p, blob->entry, blob->entry_size * sizeof(char));
-  p += blob->entry_size * sizeof(char);
+// parses a comma separated list like "spv,msl"
+bool parse_formats(char* list, SDL_GPUShaderFormat *formats)
+{
+  *formats = 0;
 
-  for (int i = 0; i < blob->num_shaders; i++)
+  char* format = list;
+  while (format != NULL)
   {
-    p = write_le32(p, blob->shaders[i]->format);
-    p = write_le64(p, blob->shaders[i]->code_size);
+    char* next = SDL_strchr(format, ',');
+    if (next != NULL)
+    {
+      *next++ = '\0';
+    }
+
+    if (SDL_strcmp(format, "spv") == 0 || SDL_strcmp(format, "spirv") == 0)
+    {
+      *formats |= SDL_GPU_SHADERFORMAT_SPIRV;
+    }
+    else if (SDL_strcmp(format, "msl") == 0)
+    {
+      *formats |= SDL_GPU_SHADERFORMAT_MSL;
+    }
+    else if (SDL_strcmp(format, "dxil") == 0)
+    {
+      *formats |= SDL_GPU_SHADERFORMAT_DXIL;
+    }
+    else if (SDL_strcmp(format, "dxbc") == 0)
+    {
+      *formats |= SDL_GPU_SHADERFORMAT_DXBC;
+    }
+    else
+    {
+      return false;
+    }
 
-    SDL_memcpy(p, blob->shaders[i]->code, blob->shaders[i]->code_size);
-    p += blob->shaders[i]->code_size;
+    format = next;
   }
 
-  *size = bin_size;
-  return bin;
+  return *formats != 0;
 }
 
-struct SDL_SHADER_Blob* compile(void* code, size_t code_size, SDL_SHADER_Type type, SDL_SHADER_Lang lang, SDL_GPUShaderFormat formats, char *entry, char* filename, size_t *size)
+// parses "glsl", "hlsl" or "spv"
+SDL_SHADER_Lang parse_lang(const char* name)
 {
-  struct SDL_SHADER_Blob blob = {0};
-  blob.type = type;
-  blob.entry_size = SDL_strlen(entry) + 1; // the 1 is for \0
-  blob.entry = entry;
-  blob.num_shaders = 0;
-  blob.shaders = SDL_malloc(4 * sizeof(void*));
+  if (SDL_strcmp(name, "glsl") == 0)
+  {
+    return SDL_SHADER_LANG_GLSL;
+  }
+  else if (SDL_strcmp(name, "hlsl") == 0)
+  {
+    return SDL_SHADER_LANG_HLSL;
+  }
+  else if (SDL_strcmp(name, "spv") == 0 || SDL_strcmp(name, "spirv") == 0)
+  {
+    return SDL_SHADER_LANG_SPIRV;
+  }
+
+  return SDL_SHADER_LANG_UNKNOWN;
+}
 
-  // convert the shader type to the stage used SDL_Shadercross
-  SDL_ShaderCross_ShaderStage stage;
-  if (type == SDL_SHADER_TYPE_VERTEX)
+// parses "vertex", "fragment" or "compute" and their short forms
+bool parse_stage(const char* name, SDL_SHADER_Type *type)
+{
+  if (SDL_strcmp(name, "vertex") == 0 || SDL_strcmp(name, "vert") == 0)
+  {
+    *type = SDL_SHADER_TYPE_VERTEX;
+  }
+  else if (SDL_strcmp(name, "fragment") == 0 || SDL_strcmp(name, "frag") == 0)
   {
-    stage = SDL_SHADERCROSS_SHADERSTAGE_VERTEX;
+    *type = SDL_SHADER_TYPE_FRAGMENT;
   }
-  else if (type == SDL_SHADER_TYPE_FRAGMENT)
+  else if (SDL_strcmp(name, "compute") == 0 || SDL_strcmp(name, "comp") == 0)
   {
-    stage = SDL_SHADERCROSS_SHADERSTAGE_FRAGMENT;
+    *type = SDL_SHADER_TYPE_COMPUTE;
   }
-  else if (type == SDL_SHADER_TYPE_COMPUTE)
+  else
   {
-    stage = SDL_SHADERCROSS_SHADERSTAGE_COMPUTE;
+    return false;
   }
 
-  size_t spirv_size;
-  void* spirv;
+  return true;
+}
+
+// splits a list like "VSMain:vertex,PSMain:fragment" into entry points, a missing stage is the type of the input.
+// the names point into list, returns the number of entries or 0 when invalid
+int parse_entries(char* list, SDL_SHADER_Type type, struct SDL_SHADER_Entry *entries)
+{
+  int num_entries = 0;
 
-  if (lang == SDL_SHADER_LANG_GLSL)
+  char* name = list;
+  while (name != NULL)
   {
-    // compile GLSL to SPIRV
-    shaderc_compiler_t compiler = shaderc_compiler_initialize();
-    shaderc_compile_options_t options = shaderc_compile_options_initialize();
+    char* next = SDL_strchr(name, ',');
+    if (next != NULL)
+    {
+      *next++ = '\0';
+    }
 
-    shaderc_shader_kind kind;
-    if (type == SDL_SHADER_TYPE_VERTEX)
+    if (*name == '\0' || num_entries == SDL_SHADER_MAX_ENTRIES)
     {
-      kind = shaderc_glsl_vertex_shader;
+      return 0;
     }
-    else if (type == SDL_SHADER_TYPE_FRAGMENT)
+
+    struct SDL_SHADER_Entry *entry = &entries[num_entries++];
+    entry->name = name;
+    entry->type = type;
+
+    char* stage = SDL_strchr(name, ':');
+    if (stage != NULL)
     {
-      kind = shaderc_glsl_fragment_shader;
+      *stage++ = '\0';
+      if (*name == '\0' || !parse_stage(stage, &entry->type))
+      {
+        return 0;
+      }
     }
-    else if (type == SDL_SHADER_TYPE_COMPUTE)
+
+    name = next;
+  }
+
+  return num_entries;
+}
+
+// applies a key=value setting of a manifest or stream request, false when unknown or invalid
+bool apply_setting(struct SDL_SHADER_Input *input, const char* key, char* value)
+{
+  if (SDL_strcmp(key, "stage") == 0)
+  {
+    return parse_stage(value, &input->type);
+  }
+  else if (SDL_strcmp(key, "lang") == 0)
+  {
+    input->lang = parse_lang(value);
+    return input->lang != SDL_SHADER_LANG_UNKNOWN;
+  }
+  else if (SDL_strcmp(key, "entry") == 0)
+  {
+    input->entry = value;
+  }
+  else if (SDL_strcmp(key, "define") == 0)
+  {
+    if (input->defines == NULL)
     {
-      kind = shaderc_glsl_compute_shader;
+      input->defines = vector_create(8);
     }
 
-    shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler, code, code_size, kind, filename, entry, options);
-    if (shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success) 
+    vector_push(input->defines, value);
+  }
+  else if (SDL_strcmp(key, "spec") == 0)
+  {
+    if (SDL_strchr(value, '=') == NULL)
     {
-      printf("ERROR: GLSL: %s\n", shaderc_result_get_error_message(result));
-      spirv = NULL;
-      spirv_size = 0;
+      return false;
     }
-    else
+
+    if (input->constants == NULL)
     {
-      spirv_size = shaderc_result_get_length(result);
-      spirv = SDL_malloc(spirv_size);
-      SDL_memcpy(spirv, (uint8_t*)shaderc_result_get_bytes(result), spirv_size);
+      input->constants = vector_create(8);
     }
 
-    shaderc_result_release(result);
-    shaderc_compile_options_release(options);
-    shaderc_compiler_release(compiler);
+    vector_push(input->constants, value);
   }
-
-  else if (lang == SDL_SHADER_LANG_HLSL)
+  else if (SDL_strcmp(key, "formats") == 0)
   {
-    // compile HLSL to SPIRV
-    SDL_ShaderCross_HLSL_Info hlsl_info = {0};
-    hlsl_info.source = code;
-    hlsl_info.entrypoint = entry;
-    hlsl_info.shader_stage = stage;
-    hlsl_info.defines = NULL;
-    hlsl_info.include_dir = NULL;
-    hlsl_info.props = 0;
-   
-    spirv = SDL_ShaderCross_CompileSPIRVFromHLSL(&hlsl_info, &spirv_size);
-  
-    if (spirv == NULL)
-    {
-      printf("ERROR: HLSL: %s\n",  SDL_GetError());
-    }
+    return parse_formats(value, &input->formats);
   }
-  else 
+  else if (SDL_strcmp(key, "output") == 0)
   {
-    spirv = SDL_malloc(code_size);
-    SDL_memcpy(spirv, code, code_size);
-    spirv_size = code_size;
+    input->target = value;
   }
-
-  // failed to compile spirv
-  if (spirv == NULL)
+  else
   {
-    SDL_free(blob.shaders);
-    *size = 0;
-    return NULL; 
+    return false;
   }
 
-  // shader info
-  SDL_ShaderCross_SPIRV_Info spirv_info = {0};
-  spirv_info.shader_stage = stage;
-  spirv_info.bytecode = spirv;
-  spirv_info.bytecode_size = spirv_size;
-  spirv_info.entrypoint = entry;
+  return true;
+}
 
-  // reflection
-  if (type == SDL_SHADER_TYPE_COMPUTE)
+// adds every shader listed in a manifest, the text stays alive as the inputs point into it
+void load_manifest(struct SDL_SHADER_State *state, const char* path)
+{
+  char* text = SDL_LoadFile(path, NULL);
+  if (text == NULL)
   {
-    SDL_ShaderCross_ComputePipelineMetadata* metadata = SDL_ShaderCross_ReflectComputeSPIRV(spirv, spirv_size, 0);
-    
-    blob.num_samplers = metadata->num_samplers;
-    blob.num_uniform_buffers = metadata->num_uniform_buffers;
-    blob.num_storage_buffers = metadata->num_readwrite_storage_buffers;
-    blob.num_storage_textures = metadata->num_readwrite_storage_textures;
-    blob.num_storage_buffers_readonly = metadata->num_readonly_storage_buffers;
-    blob.num_storage_textures_readonly = metadata->num_readonly_storage_textures;
-    blob.thread_x = metadata->threadcount_x;
-    blob.thread_y = metadata->threadcount_y;
-    blob.thread_z = metadata->threadcount_z;
-
-    SDL_free(metadata);
+    print_error(state, "ERROR: could not open manifest \"%s\".\n", path);
+    return;
   }
-  else
-  {
-    SDL_ShaderCross_GraphicsShaderMetadata* metadata = SDL_ShaderCross_ReflectGraphicsSPIRV(spirv, spirv_size, 0);
 
-    blob.num_samplers = metadata->resource_info.num_samplers;
-    blob.num_uniform_buffers = metadata->resource_info.num_uniform_buffers;
-    blob.num_storage_buffers = metadata->resource_info.num_storage_buffers;
-    blob.num_storage_textures = metadata->resource_info.num_storage_textures;
-   
-    SDL_free(metadata);
-  }
+  vector_push(state->manifests, text);
+
+  char* cursor = text;
+  char* line;
+  int line_number = 0;
 
-  // DXIL
-  if (formats & SDL_GPU_SHADERFORMAT_DXIL)
+  while ((line = manifest_next_line(&cursor)) != NULL)
   {
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct  SDL_SHADER_Code));
-    shader->code = SDL_ShaderCross_CompileDXILFromSPIRV(&spirv_info, &shader->code_size);
-    shader->format = SDL_GPU_SHADERFORMAT_DXIL;
+    line_number++;
 
-    if (shader->code == NULL)
-    {
-      printf("ERROR: DXIL: %s\n", SDL_GetError());
-      formats &= ~SDL_GPU_SHADERFORMAT_DXIL;
-      SDL_free(shader);
-    }
-    else 
+    char* tokens[64];
+    int count = manifest_tokenize(line, tokens, SDL_arraysize(tokens));
+    if (count == 0)
     {
-      blob.shaders[blob.num_shaders] = shader;
-      blob.num_shaders += 1;
+      continue;
     }
-  }
 
-  // DXBC
-  if (formats & SDL_GPU_SHADERFORMAT_DXBC)
-  {
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct  SDL_SHADER_Code));
-    shader->code = SDL_ShaderCross_CompileDXBCFromSPIRV(&spirv_info, &shader->code_size);
-    shader->format = SDL_GPU_SHADERFORMAT_DXBC;
- 
-    if (shader->code == NULL)
+    // skip missing files
+    SDL_PathInfo info = {0};
+    if (!SDL_GetPathInfo(tokens[0], &info))
     {
-      printf("ERROR: DXBC: %s\n", SDL_GetError());
-      formats &= ~SDL_GPU_SHADERFORMAT_DXBC;
-      SDL_free(shader);
+      print_error(state, "ERROR: %s:%d: \"%s\" does not exist.\n", path, line_number, tokens[0]);
+      continue;
     }
-    else 
+
+    struct SDL_SHADER_Input *input = add_input(state, SDL_strdup(tokens[0]), NULL, info.modify_time);
+
+    for (int i = 1; i < count; i++)
     {
-      blob.shaders[blob.num_shaders] = shader;
-      blob.num_shaders += 1;
+      char* key = tokens[i];
+      char* value = manifest_split(key);
+
+      if (value == NULL)
+      {
+        print_error(state, "ERROR: %s:%d: expected key=value, got \"%s\".\n", path, line_number, key);
+      }
+      else if (!apply_setting(input, key, value))
+      {
+        print_error(state, "ERROR: %s:%d: invalid setting \"%s=%s\".\n", path, line_number, key, value);
+      }
     }
   }
+}
 
-  // MSL
-  if (formats & SDL_GPU_SHADERFORMAT_MSL)
+// merges the settings of an input with the command line ones, free with free_settings
+void resolve_settings(struct SDL_SHADER_State *state, struct SDL_SHADER_Input *input, struct SDL_SHADER_Settings *settings)
+{
+  settings->type = input->type;
+  settings->lang = input->lang;
+  settings->formats = input->formats != 0 ? input->formats : state->shader_formats;
+  settings->entry = input->entry != NULL ? input->entry : state->entry;
+  settings->filename = input->path;
+  settings->reflect = state->reflect;
+
+  // command line defines first, so the manifest ones can override them
+  settings->defines = vector_create(state->defines->size + 8);
+  for (size_t i = 0; i < state->defines->size; i++)
   {
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct  SDL_SHADER_Code));
-    shader->code = SDL_ShaderCross_TranspileMSLFromSPIRV(&spirv_info);
-    shader->code_size = SDL_strlen(shader->code) + 1;
-    shader->format = SDL_GPU_SHADERFORMAT_MSL;
+    vector_push(settings->defines, vector_get(state->defines, i));
+  }
 
-    if (shader->code == NULL)
+  if (input->defines != NULL)
+  {
+    for (size_t i = 0; i < input->defines->size; i++)
     {
-      printf("ERROR: MSL: %s\n", SDL_GetError());
-      formats &= ~SDL_GPU_SHADERFORMAT_MSL;
-      SDL_free(shader);
+      vector_push(settings->defines, vector_get(input->defines, i));
     }
-    else 
+  }
+
+  // the same for spec constants, the last value of a constant wins
+  settings->constants = vector_create(state->constants->size + 8);
+  for (size_t i = 0; i < state->constants->size; i++)
+  {
+    vector_push(settings->constants, vector_get(state->constants, i));
+  }
+
+  if (input->constants != NULL)
+  {
+    for (size_t i = 0; i < input->constants->size; i++)
     {
-      blob.shaders[blob.num_shaders] = shader;
-      blob.num_shaders += 1;
+      vector_push(settings->constants, vector_get(input->constants, i));
     }
   }
+}
 
+void free_settings(struct SDL_SHADER_Settings *settings)
+{
+  vector_delete(settings->defines);
+  vector_delete(settings->constants);
+}
 
-  // SPIRV
-  if (formats & SDL_GPU_SHADERFORMAT_SPIRV)
+// compiles on the server when connected, locally otherwise
+void* build(int *connection, void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size)
+{
+  if (*connection >= 0)
   {
-    struct SDL_SHADER_Code *shader = SDL_malloc(sizeof(struct  SDL_SHADER_Code));
-    shader->code = spirv;
-    shader->code_size = spirv_size;
-    shader->format = SDL_GPU_SHADERFORMAT_SPIRV;
-  
-    blob.shaders[blob.num_shaders] = shader;
-    blob.num_shaders += 1;
-  }
+    bool delivered;
+    void* bin = server_compile(*connection, code, code_size, settings, reflection, size, &delivered);
 
+    if (delivered)
+    {
+      return bin;
+    }
 
-  // save compiled formats
-  blob.formats = formats;
+    printf("WARNING: lost the compile server, compiling locally.\n");
+    server_disconnect(*connection);
+    *connection = -1;
+  }
 
-  // convert to a binary blob
-  size_t bin_size;
-  void* bin = encode(&blob, &bin_size);
+  return compile(code, code_size, settings, reflection, size);
+}
 
-  // free the blob
-  for (int i = 0; i < blob.num_shaders; i++)
+// compiles every entry point of a source, the server gets them one by one
+void build_entries(int *connection, void* code, size_t code_size, const struct SDL_SHADER_Settings *settings, const struct SDL_SHADER_Entry *entries, int num_entries, SDL_SHADER_Reflection **reflections, void **bins, size_t *sizes)
+{
+  if (*connection < 0)
   {
-    SDL_free(blob.shaders[i]->code);
+    compile_entries(code, code_size, settings, entries, num_entries, reflections, bins, sizes);
+    return;
   }
 
-  SDL_free(blob.shaders);
-  
-  // return
-  *size = bin_size;
-  return bin;
+  struct SDL_SHADER_Settings entry_settings = *settings;
+  for (int i = 0; i < num_entries; i++)
+  {
+    entry_settings.entry = entries[i].name;
+    entry_settings.type = entries[i].type;
+    bins[i] = build(connection, code, code_size, &entry_settings, reflections != NULL ? &reflections[i] : NULL, &sizes[i]);
+  }
 }
 
 void parse_arg(struct SDL_SHADER_State *state, char* arg)
@@ -411,6 +635,115 @@ void parse_arg(struct SDL_SHADER_State *state, char* arg)
     state->is_extension = true;
     return;
   }
+  else if (SDL_strcmp(arg, "-D") == 0)
+  {
+    state->is_define = true;
+    return;
+  }
+  else if (SDL_strncmp(arg, "-D", 2) == 0)
+  {
+    vector_push(state->defines, arg + 2);
+    return;
+  }
+  else if (SDL_strcmp(arg, "--spec") == 0)
+  {
+    state->is_spec = true;
+    return;
+  }
+  // stdin or stdout, unless it is the value of an option
+  else if (SDL_strcmp(arg, "-") == 0 && !state->is_stats_json)
+  {
+    if (state->is_output)
+    {
+      struct SDL_SHADER_Output *output = SDL_malloc(sizeof(struct SDL_SHADER_Output));
+      output->path = SDL_strdup(arg);
+      output->folder = false;
+      vector_push(state->outputs, output);
+    }
+    else
+    {
+      struct SDL_SHADER_Input *input = add_input(state, SDL_strdup(arg), NULL, 0);
+      SDL_free(input->base);
+      input->base = SDL_strdup("stdin");
+    }
+
+    return;
+  }
+  else if (SDL_strcmp(arg, "--lang") == 0)
+  {
+    state->is_lang = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--slice") == 0)
+  {
+    state->is_slice = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--stream") == 0)
+  {
+    state->stream = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "-j") == 0 || SDL_strcmp(arg, "--jobs") == 0)
+  {
+    state->is_jobs = true;
+    return;
+  }
+  else if (SDL_strncmp(arg, "-j", 2) == 0)
+  {
+    state->jobs = SDL_atoi(arg + 2);
+    return;
+  }
+  else if (SDL_strcmp(arg, "--server") == 0)
+  {
+    state->server = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--remote") == 0)
+  {
+    state->remote = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--socket") == 0)
+  {
+    state->is_socket = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--cache") == 0)
+  {
+    state->is_cache = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--manifest") == 0)
+  {
+    state->is_manifest = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "-r") == 0 || SDL_strcmp(arg, "--recursive") == 0)
+  {
+    state->recursive = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--include") == 0)
+  {
+    state->is_include = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--exclude") == 0)
+  {
+    state->is_exclude = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--pack") == 0)
+  {
+    state->is_pack = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--compact") == 0)
+  {
+    state->is_compact = true;
+    return;
+  }
   else if (SDL_strcmp(arg, "--silent") == 0)
   {
     state->silent = true;
@@ -421,6 +754,47 @@ void parse_arg(struct SDL_SHADER_State *state, char* arg)
     state->recompile = true;
     return;
   }
+  else if (SDL_strcmp(arg, "--verify-reproducible") == 0)
+  {
+    state->verify = true;
+    state->recompile = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--stats") == 0)
+  {
+    state->stats = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--stats-json") == 0)
+  {
+    state->is_stats_json = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--memory") == 0)
+  {
+    state->memory = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--link") == 0)
+  {
+    state->link = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--skip-unchanged") == 0)
+  {
+    state->skip_unchanged = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--reflect") == 0)
+  {
+    state->reflect = true;
+    return;
+  }
+  else if (SDL_strcmp(arg, "--header") == 0)
+  {
+    state->header = true;
+    return;
+  }
   else if (SDL_strcmp(arg, "--sync-folders") == 0)
   {
     state->sync = true;
@@ -465,9 +839,9 @@ void parse_arg(struct SDL_SHADER_State *state, char* arg)
     state->shader_type = SDL_SHADER_TYPE_COMPUTE;
     return;
   }
-  else if (*arg == '-')
+  else if (*arg == '-' && !state->is_stats_json)
   {
-    printf("ERROR: unknown argument \"%s\".\n", arg);
+    print_error(state, "ERROR: unknown argument \"%s\".\n", arg);
     return;
   }
 
@@ -487,306 +861,1762 @@ void parse_arg(struct SDL_SHADER_State *state, char* arg)
     return;
   }
 
-  // check folders
-  char last = arg[SDL_strlen(arg) - 1];
-  bool is_folder = last == '/' || last == '\\' || last == '.';
-
-  // outputs
-  if (state->is_output)
+  // pack output
+  if (state->is_pack)
   {
-    struct SDL_SHADER_Output *output = SDL_malloc(sizeof(struct SDL_SHADER_Output));
-    output->path = SDL_strdup(arg);
-    output->folder = is_folder;
-    vector_push(state->outputs, output);
+    state->is_pack = false;
+    state->pack = arg;
     return;
   }
 
-  int count = 1;
-  char** files = NULL;
-  int arg_len = SDL_strlen(arg);
-  bool globbed = false;
+  // preprocessor macros
+  if (state->is_define)
+  {
+    state->is_define = false;
+    vector_push(state->defines, arg);
+    return;
+  }
 
-  // find all files in a directory
-  if (is_folder)
+  // specialization constants
+  if (state->is_spec)
   {
-    files = SDL_GlobDirectory(arg, NULL, 0, &count);
-    globbed = true;
-    
-    if (files == NULL)
+    state->is_spec = false;
+
+    if (SDL_strchr(arg, '=') == NULL)
+    {
+      print_error(state, "ERROR: expected <id|name=value> for --spec, got \"%s\".\n", arg);
+      return;
+    }
+
+    vector_push(state->constants, arg);
+    return;
+  }
+
+  // language of stdin
+  if (state->is_lang)
+  {
+    state->is_lang = false;
+    state->lang = parse_lang(arg);
+
+    if (state->lang == SDL_SHADER_LANG_UNKNOWN)
+    {
+      print_error(state, "ERROR: unknown language \"%s\".\n", arg);
+    }
+    return;
+  }
+
+  // platform specific copies
+  if (state->is_slice)
+  {
+    state->is_slice = false;
+
+    struct SDL_SHADER_Slice *slice = SDL_malloc(sizeof(struct SDL_SHADER_Slice));
+    char* folder = SDL_strchr(arg, '=');
+
+    if (folder != NULL)
+    {
+      *folder++ = '\0';
+    }
+
+    if (folder == NULL || *folder == '\0' || !parse_formats(arg, &slice->formats))
+    {
+      print_error(state, "ERROR: expected --slice <formats>=<folder>, like \"spv=build/vulkan/\".\n");
+      SDL_free(slice);
+      return;
+    }
+
+    char last = folder[SDL_strlen(folder) - 1];
+    SDL_asprintf(&slice->folder, "%s%s", folder, last == '/' || last == '\\' ? "" : "/");
+    vector_push(state->slices, slice);
+    return;
+  }
+
+  // parallel compiles
+  if (state->is_jobs)
+  {
+    state->is_jobs = false;
+    state->jobs = SDL_atoi(arg);
+    return;
+  }
+
+  // report for tools
+  if (state->is_stats_json)
+  {
+    state->is_stats_json = false;
+    state->stats_json = arg;
+    return;
+  }
+
+  // compile server
+  if (state->is_socket)
+  {
+    state->is_socket = false;
+    state->socket = arg;
+    return;
+  }
+
+  // spirv cache
+  if (state->is_cache)
+  {
+    state->is_cache = false;
+    state->cache = arg;
+    return;
+  }
+
+  // batch of shaders with their own settings
+  if (state->is_manifest)
+  {
+    state->is_manifest = false;
+    load_manifest(state, arg);
+    return;
+  }
+
+  // folder scan patterns
+  if (state->is_include)
+  {
+    state->is_include = false;
+    vector_push(state->includes, arg);
+    return;
+  }
+
+  if (state->is_exclude)
+  {
+    state->is_exclude = false;
+    vector_push(state->excludes, arg);
+    return;
+  }
+
+  if (state->is_compact)
+  {
+    state->is_compact = false;
+    state->compact_threshold = (float)SDL_strtod(arg, NULL);
+    return;
+  }
+
+  // check folders
+  char last = arg[SDL_strlen(arg) - 1];
+  bool is_folder = last == '/' || last == '\\' || last == '.';
+
+  // outputs
+  if (state->is_output)
+  {
+    struct SDL_SHADER_Output *output = SDL_malloc(sizeof(struct SDL_SHADER_Output));
+    output->path = SDL_strdup(arg);
+    output->folder = is_folder;
+    vector_push(state->outputs, output);
+    return;
+  }
+
+  // every matching file in a folder
+  if (is_folder)
+  {
+    SDL_PathInfo info = {0};
+    if (!SDL_GetPathInfo(arg, &info) || info.type != SDL_PATHTYPE_DIRECTORY)
+    {
+      print_error(state, "ERROR: folder \"%s\" does not exist.\n", arg);
+      return;
+    }
+
+    size_t arg_len = SDL_strlen(arg);
+    bool separator = arg[arg_len - 1] == '/' || arg[arg_len - 1] == '\\';
+    struct Vector *files = scan_directory(arg, state->recursive, state->includes, state->excludes);
+
+    for (size_t i = 0; i < files->size; i++)
+    {
+      struct Scan_File *file = vector_get(files, i);
+
+      char* path;
+      SDL_asprintf(&path, "%s%s%s", arg, separator ? "" : "/", file->name);
+      add_input(state, path, file->name, file->modify_time);
+    }
+
+    scan_free(files);
+    return;
+  }
+
+  // skip missing files
+  SDL_PathInfo info = {0};
+  if (!SDL_GetPathInfo(arg, &info))
+  {
+    print_error(state, "ERROR: \"%s\" does not exist.\n", arg);
+    return;
+  }
+
+  add_input(state, SDL_strdup(arg), NULL, info.modify_time);
+}
+
+// true when the file at path holds exactly data
+bool same_content(const char* path, const void* data, size_t size)
+{
+  SDL_PathInfo info;
+  if (!SDL_GetPathInfo(path, &info) || info.type != SDL_PATHTYPE_FILE || info.size != size)
+  {
+    return false;
+  }
+
+  SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+  if (io == NULL)
+  {
+    return false;
+  }
+
+  // compare in chunks instead of loading the whole file
+  Uint8 chunk[16 * 1024];
+  const Uint8* p = data;
+  size_t remaining = size;
+  bool same = true;
+
+  while (remaining > 0 && same)
+  {
+    size_t count = SDL_min(remaining, sizeof(chunk));
+    same = SDL_ReadIO(io, chunk, count) == count && SDL_memcmp(chunk, p, count) == 0;
+    p += count;
+    remaining -= count;
+  }
+
+  SDL_CloseIO(io);
+  return same;
+}
+
+// an output left untouched by --skip-unchanged stays older than its source, so the --cache folder
+// remembers when it was found identical. rewriting the output changes its modify time, which
+// no longer matches the record, so writes don't have to clean anything up
+void unchanged_key(const char* target, Uint8 key[HASH_SIZE])
+{
+  struct Hash hash;
+  hash_begin(&hash);
+  hash_update_string(&hash, "unchanged");
+  hash_update_string(&hash, target);
+  hash_end(&hash, key);
+}
+
+void mark_unchanged(struct SDL_SHADER_State *state, const char* target)
+{
+  SDL_PathInfo info;
+  SDL_Time now;
+  if (state->cache == NULL || !SDL_GetPathInfo(target, &info) || !SDL_GetCurrentTime(&now))
+  {
+    return;
+  }
+
+  Uint8 key[HASH_SIZE];
+  Uint8 record[16];
+  unchanged_key(target, key);
+  write_le64(write_le64(record, (Uint64)info.modify_time), (Uint64)now);
+
+  if (!cache_store(state->cache, key, record, sizeof(record)))
+  {
+    printf("WARNING: could not remember \"%s\" as unchanged: %s\n", target, SDL_GetError());
+  }
+}
+
+// true when the output was found identical to a compile of a source modified at last_modified or earlier
+bool is_unchanged(struct SDL_SHADER_State *state, const char* target, SDL_Time modify_time, SDL_Time last_modified)
+{
+  if (state->cache == NULL)
+  {
+    return false;
+  }
+
+  Uint8 key[HASH_SIZE];
+  unchanged_key(target, key);
+
+  size_t size;
+  Uint8* record = cache_load(state->cache, key, &size);
+  if (record == NULL)
+  {
+    return false;
+  }
+
+  Uint64 output_time = 0;
+  Uint64 checked_time = 0;
+  if (size == 16)
+  {
+    read_le64(read_le64(record, &output_time), &checked_time);
+  }
+
+  SDL_free(record);
+  return size == 16 && (SDL_Time)output_time == modify_time && (SDL_Time)checked_time > last_modified;
+}
+
+// writes through a temporary file and a rename, so readers never see a partial file
+bool write_output(struct SDL_SHADER_State *state, const char* target, const void* data, size_t size)
+{
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+
+  // leave identical files untouched, keeping their modify time
+  if (state->skip_unchanged && same_content(target, data, size))
+  {
+    if (!state->silent)
+    {
+      printf("UNCHANGED: \"%s\".\n", target);
+    }
+
+    mark_unchanged(state, target);
+    memory_stage(stage);
+    return true;
+  }
+
+  // unique per thread and time, so processes writing the same target don't share a temporary file
+  char* tmp;
+  SDL_asprintf(&tmp, "%s.%" SDL_PRIu64 ".%" SDL_PRIu64 ".tmp", target, SDL_GetCurrentThreadID(), SDL_GetTicksNS());
+
+  // create a directory and try again if failed
+  bool saved = SDL_SaveFile(tmp, data, size);
+  if (!saved)
+  {
+    char* dir = SDL_strdup(target);
+    uint32_t target_size = SDL_strlen(target);
+    uint32_t pos = 0;
+
+    // find the last slash
+    for (uint32_t i = 0; i < target_size; i++) 
+    {
+      if (target[i] == '/' || target[i] == '\\')
+      {
+        pos = i;
+      }
+    }
+
+    // terminate the strig early
+    dir[pos] = '\0';
+    SDL_CreateDirectory(dir);
+    SDL_free(dir);
+
+    saved = SDL_SaveFile(tmp, data, size);
+  }
+
+  if (!saved || !SDL_RenamePath(tmp, target))
+  {
+    print_error(state, "ERROR: could not write \"%s\": %s\n", target, SDL_GetError());
+    SDL_RemovePath(tmp);
+    SDL_free(tmp);
+    memory_stage(stage);
+    return false;
+  }
+
+  SDL_free(tmp);
+  memory_stage(stage);
+  return true;
+}
+
+// the target path with its extension replaced by .h
+char* header_path(const char* target)
+{
+  size_t len = SDL_strlen(target);
+  size_t end = len;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    if (target[i] == '.')
+    {
+      end = i;
+    }
+    else if (target[i] == '/' || target[i] == '\\')
+    {
+      end = len;
+    }
+  }
+
+  char* header = SDL_calloc(end + 3, sizeof(char));
+  SDL_memcpy(header, target, end);
+  SDL_strlcat(header, ".h", end + 3);
+  return header;
+}
+
+// the output of one entry point when an input has several, "out/blur.bin" becomes "out/blur.CSMain.bin"
+char* entry_target(const char* target, const char* entry)
+{
+  const char* name = target;
+  for (const char* c = target; *c != '\0'; c++)
+  {
+    if (*c == '/' || *c == '\\')
+    {
+      name = c + 1;
+    }
+  }
+
+  const char* extension = SDL_strrchr(name, '.');
+  if (extension == NULL || extension == name)
+  {
+    extension = name + SDL_strlen(name);
+  }
+
+  char* path;
+  SDL_asprintf(&path, "%.*s.%s%s", (int)(extension - target), target, entry, extension);
+  return path;
+}
+
+bool is_stdio(const char* path)
+{
+  return path != NULL && SDL_strcmp(path, "-") == 0;
+}
+
+// reads until the end of a stream, like SDL_LoadFile
+void* read_all(FILE* file, size_t *size)
+{
+  size_t capacity = 64 * 1024;
+  size_t used = 0;
+  Uint8* data = SDL_malloc(capacity + 1);
+
+  size_t count;
+  while ((count = fread(data + used, 1, capacity - used, file)) > 0)
+  {
+    used += count;
+
+    if (used == capacity)
+    {
+      capacity *= 2;
+      data = SDL_realloc(data, capacity + 1);
+    }
+  }
+
+  // terminated like SDL_LoadFile, the compilers may read the source as a string
+  data[used] = '\0';
+  *size = used;
+  return data;
+}
+
+// keeps stdout for blobs and sends every message to stderr instead
+FILE* claim_stdout(void)
+{
+  fflush(stdout);
+
+#ifdef SDL_PLATFORM_WINDOWS
+  _setmode(_fileno(stdin), _O_BINARY);
+  FILE* data = _fdopen(_dup(_fileno(stdout)), "wb");
+  _dup2(_fileno(stderr), _fileno(stdout));
+#else
+  FILE* data = fdopen(dup(fileno(stdout)), "wb");
+  dup2(fileno(stderr), fileno(stdout));
+#endif
+
+  return data;
+}
+
+// a single input to compile, the target is NULL when writing into a pack
+struct SDL_SHADER_Job
+{
+  struct SDL_SHADER_Input *input;
+  char* target;
+  bool owns_target;
+
+  // every entry point gets its own output, named after the entry when there are several
+  char* entry_list;
+  struct SDL_SHADER_Entry entries[SDL_SHADER_MAX_ENTRIES];
+  int num_entries;
+
+  // --link compiles a vertex job together with the fragment job right after it
+  bool links_next;
+  bool linked;
+
+  // up to date, dropped before compiling
+  bool compiled;
+
+  // pack results waiting to be committed
+  void* bins[SDL_SHADER_MAX_ENTRIES];
+  size_t bin_sizes[SDL_SHADER_MAX_ENTRIES];
+  bool done;
+};
+
+struct SDL_SHADER_Jobs
+{
+  struct SDL_SHADER_State *state;
+  struct SDL_SHADER_Job *jobs;
+  int num_jobs;
+  SDL_AtomicInt next;
+
+  // blobs go into the pack in input order, so its layout doesn't depend on timing
+  struct Pack_Writer *writer;
+  SDL_Mutex *mutex;
+  int next_commit;
+
+  // figures of every compiled entry point for --stats
+  struct Vector *stats;
+};
+
+struct SDL_SHADER_Worker
+{
+  struct SDL_SHADER_Jobs *jobs;
+  bool implicit_slot; // runs on the slot every process owns, without a token
+};
+
+// splits the entry points of an input into the job, false when they are invalid
+bool job_entries(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job)
+{
+  struct SDL_SHADER_Input *input = job->input;
+
+  job->entry_list = SDL_strdup(input->entry != NULL ? input->entry : jobs->state->entry);
+  job->num_entries = parse_entries(job->entry_list, input->type, job->entries);
+
+  if (job->num_entries == 0)
+  {
+    print_error(jobs->state, "ERROR: invalid entry points \"%s\" for \"%s\", expected up to %d of <name>[:vertex/fragment/compute].\n", input->entry != NULL ? input->entry : jobs->state->entry, input->path, SDL_SHADER_MAX_ENTRIES);
+    SDL_free(job->entry_list);
+    job->entry_list = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+// the pack name of an entry point, free with SDL_free
+char* job_name(struct SDL_SHADER_Job *job, int entry)
+{
+  if (job->num_entries == 1)
+  {
+    return SDL_strdup(job->input->base);
+  }
+
+  char* name;
+  SDL_asprintf(&name, "%s.%s", job->input->base, job->entries[entry].name);
+  return name;
+}
+
+// where a slice keeps the output of an entry point, free with SDL_free
+char* slice_target(struct SDL_SHADER_State *state, struct SDL_SHADER_Slice *slice, struct SDL_SHADER_Job *job, int entry)
+{
+  char* name = job_name(job, entry);
+  char* target;
+  SDL_asprintf(&target, "%s%s%s", slice->folder, name, state->extension);
+  SDL_free(name);
+  return target;
+}
+
+// writes finished pack entries that are next in line
+void commit_job(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job)
+{
+  SDL_LockMutex(jobs->mutex);
+  job->done = true;
+
+  while (jobs->next_commit < jobs->num_jobs && jobs->jobs[jobs->next_commit].done)
+  {
+    struct SDL_SHADER_Job *next = &jobs->jobs[jobs->next_commit];
+    SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+
+    for (int i = 0; i < next->num_entries; i++)
+    {
+      char* name = job_name(next, i);
+
+      if (next->bins[i] != NULL && !pack_put(jobs->writer, name, next->bins[i], next->bin_sizes[i], next->input->last_modified))
+      {
+        print_error(jobs->state, "ERROR: could not write \"%s\" to \"%s\": %s\n", name, jobs->state->pack, SDL_GetError());
+      }
+
+      SDL_free(next->bins[i]);
+      next->bins[i] = NULL;
+      SDL_free(name);
+    }
+
+    memory_stage(stage);
+    jobs->next_commit++;
+  }
+
+  SDL_UnlockMutex(jobs->mutex);
+}
+
+void print_progress(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+  struct SDL_SHADER_Input *input = job->input;
+
+  if (state->silent)
+  {
+    return;
+  }
+
+  if (jobs->writer != NULL)
+  {
+    printf("COMPILING: \"%s\" -> \"%s:%s\".\n", input->path, state->pack, input->base);
+  }
+  else if (job->target != NULL)
+  {
+    printf("COMPILING: \"%s\" -> \"%s\".\n", input->path, job->target);
+  }
+  else
+  {
+    printf("COMPILING: \"%s\".\n", input->path);
+  }
+}
+
+// reads the source of an input, NULL when it can't be read
+void* load_input(struct SDL_SHADER_State *state, struct SDL_SHADER_Input *input, size_t *size)
+{
+  *size = 0;
+
+  SDL_SHADER_MemoryStage stage = memory_stage(SDL_SHADER_MEMORY_IO);
+  void* code = is_stdio(input->path) ? read_all(stdin, size) : SDL_LoadFile(input->path, size);
+  memory_stage(stage);
+
+  if (code == NULL)
+  {
+    print_error(state, "ERROR: could not open file \"%s\".\n", input->path);
+  }
+
+  return code;
+}
+
+// true when the figures of compiled shaders are reported
+bool wants_stats(struct SDL_SHADER_State *state)
+{
+  return state->stats || state->stats_json != NULL;
+}
+
+// the settings of a job, free with free_settings. returns the formats the outputs keep
+SDL_GPUShaderFormat job_settings(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job, struct SDL_SHADER_Settings *settings)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+  resolve_settings(state, job->input, settings);
+
+  // nothing but slices, so only their formats are needed. stats without any output report every format
+  if (job->target == NULL && jobs->writer == NULL && !((wants_stats(state) || state->verify) && state->slices->size == 0))
+  {
+    SDL_GPUShaderFormat formats = 0;
+    for (int i = 0; i < state->slices->size; i++)
+    {
+      formats |= ((struct SDL_SHADER_Slice*)vector_get(state->slices, i))->formats;
+    }
+
+    settings->formats &= formats;
+  }
+
+  // stats are read from the SPIR-V, it is stripped again when the outputs don't keep it
+  SDL_GPUShaderFormat formats = settings->formats;
+  if (wants_stats(state))
+  {
+    settings->formats |= SDL_GPU_SHADERFORMAT_SPIRV;
+  }
+
+  return formats;
+}
+
+// records the figures of the compiled entry points, then strips the formats only the stats needed
+void job_stats(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job, void **bins, size_t *bin_sizes, SDL_GPUShaderFormat formats)
+{
+  for (int i = 0; i < job->num_entries; i++)
+  {
+    if (bins[i] == NULL)
+    {
+      continue;
+    }
+
+    struct Stats *stats = SDL_calloc(1, sizeof(struct Stats));
+    if (stats_blob(bins[i], bin_sizes[i], formats, stats))
+    {
+      stats->name = job_name(job, i);
+      SDL_LockMutex(jobs->mutex);
+      vector_push(jobs->stats, stats);
+      SDL_UnlockMutex(jobs->mutex);
+    }
+    else
+    {
+      print_error(jobs->state, "ERROR: no stats for \"%s\": %s\n", job->input->path, SDL_GetError());
+      SDL_free(stats);
+    }
+
+    if (!(formats & SDL_GPU_SHADERFORMAT_SPIRV))
+    {
+      size_t stripped_size;
+      void* stripped = strip_blob(bins[i], bin_sizes[i], formats, &stripped_size);
+
+      if (stripped != NULL)
+      {
+        SDL_free(bins[i]);
+        bins[i] = stripped;
+        bin_sizes[i] = stripped_size;
+      }
+    }
+  }
+}
+
+// the name of a code entry in messages
+const char* code_name(SDL_GPUShaderFormat format)
+{
+  switch (format)
+  {
+    case SDL_GPU_SHADERFORMAT_SPIRV: return "SPIR-V";
+    case SDL_GPU_SHADERFORMAT_DXBC: return "DXBC";
+    case SDL_GPU_SHADERFORMAT_DXIL: return "DXIL";
+    case SDL_GPU_SHADERFORMAT_MSL: return "MSL";
+    case SDL_SHADER_SECTION_REFLECTION: return "reflection";
+    default: return "unknown";
+  }
+}
+
+// the first part of two blobs that differs, the header when the entries line up
+const char* blob_difference(const void* a, size_t a_size, const void* b, size_t b_size)
+{
+  struct SDL_SHADER_Blob x = {0};
+  struct SDL_SHADER_Blob y = {0};
+  const char* part = "header";
+
+  if (decode(a, a_size, &x) && decode(b, b_size, &y))
+  {
+    for (Uint32 i = 0; i < x.num_shaders && i < y.num_shaders; i++)
+    {
+      const struct SDL_SHADER_Code *p = x.shaders[i];
+      const struct SDL_SHADER_Code *q = y.shaders[i];
+
+      if (p->format != q->format || p->code_size != q->code_size || SDL_memcmp(p->code, q->code, p->code_size) != 0)
+      {
+        part = code_name(p->format);
+        break;
+      }
+    }
+  }
+
+  SDL_free(x.shaders);
+  SDL_free(y.shaders);
+  return part;
+}
+
+// checks a job compiled again gives byte identical blobs, that also survive decode and encode. frees the second blobs
+void job_verify(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job, void **bins, size_t *bin_sizes, void **again, size_t *again_sizes)
+{
+  for (int i = 0; i < job->num_entries; i++)
+  {
+    char* name = job_name(job, i);
+
+    if ((bins[i] == NULL) != (again[i] == NULL))
+    {
+      print_error(jobs->state, "ERROR: \"%s\" is not reproducible, it compiled only once out of two tries.\n", name);
+    }
+    else if (bins[i] != NULL && (bin_sizes[i] != again_sizes[i] || SDL_memcmp(bins[i], again[i], bin_sizes[i]) != 0))
+    {
+      print_error(jobs->state, "ERROR: \"%s\" is not reproducible, its %s differs between two compiles.\n", name, blob_difference(bins[i], bin_sizes[i], again[i], again_sizes[i]));
+    }
+    else if (bins[i] != NULL)
+    {
+      struct SDL_SHADER_Blob blob;
+      size_t encoded_size = 0;
+      void* encoded = decode(bins[i], bin_sizes[i], &blob) ? encode(&blob, &encoded_size) : NULL;
+
+      if (encoded == NULL || encoded_size != bin_sizes[i] || SDL_memcmp(encoded, bins[i], encoded_size) != 0)
+      {
+        print_error(jobs->state, "ERROR: \"%s\" is not reproducible, it changes when decoded and encoded again.\n", name);
+      }
+
+      SDL_free(encoded);
+      SDL_free(blob.shaders);
+    }
+
+    SDL_free(again[i]);
+    SDL_free(name);
+  }
+}
+
+// writes the compiled entry points of a job or keeps them for the pack, takes over the blobs
+void finish_job(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job, void **bins, size_t *bin_sizes, SDL_SHADER_Reflection **reflections)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+
+  for (int i = 0; i < job->num_entries; i++)
+  {
+    if (jobs->writer != NULL)
+    {
+      job->bins[i] = bins[i];
+      job->bin_sizes[i] = bin_sizes[i];
+      continue;
+    }
+
+    // stripped copies for each platform
+    for (int s = 0; bins[i] != NULL && s < state->slices->size; s++)
+    {
+      struct SDL_SHADER_Slice *slice = vector_get(state->slices, s);
+      char* slice_path = slice_target(state, slice, job, i);
+      size_t stripped_size;
+      void* stripped = strip_blob(bins[i], bin_sizes[i], slice->formats, &stripped_size);
+
+      if (stripped == NULL)
+      {
+        print_error(jobs->state, "ERROR: could not write \"%s\": %s\n", slice_path, SDL_GetError());
+      }
+      else
+      {
+        write_output(state, slice_path, stripped, stripped_size);
+      }
+
+      SDL_free(stripped);
+      SDL_free(slice_path);
+    }
+
+    char* target = job->num_entries > 1 && job->target != NULL ? entry_target(job->target, job->entries[i].name) : job->target;
+
+    if (target == NULL)
+    {
+      SDL_free(bins[i]);
+      SDL_free(reflections[i]);
+      continue;
+    }
+
+    if (bins[i] != NULL && is_stdio(target))
+    {
+      SDL_LockMutex(jobs->mutex);
+      fwrite(bins[i], 1, bin_sizes[i], state->data);
+      fflush(state->data);
+      SDL_UnlockMutex(jobs->mutex);
+    }
+    else if (bins[i] != NULL)
+    {
+      write_output(state, target, bins[i], bin_sizes[i]);
+    }
+
+    SDL_free(bins[i]);
+
+    // uniform struct header next to the output
+    if (reflections[i] != NULL)
+    {
+      char* header = header_path(target);
+      char* name = job_name(job, i);
+      size_t header_size;
+      char* text = codegen_header(reflections[i], name, &header_size);
+
+      if (text == NULL)
+      {
+        print_error(jobs->state, "ERROR: could not generate \"%s\"\n", header);
+      }
+      else
+      {
+        write_output(state, header, text, header_size);
+      }
+
+      SDL_free(text);
+      SDL_free(name);
+      SDL_free(header);
+      SDL_free(reflections[i]);
+    }
+
+    if (target != job->target)
+    {
+      SDL_free(target);
+    }
+  }
+}
+
+// headers need the reflection, but there is nothing to put them next to for packs, slices and stdout
+bool wants_header(struct SDL_SHADER_State *state, struct SDL_SHADER_Job *job)
+{
+  return state->header && job->target != NULL && !is_stdio(job->target);
+}
+
+// compiles a vertex shader together with the fragment shader linked to it
+void run_linked_jobs(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *vertex, struct SDL_SHADER_Job *fragment)
+{
+  struct SDL_SHADER_Job *pair[2] = { vertex, fragment };
+  void* codes[2];
+  size_t code_sizes[2];
+
+  print_progress(jobs, vertex);
+  print_progress(jobs, fragment);
+  codes[0] = load_input(jobs->state, vertex->input, &code_sizes[0]);
+  codes[1] = load_input(jobs->state, fragment->input, &code_sizes[1]);
+
+  if (codes[0] != NULL && codes[1] != NULL)
+  {
+    struct SDL_SHADER_Settings settings[2];
+    const struct SDL_SHADER_Settings *settings_pair[2] = { &settings[0], &settings[1] };
+
+    SDL_GPUShaderFormat formats[2];
+    for (int i = 0; i < 2; i++)
+    {
+      formats[i] = job_settings(jobs, pair[i], &settings[i]);
+      settings[i].entry = pair[i]->entries[0].name;
+      settings[i].type = pair[i]->entries[0].type;
+    }
+
+    void* bins[2];
+    size_t bin_sizes[2];
+    SDL_SHADER_Reflection *reflections[2] = {0};
+    bool header = wants_header(jobs->state, vertex) || wants_header(jobs->state, fragment);
+    compile_linked(codes, code_sizes, settings_pair, header ? reflections : NULL, bins, bin_sizes);
+
+    // the errors were printed by the first compile already
+    void* again[2];
+    size_t again_sizes[2];
+    if (jobs->state->verify)
+    {
+      char* log = NULL;
+      compile_capture_begin(&log);
+      compile_linked(codes, code_sizes, settings_pair, NULL, again, again_sizes);
+      compile_capture_end();
+      SDL_free(log);
+    }
+
+    for (int i = 0; i < 2; i++)
+    {
+      if (jobs->state->verify)
+      {
+        job_verify(jobs, pair[i], &bins[i], &bin_sizes[i], &again[i], &again_sizes[i]);
+      }
+
+      if (!wants_header(jobs->state, pair[i]))
+      {
+        SDL_free(reflections[i]);
+        reflections[i] = NULL;
+      }
+
+      if (wants_stats(jobs->state))
+      {
+        job_stats(jobs, pair[i], &bins[i], &bin_sizes[i], formats[i]);
+      }
+
+      finish_job(jobs, pair[i], &bins[i], &bin_sizes[i], &reflections[i]);
+      free_settings(&settings[i]);
+    }
+  }
+
+  SDL_free(codes[0]);
+  SDL_free(codes[1]);
+}
+
+void run_job(struct SDL_SHADER_Jobs *jobs, struct SDL_SHADER_Job *job, int *connection)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+
+  // compiled together with the vertex shader before it
+  if (job->linked)
+  {
+    return;
+  }
+
+  // linking needs both stages at once, so the pair always compiles locally
+  if (job->links_next)
+  {
+    run_linked_jobs(jobs, job, job + 1);
+  }
+  else
+  {
+    print_progress(jobs, job);
+
+    size_t code_size;
+    void* code = load_input(jobs->state, job->input, &code_size);
+
+    if (code != NULL)
+    {
+      struct SDL_SHADER_Settings settings;
+      SDL_GPUShaderFormat formats = job_settings(jobs, job, &settings);
+
+      void* bins[SDL_SHADER_MAX_ENTRIES];
+      size_t bin_sizes[SDL_SHADER_MAX_ENTRIES];
+      SDL_SHADER_Reflection *reflections[SDL_SHADER_MAX_ENTRIES] = {0};
+      build_entries(connection, code, code_size, &settings, job->entries, job->num_entries, wants_header(state, job) ? reflections : NULL, bins, bin_sizes);
+
+      // always local, so a remote build is compared with this machine too
+      if (state->verify)
+      {
+        void* again[SDL_SHADER_MAX_ENTRIES];
+        size_t again_sizes[SDL_SHADER_MAX_ENTRIES];
+        char* log = NULL;
+
+        compile_capture_begin(&log);
+        compile_entries(code, code_size, &settings, job->entries, job->num_entries, NULL, again, again_sizes);
+        compile_capture_end();
+        SDL_free(log);
+
+        job_verify(jobs, job, bins, bin_sizes, again, again_sizes);
+      }
+
+      free_settings(&settings);
+
+      if (wants_stats(state))
+      {
+        job_stats(jobs, job, bins, bin_sizes, formats);
+      }
+
+      finish_job(jobs, job, bins, bin_sizes, reflections);
+    }
+
+    SDL_free(code);
+  }
+
+  if (jobs->writer != NULL)
+  {
+    commit_job(jobs, job);
+
+    if (job->links_next)
+    {
+      commit_job(jobs, job + 1);
+    }
+  }
+}
+
+int SDLCALL job_worker(void* data)
+{
+  struct SDL_SHADER_Worker *worker = data;
+  struct SDL_SHADER_Jobs *jobs = worker->jobs;
+
+  // every worker talks to the server on its own connection
+  int connection = jobs->state->remote ? server_connect(jobs->state->socket) : -1;
+
+  while (SDL_GetAtomicInt(&jobs->next) < jobs->num_jobs)
+  {
+    // extra workers need a token from make, check regularly if there is still work left
+    int token = -1;
+    if (jobs->state->has_jobserver && !worker->implicit_slot)
+    {
+      token = jobserver_acquire(&jobs->state->jobserver, 100);
+      if (token < 0)
+      {
+        continue;
+      }
+    }
+
+    int index = SDL_AddAtomicInt(&jobs->next, 1);
+    if (index < jobs->num_jobs)
+    {
+      run_job(jobs, &jobs->jobs[index], &connection);
+    }
+
+    if (token >= 0)
+    {
+      jobserver_release(&jobs->state->jobserver, token);
+    }
+  }
+
+  if (connection >= 0)
+  {
+    server_disconnect(connection);
+  }
+
+  return 0;
+}
+
+// compiles every job on a pool of threads
+void run_jobs(struct SDL_SHADER_Jobs *jobs)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+
+  // under make the jobserver decides how many run at once, the threads are just an upper bound
+  int num_threads = state->jobs > 0 ? state->jobs : SDL_GetNumLogicalCPUCores();
+  num_threads = SDL_clamp(num_threads, 1, SDL_max(jobs->num_jobs, 1));
+
+  SDL_Thread **threads = SDL_calloc(num_threads, sizeof(SDL_Thread*));
+  struct SDL_SHADER_Worker *workers = SDL_calloc(num_threads, sizeof(struct SDL_SHADER_Worker));
+
+  for (int i = 0; i < num_threads; i++)
+  {
+    workers[i].jobs = jobs;
+    workers[i].implicit_slot = i == 0;
+  }
+
+  for (int i = 1; i < num_threads; i++)
+  {
+    threads[i] = SDL_CreateThread(job_worker, "compile", &workers[i]);
+  }
+
+  // the calling thread takes the implicit slot
+  job_worker(&workers[0]);
+
+  for (int i = 1; i < num_threads; i++)
+  {
+    SDL_WaitThread(threads[i], NULL);
+  }
+
+  SDL_free(workers);
+  SDL_free(threads);
+}
+
+// adds a job for every input that changed since it was last packed
+void collect_pack_jobs(struct SDL_SHADER_Jobs *jobs, struct Pack_Writer *writer)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+
+  for (int i = 0; i < state->inputs->size; i++)
+  {
+    struct SDL_SHADER_Input *input = vector_get(state->inputs, i);
+
+    // stdin has no extension to go by
+    if (is_stdio(input->path) && input->lang == SDL_SHADER_LANG_UNKNOWN)
+    {
+      input->lang = state->lang;
+    }
+
+    if (input->lang == SDL_SHADER_LANG_UNKNOWN)
+    {
+      print_error(jobs->state, "ERROR: \"%s\" has unknown file extension. \n\tSupported extensions: \".glsl\", \".hlsl\", or \".spv\".\n", input->path);
+      continue;
+    }
+
+    struct SDL_SHADER_Job *job = &jobs->jobs[jobs->num_jobs];
+    job->input = input;
+
+    if (!job_entries(jobs, job))
+    {
+      continue;
+    }
+
+    // skip entries compiled from the same source, stats need every shader
+    bool packed = !state->recompile && !wants_stats(state);
+    for (int e = 0; packed && e < job->num_entries; e++)
+    {
+      char* name = job_name(job, e);
+      struct Pack_Entry *entry = pack_find(&writer->pack, name);
+      packed = entry != NULL && entry->time == input->last_modified;
+      SDL_free(name);
+    }
+
+    // linking needs to know about the fragment shader even when it didn't change
+    if (packed && !state->link)
+    {
+      SDL_free(job->entry_list);
+      continue;
+    }
+
+    job->compiled = packed;
+    jobs->num_jobs++;
+  }
+}
+
+// true when an output is newer than its source, or was found identical to a compile of it
+bool is_newer(struct SDL_SHADER_State *state, const char* target, SDL_Time last_modified)
+{
+  SDL_PathInfo target_info = {0};
+  if (!SDL_GetPathInfo(target, &target_info))
+  {
+    return false;
+  }
+
+  return target_info.modify_time > last_modified || is_unchanged(state, target, target_info.modify_time, last_modified);
+}
+
+// true when every output of the job is newer than the source
+bool is_compiled(struct SDL_SHADER_State *state, struct SDL_SHADER_Job *job)
+{
+  bool compiled = true;
+
+  for (int e = 0; compiled && e < job->num_entries; e++)
+  {
+    if (job->target != NULL)
+    {
+      char* target = job->num_entries > 1 ? entry_target(job->target, job->entries[e].name) : job->target;
+      compiled = is_newer(state, target, job->input->last_modified);
+
+      if (target != job->target)
+      {
+        SDL_free(target);
+      }
+    }
+
+    for (int i = 0; compiled && i < state->slices->size; i++)
+    {
+      char* target = slice_target(state, vector_get(state->slices, i), job, e);
+      compiled = is_newer(state, target, job->input->last_modified);
+      SDL_free(target);
+    }
+  }
+
+  return compiled;
+}
+
+// adds a job for every input with an outdated output
+void collect_jobs(struct SDL_SHADER_Jobs *jobs)
+{
+  struct SDL_SHADER_State *state = jobs->state;
+  size_t extension_size = SDL_strlen(state->extension);
+  size_t output_index = 0;
+
+  for (int i = 0; i < state->inputs->size; i++) 
+  {
+    struct SDL_SHADER_Input *input = vector_get(state->inputs, i);
+    struct SDL_SHADER_Output *output = vector_get(state->outputs, output_index);
+
+    // manifest entries can name their own output
+    struct SDL_SHADER_Output manifest_output;
+    if (input->target != NULL)
+    {
+      manifest_output.path = input->target;
+      manifest_output.folder = false;
+      output = &manifest_output;
+    }
+  
+    // slices, stats and verifying are enough on their own
+    if (output == NULL && state->slices->size == 0 && !wants_stats(state) && !state->verify)
+    {
+      print_error(jobs->state, "ERROR: no output for \"%s\"\n", input->path);
+      continue;
+    }
+
+    // stdin has no extension to go by
+    if (is_stdio(input->path) && input->lang == SDL_SHADER_LANG_UNKNOWN)
+    {
+      input->lang = state->lang;
+    }
+
+    if (input->lang == SDL_SHADER_LANG_UNKNOWN)
+    {
+      print_error(jobs->state, "ERROR: \"%s\" has unknown file extension. \n\tSupported extensions: \".glsl\", \".hlsl\", or \".spv\".\n", input->path);
+      continue;
+    }
+
+    SDL_PathInfo code_info = {0};
+    if (!is_stdio(input->path) && !SDL_GetPathInfo(input->path, &code_info))
+    {
+      continue;
+    }
+
+    char* target = NULL;
+    bool owns_target = output != NULL && output->folder;
+
+    if (output == NULL)
+    {
+      target = NULL;
+    }
+    else if (output->folder)
+    {
+      uint32_t target_size = SDL_strlen(output->path) + SDL_strlen(input->base) + extension_size + 1;
+      target = SDL_calloc(target_size, sizeof(char));
+      SDL_strlcat(target, output->path, target_size);
+      SDL_strlcat(target, input->base, target_size);
+      SDL_strlcat(target, state->extension, target_size);
+    }
+    else 
+    {
+      target = output->path;
+
+      if (output != &manifest_output)
+      {
+        output_index++;
+      }
+    }
+
+    struct SDL_SHADER_Job *job = &jobs->jobs[jobs->num_jobs];
+    job->input = input;
+    job->target = target;
+    job->owns_target = owns_target;
+
+    bool stdout_target = target != NULL && is_stdio(target);
+    bool valid = job_entries(jobs, job);
+    if (valid && job->num_entries > 1 && stdout_target)
+    {
+      print_error(jobs->state, "ERROR: \"%s\" has several entry points, they need an output file each.\n", input->path);
+      SDL_free(job->entry_list);
+      valid = false;
+    }
+
+    // skip modified file, streams and stats are always compiled
+    bool compiled = valid && !state->recompile && !wants_stats(state) && !is_stdio(input->path) && !stdout_target && is_compiled(state, job);
+
+    if (!valid || (compiled && !state->link))
+    {
+      if (compiled)
+      {
+        SDL_free(job->entry_list);
+      }
+
+      if (owns_target)
+      {
+        SDL_free(target);
+      }
+
+      continue;
+    }
+
+    job->compiled = compiled;
+    jobs->num_jobs++;
+  }
+}
+
+// true when a job is a single shader of the given type
+bool is_single_stage(struct SDL_SHADER_Job *job, SDL_SHADER_Type type)
+{
+  return job->num_entries == 1 && job->entries[0].type == type;
+}
+
+// pairs vertex jobs with the fragment job that follows them and drops jobs that are up to date
+void link_jobs(struct SDL_SHADER_Jobs *jobs)
+{
+  for (int i = 0; jobs->state->link && i + 1 < jobs->num_jobs; i++)
+  {
+    struct SDL_SHADER_Job *vertex = &jobs->jobs[i];
+    struct SDL_SHADER_Job *fragment = &jobs->jobs[i + 1];
+
+    if (!is_single_stage(vertex, SDL_SHADER_TYPE_VERTEX) || !is_single_stage(fragment, SDL_SHADER_TYPE_FRAGMENT))
     {
-      count = 0;
+      continue;
     }
+
+    // the pair compiles again when either of them changed
+    vertex->links_next = true;
+    fragment->linked = true;
+    vertex->compiled = fragment->compiled = vertex->compiled && fragment->compiled;
+    i++;
   }
 
-  // inputs
-  for (int i = 0; i < count; i++) {
-    char* path;
-    char* base;
+  int count = 0;
+  for (int i = 0; i < jobs->num_jobs; i++)
+  {
+    struct SDL_SHADER_Job *job = &jobs->jobs[i];
 
-    if (globbed)
+    if (job->compiled)
     {
-      int path_size = arg_len + SDL_strlen(files[i]) + 1;
-      path = SDL_calloc(path_size, sizeof(char));
-      SDL_strlcat(path, arg, path_size);
-      SDL_strlcat(path, files[i], path_size);
-    }
-    else 
-    {
-      path = SDL_strdup(arg);
-    }
-   
-    // skip missing files
-    SDL_PathInfo info = {0};
-    if (!SDL_GetPathInfo(path, &info))
-    {
-      printf("ERROR: \"%s\" does not exist.\n", path);
-      SDL_free(path);
-      return;
-    }
+      if (job->owns_target)
+      {
+        SDL_free(job->target);
+      }
 
-    // skip directories in a glob
-    if (globbed && info.type == SDL_PATHTYPE_DIRECTORY)
-    {
-      SDL_free(path);
-      return;
+      SDL_free(job->entry_list);
+      continue;
     }
 
-    struct SDL_SHADER_Input *input = SDL_malloc(sizeof(struct SDL_SHADER_Input));
-    input->path = path;
-    input->type = state->shader_type;
-    input->last_modified = info.modify_time;
+    jobs->jobs[count++] = *job;
+  }
+
+  jobs->num_jobs = count;
+}
+
+// reads up to a delimiter and drops it, NULL when the stream ended before anything was read
+char* read_until(FILE* file, int delimiter, size_t *size)
+{
+  size_t capacity = 4096;
+  size_t used = 0;
+  char* text = SDL_malloc(capacity + 1);
 
-    // set the shader langauge based on file extension
-    size_t len = SDL_strlen(path);
-    if (len > 6 && SDL_strcmp(&path[len - 5], ".glsl") == 0)
+  int c;
+  while ((c = getc(file)) != EOF && c != delimiter)
+  {
+    if (used == capacity)
     {
-      input->lang = SDL_SHADER_LANG_GLSL;
+      capacity *= 2;
+      text = SDL_realloc(text, capacity + 1);
     }
-    else if (len > 6 && SDL_strcmp(&path[len - 5], ".hlsl") == 0)
+
+    text[used++] = (char)c;
+  }
+
+  if (c == EOF && used == 0)
+  {
+    SDL_free(text);
+    return NULL;
+  }
+
+  text[used] = '\0';
+  *size = used;
+  return text;
+}
+
+// answers compile requests on stdin until it closes
+void run_stream(struct SDL_SHADER_State *state)
+{
+  int connection = state->remote ? server_connect(state->socket) : -1;
+
+  size_t header_size;
+  char* header;
+
+  while ((header = read_until(stdin, '\n', &header_size)) != NULL)
+  {
+    size_t code_size = 0;
+    char* code = read_until(stdin, '\0', &code_size);
+
+    if (code == NULL)
     {
-      input->lang = SDL_SHADER_LANG_HLSL;
+      code = SDL_calloc(1, sizeof(char));
     }
-    else if (len > 5 && SDL_strcmp(&path[len - 4], ".spv") == 0)
+
+    // requests start from the command line settings
+    struct SDL_SHADER_Input input = {0};
+    input.path = "<stdin>";
+    input.type = state->shader_type;
+    input.lang = state->lang;
+
+    // errors belong into the response
+    char* log = NULL;
+    compile_capture_begin(&log);
+
+    char* tokens[64];
+    int count = manifest_tokenize(header, tokens, SDL_arraysize(tokens));
+    bool valid = true;
+
+    for (int i = 0; i < count; i++)
     {
-      input->lang = SDL_SHADER_LANG_SPIRV;
+      char* key = tokens[i];
+      char* value = manifest_split(key);
+
+      if (value != NULL && SDL_strcmp(key, "name") == 0)
+      {
+        input.path = value;
+      }
+      else if (value == NULL || SDL_strcmp(key, "output") == 0 || !apply_setting(&input, key, value))
+      {
+        compile_error("ERROR: invalid setting \"%s%s%s\".\n", key, value != NULL ? "=" : "", value != NULL ? value : "");
+        valid = false;
+      }
     }
-    else 
+
+    if (valid && input.lang == SDL_SHADER_LANG_UNKNOWN)
     {
-      input->lang = SDL_SHADER_LANG_UNKNOWN;
+      compile_error("ERROR: \"%s\" needs a lang= setting or --lang.\n", input.path);
+      valid = false;
     }
 
-    // the size of the extension string
-    int extension_offset = 0;
-    if (input->lang == SDL_SHADER_LANG_GLSL || input->lang == SDL_SHADER_LANG_HLSL)
+    void* bin = NULL;
+    size_t bin_size = 0;
+
+    // one response per request, so one entry point
+    struct SDL_SHADER_Entry entries[SDL_SHADER_MAX_ENTRIES];
+    char* entry_list = SDL_strdup(input.entry != NULL ? input.entry : state->entry);
+
+    if (valid && parse_entries(entry_list, input.type, entries) != 1)
     {
-      extension_offset = 5;
+      compile_error("ERROR: \"%s\" needs a single entry point in stream mode.\n", input.path);
+      valid = false;
     }
-    else if (input->lang == SDL_SHADER_LANG_SPIRV)
+
+    if (valid)
     {
-      extension_offset = 4;
+      struct SDL_SHADER_Settings settings;
+      resolve_settings(state, &input, &settings);
+      settings.entry = entries[0].name;
+      settings.type = entries[0].type;
+      bin = build(&connection, code, code_size, &settings, NULL, &bin_size);
+      free_settings(&settings);
     }
 
-    int base_size = 0;
-    if (globbed)
+    SDL_free(entry_list);
+
+    compile_capture_end();
+
+    if (bin != NULL)
     {
-      // glob path without the extension
-      base_size = SDL_strlen(files[i]) - extension_offset + 1;
-      input->base = SDL_calloc(base_size, sizeof(char));
-      SDL_strlcat(input->base, files[i], base_size);
+      fprintf(state->data, "ok %zu\n", bin_size);
+      fwrite(bin, 1, bin_size, state->data);
     }
-    else 
+    else
     {
-      // skip to the last \ or / 
-      int filename_start = 0;
-      for (int i = 0; i < len; i++) 
-      {
-        if (path[i] == '/' || path[i] == '\\')
-        {
-          filename_start = i;
-        }
-      }
-
-      // filename without the extension
-      base_size = len - filename_start -  extension_offset;
-      input->base = SDL_calloc(base_size, sizeof(char));
-      SDL_strlcat(input->base, &path[filename_start + 1], base_size);
+      size_t log_size = log != NULL ? SDL_strlen(log) : 0;
+      fprintf(state->data, "error %zu\n", log_size);
+      fwrite(log, 1, log_size, state->data);
     }
 
-    // figure out the shader type based on file name
-    if (SDL_strcmp(&input->base[base_size - 6], ".vert") == 0)
-    {
-      input->type = SDL_SHADER_TYPE_VERTEX;
-    }
-    else if (SDL_strcmp(&input->base[base_size - 6], ".frag") == 0)
+    fflush(state->data);
+
+    if (input.defines != NULL)
     {
-      input->type = SDL_SHADER_TYPE_FRAGMENT;
+      vector_delete(input.defines);
     }
-    else if (SDL_strcmp(&input->base[base_size - 6], ".comp") == 0)
+
+    if (input.constants != NULL)
     {
-      input->type = SDL_SHADER_TYPE_COMPUTE;
+      vector_delete(input.constants);
     }
 
-    vector_push(state->inputs, input);
+    SDL_free(bin);
+    SDL_free(log);
+    SDL_free(code);
+    SDL_free(header);
   }
 
-    // free the list of files
-  SDL_free(files);
+  if (connection >= 0)
+  {
+    server_disconnect(connection);
+  }
 }
 
-void run(struct SDL_SHADER_State *state)
+// writes platform specific copies of compiled blobs and packs
+void run_strip(struct SDL_SHADER_State *state, SDL_GPUShaderFormat formats)
 {
-  // skip when no inputs are available
   if (state->inputs->size == 0)
   {
-    printf("%s", "ERROR: no input files.\n");
+    print_error(state, "%s", "ERROR: no input files.\n");
     return;
   }
 
-  size_t extension_size = SDL_strlen(state->extension);
-  size_t output_index = 0;
+  if (formats == 0)
+  {
+    print_error(state, "%s", "ERROR: strip needs the formats to keep, like --spv.\n");
+    return;
+  }
 
-  for (int i = 0; i < state->inputs->size; i++) 
+  size_t output_index = 0;
+  for (int i = 0; i < state->inputs->size; i++)
   {
     struct SDL_SHADER_Input *input = vector_get(state->inputs, i);
     struct SDL_SHADER_Output *output = vector_get(state->outputs, output_index);
-  
+
     if (output == NULL)
     {
-      printf("ERROR: no output for \"%s\"\n", input->path);
+      print_error(state, "ERROR: no output for \"%s\"\n", input->path);
       continue;
     }
 
-    if (input->lang == SDL_SHADER_LANG_UNKNOWN)
+    // folders keep the file names
+    char* target;
+    if (output->folder)
     {
-      printf("ERROR: \"%s\" has unknown file extension. \n\tSupported extensions: \".glsl\", \".hlsl\", or \".spv\".\n", input->path);
-      continue;
+      SDL_asprintf(&target, "%s%s", output->path, input->base);
     }
-
-    SDL_PathInfo code_info = {0};
-    if (!SDL_GetPathInfo(input->path, &code_info))
+    else
     {
-      continue;
+      target = SDL_strdup(output->path);
+      output_index++;
     }
 
-    char* target;
-    if (output->folder)
+    if (!state->silent)
     {
-      uint32_t target_size = SDL_strlen(output->path) + SDL_strlen(input->base) + extension_size + 1;
-      target = SDL_calloc(target_size, sizeof(char));
-      SDL_strlcat(target, output->path, target_size);
-      SDL_strlcat(target, input->base, target_size);
-      SDL_strlcat(target, state->extension, target_size);
+      printf("STRIPPING: \"%s\" -> \"%s\".\n", input->path, target);
     }
-    else 
+
+    // packs are stripped entry by entry, only the magic is needed to tell them apart
+    char magic[sizeof(PACK_MAGIC) - 1];
+    SDL_IOStream* io = SDL_IOFromFile(input->path, "rb");
+    bool is_pack = io != NULL && SDL_ReadIO(io, magic, sizeof(magic)) == sizeof(magic) && SDL_memcmp(magic, PACK_MAGIC, sizeof(magic)) == 0;
+
+    if (io != NULL)
     {
-      target = output->path;
-      output_index++;
+      SDL_CloseIO(io);
     }
 
-    // skip modified file
-    if (!state->recompile)
+    if (io == NULL)
     {
-      SDL_PathInfo target_info = {0};
-      
-      // if another newer compiled blob exists
-      if (SDL_GetPathInfo(target, &target_info) && target_info.modify_time > input->last_modified)
+      print_error(state, "ERROR: could not open file \"%s\".\n", input->path);
+    }
+    else if (is_pack)
+    {
+      if (!strip_pack(input->path, target, formats))
       {
-        if (output->folder)
-        {
-          SDL_free(target);
-        }
+        print_error(state, "ERROR: could not strip \"%s\": %s\n", input->path, SDL_GetError());
+      }
+    }
+    else
+    {
+      size_t size;
+      void* data = SDL_LoadFile(input->path, &size);
+      size_t stripped_size;
+      void* stripped = data != NULL ? strip_blob(data, size, formats, &stripped_size) : NULL;
 
-        continue;
+      if (stripped == NULL)
+      {
+        print_error(state, "ERROR: could not strip \"%s\": %s\n", input->path, SDL_GetError());
       }
+      else
+      {
+        write_output(state, target, stripped, stripped_size);
+      }
+
+      SDL_free(stripped);
+      SDL_free(data);
     }
 
-    // print progress
-    if (!state->silent)
+    SDL_free(target);
+  }
+}
+
+// allocations per stage, anything still allocated at exit points at a leak
+void report_memory(void)
+{
+  static const char *names[SDL_SHADER_MEMORY_STAGE_COUNT] =
+  {
+    "other", "io", "front-end", "reflection", "dxil", "dxbc", "msl", "encode", "create"
+  };
+
+  SDL_SHADER_MemoryStats stats;
+  SDL_SHADER_GetMemoryStats(&stats);
+
+  printf("MEMORY: peak %" SDL_PRIu64 " bytes, %" SDL_PRIu64 " bytes still allocated at exit.\n", stats.peak, stats.current);
+  printf("%12s %12s %14s %10s %14s\n", "stage", "allocations", "bytes", "leaked", "leaked bytes");
+
+  for (int i = 0; i < SDL_SHADER_MEMORY_STAGE_COUNT; i++)
+  {
+    if (stats.allocations[i] > 0)
     {
-      printf("COMPILING: \"%s\" -> \"%s\".\n", input->path, target);
+      printf("%12s %12" SDL_PRIu64 " %14" SDL_PRIu64 " %10" SDL_PRIu64 " %14" SDL_PRIu64 "\n", names[i], stats.allocations[i], stats.bytes[i], stats.live_allocations[i], stats.live_bytes[i]);
     }
+  }
+}
 
-    size_t code_size = 0;
-    void* code = SDL_LoadFile(input->path, &code_size);
+// prints the stats table and writes the JSON report
+void report_stats(struct SDL_SHADER_State *state, struct Vector *stats)
+{
+  if (state->stats)
+  {
+    char* text = stats_text((struct Stats**)stats->data, (int)stats->size);
+    printf("%s", text);
+    SDL_free(text);
+  }
 
-    if (code == NULL)
+  if (state->stats_json != NULL)
+  {
+    char* json = stats_json((struct Stats**)stats->data, (int)stats->size);
+
+    if (is_stdio(state->stats_json))
     {
-      printf("ERROR: could not open file \"%s\".\n", input->path);
+      printf("%s", json);
     }
-    else 
+    else if (!SDL_SaveFile(state->stats_json, json, SDL_strlen(json)))
     {
-      size_t bin_size;
-      void* bin = compile(code, code_size, input->type, input->lang, state->shader_formats, state->entry, input->path, &bin_size);
+      print_error(state, "ERROR: could not write \"%s\": %s\n", state->stats_json, SDL_GetError());
+    }
 
-      if (bin != NULL)
-      {
-        // create a directory and try again if failed
-        if(!SDL_SaveFile(target, bin, bin_size))
-        {
-          char* dir = SDL_strdup(target);
-          uint32_t target_size = SDL_strlen(target);
-          uint32_t pos = 0;
-
-          // find the last slash
-          for (uint32_t i = 0; i < target_size; i++) 
-          {
-            if (target[i] == '/' || target[i] == '\'')
-            {
-              pos = i;
-            }
-          }
-
-          // terminate the strig early
-          dir[pos] = '\0';
-          SDL_CreateDirectory(dir);
-
-          if (!SDL_SaveFile(target, bin, bin_size))
-          {
-            printf("ERROR: could not write \"%s\"", target);
-          }
-
-          SDL_free(dir);
-        }
-
-        SDL_free(bin);
-      }
+    SDL_free(json);
+  }
+}
+
+void run(struct SDL_SHADER_State *state)
+{
+  // skip when no inputs are available
+  if (state->inputs->size == 0)
+  {
+    print_error(state, "%s", "ERROR: no input files.\n");
+    return;
+  }
+
+  struct SDL_SHADER_Jobs jobs = {0};
+  jobs.state = state;
+  jobs.jobs = SDL_calloc(state->inputs->size, sizeof(struct SDL_SHADER_Job));
+  jobs.mutex = SDL_CreateMutex();
+
+  // everything goes into a single pack
+  struct Pack_Writer writer;
+  if (state->pack != NULL && state->slices->size > 0)
+  {
+    print_error(state, "%s", "ERROR: --slice writes files, use \"sdlshader strip\" on the pack instead.\n");
+    SDL_DestroyMutex(jobs.mutex);
+    SDL_free(jobs.jobs);
+    return;
+  }
+  else if (state->pack != NULL)
+  {
+    if (!pack_open_writer(&writer, state->pack))
+    {
+      print_error(state, "ERROR: could not open pack \"%s\": %s\n", state->pack, SDL_GetError());
+      SDL_DestroyMutex(jobs.mutex);
+      SDL_free(jobs.jobs);
+      return;
     }
 
-    SDL_free(code);
+    jobs.writer = &writer;
+    collect_pack_jobs(&jobs, &writer);
+  }
+  else
+  {
+    collect_jobs(&jobs);
+  }
 
-    if (output->folder)
+  jobs.stats = vector_create(64);
+  link_jobs(&jobs);
+  run_jobs(&jobs);
+
+  if (wants_stats(state))
+  {
+    report_stats(state, jobs.stats);
+  }
+
+  for (size_t i = 0; i < jobs.stats->size; i++)
+  {
+    struct Stats *stats = vector_get(jobs.stats, i);
+    SDL_free(stats->name);
+    SDL_free(stats);
+  }
+
+  vector_delete(jobs.stats);
+
+  if (state->pack != NULL && !pack_close_writer(&writer, state->compact_threshold))
+  {
+    print_error(state, "ERROR: could not write \"%s\": %s\n", state->pack, SDL_GetError());
+  }
+
+  for (int i = 0; i < jobs.num_jobs; i++)
+  {
+    if (jobs.jobs[i].owns_target)
     {
-      SDL_free(target);
+      SDL_free(jobs.jobs[i].target);
     }
+
+    SDL_free(jobs.jobs[i].entry_list);
   }
+
+  SDL_DestroyMutex(jobs.mutex);
+  SDL_free(jobs.jobs);
 }
 
 int main(int argc, char** argv)
 {
+  // the counting allocators have to be in place before anything is allocated
+  for (int i = 1; i < argc; i++)
+  {
+    if (SDL_strcmp(argv[i], "--memory") == 0 && !SDL_SHADER_EnableMemoryTracking())
+    {
+      printf("WARNING: could not track memory: %s\n", SDL_GetError());
+    }
+  }
+
   // state
   struct SDL_SHADER_State state = {0};
+
+  // the pipe make passes is only recognized by its descriptor numbers, once stdout is claimed or a
+  // socket or file is open one of them could take a number make didn't pass and look like the pipe
+  state.has_jobserver = jobserver_open(&state.jobserver);
   state.inputs = vector_create(256);
   state.outputs = vector_create(256);
+  state.includes = vector_create(8);
+  state.excludes = vector_create(8);
+  state.defines = vector_create(8);
+  state.constants = vector_create(8);
+  state.manifests = vector_create(8);
+  state.slices = vector_create(8);
   
   state.shader_type = SDL_SHADER_TYPE_VERTEX;
   state.shader_formats = 0;
   
   state.extension = ".bin";
   state.entry = "main";
+  state.pack = NULL;
+  state.socket = NULL;
+  state.cache = NULL;
+  state.stats_json = NULL;
+  state.jobs = 0;
+  state.lang = SDL_SHADER_LANG_UNKNOWN;
+  state.data = NULL;
+  state.compact_threshold = 0.5f;
   
   state.recompile = false;
+  state.server = false;
+  state.remote = false;
+  state.stream = false;
+  state.strip = false;
+  state.link = false;
+  state.memory = false;
+  state.stats = false;
+  state.verify = false;
+  state.recursive = false;
+  state.skip_unchanged = false;
+  state.reflect = false;
+  state.header = false;
   state.sync = false;
   state.silent = false;
   state.is_output = false;
   state.is_extension = false;
   state.is_entry = false;
+  state.is_pack = false;
+  state.is_compact = false;
+  state.is_include = false;
+  state.is_exclude = false;
+  state.is_define = false;
+  state.is_spec = false;
+  state.is_manifest = false;
+  state.is_socket = false;
+  state.is_cache = false;
+  state.is_jobs = false;
+  state.is_lang = false;
+  state.is_slice = false;
+  state.is_stats_json = false;
   
+  // subcommands come first
+  int first_arg = 1;
+  if (argc > 1 && SDL_strcmp(argv[1], "strip") == 0)
+  {
+    state.strip = true;
+    first_arg = 2;
+  }
+
   // parse args
-  for (int i = 1; i < argc; i++)
+  for (int i = first_arg; i < argc; i++)
   {
     parse_arg(&state, argv[i]);
   }
 
+  // stripping keeps only what was asked for
+  SDL_GPUShaderFormat requested_formats = state.shader_formats;
+
   // deafult to all formats if none is forced
   if (state.shader_formats == 0)
   {
@@ -796,8 +2626,94 @@ int main(int argc, char** argv)
     state.shader_formats |= SDL_GPU_SHADERFORMAT_DXBC;
   }
 
+  // stdin without an output goes to stdout
+  bool uses_stdout = state.stream;
+  for (int i = 0; i < state.inputs->size; i++)
+  {
+    struct SDL_SHADER_Input *input = vector_get(state.inputs, i);
+    if (is_stdio(input->path) && state.outputs->size == 0 && input->target == NULL)
+    {
+      struct SDL_SHADER_Output *output = SDL_malloc(sizeof(struct SDL_SHADER_Output));
+      output->path = SDL_strdup("-");
+      output->folder = false;
+      vector_push(state.outputs, output);
+    }
+  }
+
+  for (int i = 0; i < state.outputs->size; i++)
+  {
+    struct SDL_SHADER_Output *output = vector_get(state.outputs, i);
+    uses_stdout |= is_stdio(output->path);
+  }
+
+  if (uses_stdout)
+  {
+    state.data = claim_stdout();
+  }
+
+  char* default_socket = server_default_path();
+  if (state.socket == NULL)
+  {
+    state.socket = default_socket;
+  }
+
+  // every worker connects on its own, warn only once when there is no server
+  if (state.remote)
+  {
+    int probe = server_connect(state.socket);
+
+    if (probe < 0)
+    {
+      if (!state.silent)
+      {
+        printf("WARNING: no compile server on \"%s\" (%s), compiling locally.\n", state.socket, SDL_GetError());
+      }
+
+      state.remote = false;
+    }
+    else
+    {
+      server_disconnect(probe);
+    }
+  }
+
   // executate the command
-  run(&state);
+  if (!compile_init())
+  {
+    print_error(&state, "ERROR: could not start the compilers: %s\n", SDL_GetError());
+  }
+
+  // a cached front-end would only be compared with itself
+  compile_cache(state.verify ? NULL : state.cache);
+
+  if (state.strip)
+  {
+    run_strip(&state, requested_formats);
+  }
+  else if (state.server)
+  {
+    if (!server_run(state.socket, state.silent))
+    {
+      print_error(&state, "ERROR: could not serve on \"%s\": %s\n", state.socket, SDL_GetError());
+    }
+  }
+  else if (state.stream)
+  {
+    run_stream(&state);
+  }
+  else
+  {
+    run(&state);
+  }
+
+  compile_quit();
+
+  if (state.data != NULL)
+  {
+    fclose(state.data);
+  }
+
+  SDL_free(default_socket);
 
   // free inputs
   for (int i = 0; i < state.inputs->size; i++) 
@@ -805,6 +2721,17 @@ int main(int argc, char** argv)
     struct SDL_SHADER_Input *input = vector_get(state.inputs, i);
     SDL_free(input->path);
     SDL_free(input->base);
+
+    if (input->defines != NULL)
+    {
+      vector_delete(input->defines);
+    }
+
+    if (input->constants != NULL)
+    {
+      vector_delete(input->constants);
+    }
+
     SDL_free(input);
   }
 
@@ -816,7 +2743,40 @@ int main(int argc, char** argv)
     SDL_free(output);
   }
 
+  // free slices
+  for (int i = 0; i < state.slices->size; i++) 
+  {
+    struct SDL_SHADER_Slice *slice = vector_get(state.slices, i);
+    SDL_free(slice->folder);
+    SDL_free(slice);
+  }
+
+  // free manifests
+  for (int i = 0; i < state.manifests->size; i++) 
+  {
+    SDL_free(vector_get(state.manifests, i));
+  }
+
   // delete vectors
   vector_delete(state.inputs);
   vector_delete(state.outputs);
+  vector_delete(state.includes);
+  vector_delete(state.excludes);
+  vector_delete(state.defines);
+  vector_delete(state.constants);
+  vector_delete(state.manifests);
+  vector_delete(state.slices);
+
+  if (state.has_jobserver)
+  {
+    jobserver_close(&state.jobserver);
+  }
+
+  if (state.memory)
+  {
+    report_memory();
+  }
+
+  // any error fails the run, so scripts and build systems notice
+  return SDL_GetAtomicInt(&state.failures) > 0 || compile_failures() > 0 ? 1 : 0;
 }
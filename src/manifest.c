@@ -0,0 +1,93 @@
+#include "manifest.h"
+
+char *manifest_next_line(char **text)
+{
+  char *line = *text;
+  if (*line == '\0')
+  {
+    return NULL;
+  }
+
+  char *end = line;
+  while (*end != '\0' && *end != '\n')
+  {
+    end++;
+  }
+
+  *text = *end == '\n' ? end + 1 : end;
+  *end = '\0';
+
+  // windows line endings
+  if (end > line && end[-1] == '\r')
+  {
+    end[-1] = '\0';
+  }
+
+  return line;
+}
+
+int manifest_tokenize(char *line, char **tokens, int max_tokens)
+{
+  int count = 0;
+  char *src = line;
+
+  while (true)
+  {
+    while (*src == ' ' || *src == '\t')
+    {
+      src++;
+    }
+
+    // the rest is a comment
+    if (*src == '\0' || *src == '#')
+    {
+      break;
+    }
+
+    // quotes are removed by copying the token onto itself
+    char *dst = src;
+    char *token = src;
+    bool quoted = false;
+
+    while (*src != '\0' && (quoted || (*src != ' ' && *src != '\t')))
+    {
+      if (*src == '"')
+      {
+        quoted = !quoted;
+        src++;
+        continue;
+      }
+
+      *dst++ = *src++;
+    }
+
+    bool end = *src == '\0';
+    *dst = '\0';
+
+    if (count < max_tokens)
+    {
+      tokens[count] = token;
+    }
+    count++;
+
+    if (end)
+    {
+      break;
+    }
+    src++;
+  }
+
+  return SDL_min(count, max_tokens);
+}
+
+char *manifest_split(char *token)
+{
+  char *value = SDL_strchr(token, '=');
+  if (value == NULL)
+  {
+    return NULL;
+  }
+
+  *value = '\0';
+  return value + 1;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+/*
+  a manifest lists one shader per line, the input path followed by key=value
+  settings. empty lines and lines starting with "#" are skipped:
+
+    # input               settings
+    shaders/blur.hlsl     stage=compute entry=CSMain define=RADIUS=4 define=FAST formats=spv,msl output=out/blur.bin
+    "shaders/my sky.glsl" stage=fragment
+*/
+
+// splits the next line off a NUL terminated text in place, returns NULL at the end
+char *manifest_next_line(char **text);
+
+// splits a line into tokens in place, double quotes keep spaces together
+// returns the number of tokens, extra tokens past max_tokens are dropped
+int manifest_tokenize(char *line, char **tokens, int max_tokens);
+
+// splits "key=value" in place and returns the value, NULL without a "="
+char *manifest_split(char *token);
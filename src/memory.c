@@ -0,0 +1,162 @@
+#include "memory.h"
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_thread.h>
+
+// in front of every allocation, a multiple of the strictest alignment malloc gives
+#define MEMORY_HEADER_SIZE 16
+
+struct Memory_Header
+{
+  size_t size;
+  SDL_SHADER_MemoryStage stage;
+};
+
+struct Memory
+{
+  bool enabled;
+  SDL_SpinLock lock;
+  SDL_TLSID stage;
+  SDL_SHADER_MemoryStats stats;
+
+  SDL_malloc_func malloc_func;
+  SDL_calloc_func calloc_func;
+  SDL_realloc_func realloc_func;
+  SDL_free_func free_func;
+};
+
+static struct Memory memory = {0};
+
+SDL_SHADER_MemoryStage memory_stage(SDL_SHADER_MemoryStage stage)
+{
+  if (!memory.enabled)
+  {
+    return SDL_SHADER_MEMORY_OTHER;
+  }
+
+  // stored as the pointer value, so setting a stage never allocates
+  SDL_SHADER_MemoryStage previous = (SDL_SHADER_MemoryStage)(uintptr_t)SDL_GetTLS(&memory.stage);
+  SDL_SetTLS(&memory.stage, (void*)(uintptr_t)stage, NULL);
+  return previous;
+}
+
+static void count_alloc(struct Memory_Header *header, size_t size)
+{
+  header->size = size;
+  header->stage = (SDL_SHADER_MemoryStage)(uintptr_t)SDL_GetTLS(&memory.stage);
+
+  SDL_LockSpinlock(&memory.lock);
+  memory.stats.current += size;
+  memory.stats.peak = SDL_max(memory.stats.peak, memory.stats.current);
+  memory.stats.allocations[header->stage] += 1;
+  memory.stats.bytes[header->stage] += size;
+  memory.stats.live_allocations[header->stage] += 1;
+  memory.stats.live_bytes[header->stage] += size;
+  SDL_UnlockSpinlock(&memory.lock);
+}
+
+static void count_free(const struct Memory_Header *header)
+{
+  SDL_LockSpinlock(&memory.lock);
+  memory.stats.current -= header->size;
+  memory.stats.live_allocations[header->stage] -= 1;
+  memory.stats.live_bytes[header->stage] -= header->size;
+  SDL_UnlockSpinlock(&memory.lock);
+}
+
+static void * SDLCALL tracked_malloc(size_t size)
+{
+  if (size > SIZE_MAX - MEMORY_HEADER_SIZE)
+  {
+    return NULL;
+  }
+
+  struct Memory_Header *header = memory.malloc_func(MEMORY_HEADER_SIZE + size);
+  if (header == NULL)
+  {
+    return NULL;
+  }
+
+  count_alloc(header, size);
+  return (Uint8*)header + MEMORY_HEADER_SIZE;
+}
+
+static void * SDLCALL tracked_calloc(size_t count, size_t size)
+{
+  if (size != 0 && count > (SIZE_MAX - MEMORY_HEADER_SIZE) / size)
+  {
+    return NULL;
+  }
+
+  void *mem = tracked_malloc(count * size);
+  if (mem != NULL)
+  {
+    SDL_memset(mem, 0, count * size);
+  }
+
+  return mem;
+}
+
+static void * SDLCALL tracked_realloc(void *mem, size_t size)
+{
+  if (mem == NULL)
+  {
+    return tracked_malloc(size);
+  }
+
+  if (size > SIZE_MAX - MEMORY_HEADER_SIZE)
+  {
+    return NULL;
+  }
+
+  // counted as a free and a new allocation in the current stage
+  struct Memory_Header *header = (struct Memory_Header*)((Uint8*)mem - MEMORY_HEADER_SIZE);
+  struct Memory_Header old = *header;
+
+  header = memory.realloc_func(header, MEMORY_HEADER_SIZE + size);
+  if (header == NULL)
+  {
+    return NULL;
+  }
+
+  count_free(&old);
+  count_alloc(header, size);
+  return (Uint8*)header + MEMORY_HEADER_SIZE;
+}
+
+static void SDLCALL tracked_free(void *mem)
+{
+  if (mem == NULL)
+  {
+    return;
+  }
+
+  struct Memory_Header *header = (struct Memory_Header*)((Uint8*)mem - MEMORY_HEADER_SIZE);
+  count_free(header);
+  memory.free_func(header);
+}
+
+bool SDL_SHADER_EnableMemoryTracking(void)
+{
+  if (memory.enabled)
+  {
+    return true;
+  }
+
+  SDL_GetOriginalMemoryFunctions(&memory.malloc_func, &memory.calloc_func, &memory.realloc_func, &memory.free_func);
+
+  if (!SDL_SetMemoryFunctions(tracked_malloc, tracked_calloc, tracked_realloc, tracked_free))
+  {
+    return false;
+  }
+
+  memory.enabled = true;
+  return true;
+}
+
+void SDL_SHADER_GetMemoryStats(SDL_SHADER_MemoryStats *stats)
+{
+  SDL_LockSpinlock(&memory.lock);
+  *stats = memory.stats;
+  SDL_UnlockSpinlock(&memory.lock);
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <SDL_shader/SDL_shader.h>
+
+// attributes the allocations of the calling thread to a stage, returns the previous one to restore.
+// does nothing unless memory tracking is enabled.
+SDL_SHADER_MemoryStage memory_stage(SDL_SHADER_MemoryStage stage);
@@ -0,0 +1,521 @@
+#include "pack.h"
+
+#include <SDL3/SDL_endian.h>
+#include <SDL3/SDL_filesystem.h>
+
+#define PACK_COPY_CHUNK (64 * 1024)
+
+static int compare_entries(const void *a, const void *b)
+{
+  return SDL_strcmp(((const struct Pack_Entry*)a)->name, ((const struct Pack_Entry*)b)->name);
+}
+
+bool pack_read(SDL_IOStream *io, struct Pack *pack)
+{
+  SDL_zerop(pack);
+
+  char magic[8];
+  Uint32 version;
+  Sint64 file_size = SDL_GetIOSize(io);
+
+  if (SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) < 0 || SDL_ReadIO(io, magic, sizeof(magic)) != sizeof(magic) || SDL_memcmp(magic, PACK_MAGIC, sizeof(magic)) != 0)
+  {
+    return SDL_SetError("not a shader pack");
+  }
+
+  if (!SDL_ReadU32LE(io, &version) || !SDL_ReadU32LE(io, &pack->num_entries) || !SDL_ReadU64LE(io, &pack->index_offset) || !SDL_ReadU64LE(io, &pack->index_size))
+  {
+    return SDL_SetError("shader pack header is truncated");
+  }
+
+  if (version != PACK_VERSION)
+  {
+    return SDL_SetError("unsupported shader pack version %u", version);
+  }
+
+  // every entry needs at least a name size, one character and three 64 bit fields
+  pack->file_size = file_size < 0 ? 0 : (Uint64)file_size;
+  if (pack->index_offset < PACK_HEADER_SIZE || pack->index_offset > pack->file_size || pack->index_size > pack->file_size - pack->index_offset
+    || pack->num_entries > pack->index_size / (sizeof(Uint32) + 1 + 3 * sizeof(Uint64)))
+  {
+    return SDL_SetError("shader pack index is corrupted");
+  }
+
+  Uint8 *index = SDL_malloc(pack->index_size ? pack->index_size : 1);
+  if (SDL_SeekIO(io, (Sint64)pack->index_offset, SDL_IO_SEEK_SET) < 0 || SDL_ReadIO(io, index, pack->index_size) != pack->index_size)
+  {
+    SDL_free(index);
+    return SDL_SetError("shader pack index is truncated");
+  }
+
+  pack->entries = SDL_calloc(pack->num_entries ? pack->num_entries : 1, sizeof(struct Pack_Entry));
+
+  Uint8 *p = index;
+  Uint8 *end = index + pack->index_size;
+  bool valid = true;
+
+  for (Uint32 i = 0; i < pack->num_entries && valid; i++)
+  {
+    struct Pack_Entry *entry = &pack->entries[i];
+    Uint32 name_size;
+    Uint64 value;
+
+    if ((size_t)(end - p) < sizeof(Uint32))
+    {
+      valid = false;
+      break;
+    }
+
+    SDL_memcpy(&name_size, p, sizeof(Uint32));
+    name_size = SDL_Swap32LE(name_size);
+    p += sizeof(Uint32);
+
+    if (name_size == 0 || (size_t)(end - p) < name_size + 3 * sizeof(Uint64) || p[name_size - 1] != '\0')
+    {
+      valid = false;
+      break;
+    }
+
+    entry->name = SDL_strdup((const char*)p);
+    p += name_size;
+
+    SDL_memcpy(&value, p, sizeof(Uint64));
+    entry->offset = SDL_Swap64LE(value);
+    p += sizeof(Uint64);
+
+    SDL_memcpy(&value, p, sizeof(Uint64));
+    entry->size = SDL_Swap64LE(value);
+    p += sizeof(Uint64);
+
+    SDL_memcpy(&value, p, sizeof(Uint64));
+    entry->time = (Sint64)SDL_Swap64LE(value);
+    p += sizeof(Uint64);
+
+    valid = entry->offset >= PACK_HEADER_SIZE && entry->offset <= pack->file_size && entry->size <= pack->file_size - entry->offset;
+  }
+
+  SDL_free(index);
+
+  if (!valid)
+  {
+    pack_free(pack);
+    return SDL_SetError("shader pack index is corrupted");
+  }
+
+  SDL_qsort(pack->entries, pack->num_entries, sizeof(struct Pack_Entry), compare_entries);
+  return true;
+}
+
+void pack_free(struct Pack *pack)
+{
+  if (pack->entries != NULL)
+  {
+    for (Uint32 i = 0; i < pack->num_entries; i++)
+    {
+      SDL_free(pack->entries[i].name);
+    }
+  }
+
+  SDL_free(pack->entries);
+  SDL_zerop(pack);
+}
+
+struct Pack_Entry *pack_find(const struct Pack *pack, const char *name)
+{
+  Uint32 low = 0;
+  Uint32 high = pack->num_entries;
+
+  while (low < high)
+  {
+    Uint32 mid = low + (high - low) / 2;
+    int order = SDL_strcmp(pack->entries[mid].name, name);
+
+    if (order == 0)
+    {
+      return &pack->entries[mid];
+    }
+    else if (order < 0)
+    {
+      low = mid + 1;
+    }
+    else
+    {
+      high = mid;
+    }
+  }
+
+  return NULL;
+}
+
+static int compare_offsets(const void *a, const void *b)
+{
+  const struct Pack_Entry *x = *(const struct Pack_Entry* const*)a;
+  const struct Pack_Entry *y = *(const struct Pack_Entry* const*)b;
+
+  if (x->offset != y->offset)
+  {
+    return x->offset < y->offset ? -1 : 1;
+  }
+
+  return x->size < y->size ? -1 : x->size > y->size;
+}
+
+// the entries in file order, so ones sharing data end up next to each other. free with SDL_free
+static struct Pack_Entry **sort_by_offset(const struct Pack *pack)
+{
+  struct Pack_Entry **sorted = SDL_malloc((pack->num_entries ? pack->num_entries : 1) * sizeof(struct Pack_Entry*));
+  for (Uint32 i = 0; i < pack->num_entries; i++)
+  {
+    sorted[i] = &pack->entries[i];
+  }
+
+  SDL_qsort(sorted, pack->num_entries, sizeof(struct Pack_Entry*), compare_offsets);
+  return sorted;
+}
+
+static bool same_data(const struct Pack_Entry *a, const struct Pack_Entry *b)
+{
+  return a->offset == b->offset && a->size == b->size;
+}
+
+Uint64 pack_dead_size(const struct Pack *pack)
+{
+  struct Pack_Entry **sorted = sort_by_offset(pack);
+
+  // shared data only counts once
+  Uint64 live = PACK_HEADER_SIZE + pack->index_size;
+  for (Uint32 i = 0; i < pack->num_entries; i++)
+  {
+    if (i == 0 || !same_data(sorted[i - 1], sorted[i]))
+    {
+      live += sorted[i]->size;
+    }
+  }
+
+  SDL_free(sorted);
+  return pack->file_size > live ? pack->file_size - live : 0;
+}
+
+static bool write_header(SDL_IOStream *io, const struct Pack *pack)
+{
+  return SDL_SeekIO(io, 0, SDL_IO_SEEK_SET) == 0
+    && SDL_WriteIO(io, PACK_MAGIC, 8) == 8
+    && SDL_WriteU32LE(io, PACK_VERSION)
+    && SDL_WriteU32LE(io, pack->num_entries)
+    && SDL_WriteU64LE(io, pack->index_offset)
+    && SDL_WriteU64LE(io, pack->index_size);
+}
+
+// writes the index at offset and records where it went
+static bool write_index(SDL_IOStream *io, struct Pack *pack, Uint64 offset)
+{
+  if (SDL_SeekIO(io, (Sint64)offset, SDL_IO_SEEK_SET) < 0)
+  {
+    return false;
+  }
+
+  Uint64 size = 0;
+  for (Uint32 i = 0; i < pack->num_entries; i++)
+  {
+    const struct Pack_Entry *entry = &pack->entries[i];
+    Uint32 name_size = (Uint32)SDL_strlen(entry->name) + 1;
+
+    bool written = SDL_WriteU32LE(io, name_size)
+      && SDL_WriteIO(io, entry->name, name_size) == name_size
+      && SDL_WriteU64LE(io, entry->offset)
+      && SDL_WriteU64LE(io, entry->size)
+      && SDL_WriteU64LE(io, (Uint64)entry->time);
+
+    if (!written)
+    {
+      return false;
+    }
+
+    size += sizeof(Uint32) + name_size + 3 * sizeof(Uint64);
+  }
+
+  pack->index_offset = offset;
+  pack->index_size = size;
+  pack->file_size = SDL_max(pack->file_size, offset + size);
+  return true;
+}
+
+bool pack_open_writer(struct Pack_Writer *writer, const char *path)
+{
+  SDL_zerop(writer);
+  writer->path = SDL_strdup(path);
+
+  // update an existing pack
+  SDL_PathInfo info;
+  if (SDL_GetPathInfo(path, &info) && info.type == SDL_PATHTYPE_FILE)
+  {
+    writer->io = SDL_IOFromFile(path, "r+b");
+    if (writer->io == NULL || !pack_read(writer->io, &writer->pack))
+    {
+      if (writer->io != NULL)
+      {
+        SDL_CloseIO(writer->io);
+      }
+      SDL_free(writer->path);
+      return false;
+    }
+
+    writer->end = writer->pack.file_size;
+    return true;
+  }
+
+  // or start a new one
+  writer->io = SDL_IOFromFile(path, "w+b");
+  if (writer->io == NULL)
+  {
+    SDL_free(writer->path);
+    return false;
+  }
+
+  writer->pack.entries = SDL_calloc(1, sizeof(struct Pack_Entry));
+  writer->pack.index_offset = PACK_HEADER_SIZE;
+  writer->pack.file_size = PACK_HEADER_SIZE;
+  writer->end = PACK_HEADER_SIZE;
+  writer->dirty = true;
+
+  return true;
+}
+
+static void add_blob(struct Pack_Writer *writer, Uint64 offset, Uint64 size, const Uint8 digest[HASH_SIZE])
+{
+  struct Pack_Blob *blobs = SDL_realloc(writer->blobs, (writer->num_blobs + 1) * sizeof(struct Pack_Blob));
+  if (blobs == NULL)
+  {
+    return;
+  }
+
+  writer->blobs = blobs;
+  blobs[writer->num_blobs].offset = offset;
+  blobs[writer->num_blobs].size = size;
+  SDL_memcpy(blobs[writer->num_blobs].digest, digest, HASH_SIZE);
+  writer->num_blobs += 1;
+}
+
+static bool is_hashed(const struct Pack_Writer *writer, Uint64 offset, Uint64 size)
+{
+  for (Uint32 i = 0; i < writer->num_blobs; i++)
+  {
+    if (writer->blobs[i].offset == offset && writer->blobs[i].size == size)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// reads back the data of an entry from an earlier run and remembers its digest
+static void hash_entry(struct Pack_Writer *writer, const struct Pack_Entry *entry)
+{
+  Uint8 *chunk = SDL_malloc(PACK_COPY_CHUNK);
+  Uint64 remaining = entry->size;
+  bool success = chunk != NULL && SDL_SeekIO(writer->io, (Sint64)entry->offset, SDL_IO_SEEK_SET) >= 0;
+
+  struct Hash hash;
+  hash_begin(&hash);
+
+  while (remaining > 0 && success)
+  {
+    size_t count = (size_t)SDL_min(remaining, (Uint64)PACK_COPY_CHUNK);
+    success = SDL_ReadIO(writer->io, chunk, count) == count;
+    hash_update(&hash, chunk, count);
+    remaining -= count;
+  }
+
+  Uint8 digest[HASH_SIZE];
+  hash_end(&hash, digest);
+
+  if (success)
+  {
+    add_blob(writer, entry->offset, entry->size, digest);
+  }
+
+  SDL_free(chunk);
+}
+
+// a stored blob with the same content, or NULL
+static const struct Pack_Blob *find_blob(struct Pack_Writer *writer, const Uint8 digest[HASH_SIZE], Uint64 size)
+{
+  for (Uint32 i = 0; i < writer->pack.num_entries; i++)
+  {
+    const struct Pack_Entry *entry = &writer->pack.entries[i];
+    if (entry->size == size && !is_hashed(writer, entry->offset, entry->size))
+    {
+      hash_entry(writer, entry);
+    }
+  }
+
+  for (Uint32 i = 0; i < writer->num_blobs; i++)
+  {
+    if (writer->blobs[i].size == size && SDL_memcmp(writer->blobs[i].digest, digest, HASH_SIZE) == 0)
+    {
+      return &writer->blobs[i];
+    }
+  }
+
+  return NULL;
+}
+
+bool pack_put(struct Pack_Writer *writer, const char *name, const void *data, size_t size, Sint64 time)
+{
+  Uint8 digest[HASH_SIZE];
+  struct Hash hash;
+  hash_begin(&hash);
+  hash_update(&hash, data, size);
+  hash_end(&hash, digest);
+
+  // identical data is only stored once
+  Uint64 offset = writer->end;
+  const struct Pack_Blob *blob = find_blob(writer, digest, size);
+
+  if (blob != NULL)
+  {
+    offset = blob->offset;
+  }
+  else
+  {
+    if (SDL_SeekIO(writer->io, (Sint64)writer->end, SDL_IO_SEEK_SET) < 0 || SDL_WriteIO(writer->io, data, size) != size)
+    {
+      return false;
+    }
+
+    add_blob(writer, offset, size, digest);
+    writer->end += size;
+  }
+
+  struct Pack *pack = &writer->pack;
+  struct Pack_Entry *entry = pack_find(pack, name);
+
+  // insert a new entry keeping the index sorted
+  if (entry == NULL)
+  {
+    Uint32 pos = 0;
+    while (pos < pack->num_entries && SDL_strcmp(pack->entries[pos].name, name) < 0)
+    {
+      pos++;
+    }
+
+    pack->entries = SDL_realloc(pack->entries, (pack->num_entries + 1) * sizeof(struct Pack_Entry));
+    SDL_memmove(&pack->entries[pos + 1], &pack->entries[pos], (pack->num_entries - pos) * sizeof(struct Pack_Entry));
+    pack->num_entries += 1;
+
+    entry = &pack->entries[pos];
+    entry->name = SDL_strdup(name);
+  }
+
+  entry->offset = offset;
+  entry->size = size;
+  entry->time = time;
+
+  pack->file_size = SDL_max(pack->file_size, writer->end);
+  writer->dirty = true;
+
+  return true;
+}
+
+// rewrites the live entries into a fresh file and swaps it in
+static bool compact(struct Pack_Writer *writer)
+{
+  size_t tmp_size = SDL_strlen(writer->path) + 5;
+  char *tmp = SDL_calloc(tmp_size, sizeof(char));
+  SDL_strlcat(tmp, writer->path, tmp_size);
+  SDL_strlcat(tmp, ".tmp", tmp_size);
+
+  SDL_IOStream *dst = SDL_IOFromFile(tmp, "w+b");
+  if (dst == NULL)
+  {
+    SDL_free(tmp);
+    return false;
+  }
+
+  struct Pack compacted = writer->pack;
+  compacted.entries = SDL_malloc((compacted.num_entries ? compacted.num_entries : 1) * sizeof(struct Pack_Entry));
+  SDL_memcpy(compacted.entries, writer->pack.entries, compacted.num_entries * sizeof(struct Pack_Entry));
+  compacted.file_size = 0;
+
+  Uint8 *chunk = SDL_malloc(PACK_COPY_CHUNK);
+  Uint64 offset = PACK_HEADER_SIZE;
+  bool success = SDL_SeekIO(dst, (Sint64)offset, SDL_IO_SEEK_SET) >= 0;
+
+  // data keeps its order, only the gaps go away. shared data is copied once
+  struct Pack_Entry **sorted = sort_by_offset(&compacted);
+  for (Uint32 i = 0; i < compacted.num_entries && success; i++)
+  {
+    struct Pack_Entry *entry = sorted[i];
+
+    // the previous entry was already moved, its old place is still in the writer
+    if (i > 0 && same_data(&writer->pack.entries[sorted[i - 1] - compacted.entries], entry))
+    {
+      entry->offset = sorted[i - 1]->offset;
+      continue;
+    }
+
+    Uint64 remaining = entry->size;
+
+    success = SDL_SeekIO(writer->io, (Sint64)entry->offset, SDL_IO_SEEK_SET) >= 0;
+    while (remaining > 0 && success)
+    {
+      size_t count = (size_t)SDL_min(remaining, (Uint64)PACK_COPY_CHUNK);
+      success = SDL_ReadIO(writer->io, chunk, count) == count && SDL_WriteIO(dst, chunk, count) == count;
+      remaining -= count;
+    }
+
+    entry->offset = offset;
+    offset += entry->size;
+  }
+
+  success = success && write_index(dst, &compacted, offset) && write_header(dst, &compacted);
+  success = SDL_CloseIO(dst) && success;
+
+  SDL_free(sorted);
+  SDL_free(chunk);
+  SDL_free(compacted.entries);
+
+  if (success)
+  {
+    SDL_CloseIO(writer->io);
+    writer->io = NULL;
+    success = SDL_RenamePath(tmp, writer->path);
+  }
+
+  if (!success)
+  {
+    SDL_RemovePath(tmp);
+  }
+
+  SDL_free(tmp);
+  return success;
+}
+
+bool pack_close_writer(struct Pack_Writer *writer, float compact_threshold)
+{
+  bool success = true;
+
+  // the index goes after the new data, the header switches over to it last
+  if (writer->dirty)
+  {
+    success = write_index(writer->io, &writer->pack, writer->end) && SDL_FlushIO(writer->io) && write_header(writer->io, &writer->pack);
+  }
+
+  if (success && writer->pack.file_size > 0 && (float)pack_dead_size(&writer->pack) > compact_threshold * (float)writer->pack.file_size)
+  {
+    success = compact(writer);
+  }
+
+  if (writer->io != NULL)
+  {
+    success = SDL_CloseIO(writer->io) && success;
+  }
+
+  pack_free(&writer->pack);
+  SDL_free(writer->blobs);
+  SDL_free(writer->path);
+  SDL_zerop(writer);
+
+  return success;
+}
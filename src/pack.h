@@ -0,0 +1,78 @@
+#pragma once
+#include "hash.h"
+
+#include <SDL3/SDL_iostream.h>
+
+/*
+  a pack stores many blobs in one file:
+
+    header: "SDLSHPAK", Uint32 version, Uint32 num_entries, Uint64 index_offset, Uint64 index_size
+    data:   blobs, plus dead space left behind by replaced entries
+    index:  per entry: Uint32 name_size, name (NUL terminated), Uint64 offset, Uint64 size, Sint64 time
+
+  updates only ever append: changed blobs and a new index go to the end of the
+  file and the header is rewritten last, so an interrupted update leaves the old
+  index intact. the dead space is reclaimed by compacting once it grows too big.
+
+  entries with byte identical blobs, like variants that compile to the same
+  code, point at the same data instead of storing it again.
+*/
+
+#define PACK_MAGIC "SDLSHPAK"
+#define PACK_VERSION 1
+#define PACK_HEADER_SIZE 32
+
+struct Pack_Entry
+{
+  char *name;
+  Uint64 offset;
+  Uint64 size;
+  Sint64 time;   // modify time of the source the blob was compiled from
+};
+
+struct Pack
+{
+  Uint32 num_entries;
+  struct Pack_Entry *entries;
+  Uint64 index_offset;
+  Uint64 index_size;
+  Uint64 file_size;
+};
+
+// reads the header and index, entries are sorted by name
+bool pack_read(SDL_IOStream *io, struct Pack *pack);
+void pack_free(struct Pack *pack);
+struct Pack_Entry *pack_find(const struct Pack *pack, const char *name);
+
+// bytes not referenced by the header, the index or any entry
+Uint64 pack_dead_size(const struct Pack *pack);
+
+// data stored in the file, found again by its digest
+struct Pack_Blob
+{
+  Uint64 offset;
+  Uint64 size;
+  Uint8 digest[HASH_SIZE];
+};
+
+struct Pack_Writer
+{
+  char *path;
+  SDL_IOStream *io;
+  struct Pack pack;
+  Uint64 end;
+  bool dirty;
+
+  // what pack_put wrote and the older entries hashed so far, those only once a blob of their size comes up
+  struct Pack_Blob *blobs;
+  Uint32 num_blobs;
+};
+
+// opens an existing pack for updating or creates a new one
+bool pack_open_writer(struct Pack_Writer *writer, const char *path);
+
+// appends a blob, replacing any entry with the same name. a blob already in the pack is shared instead
+bool pack_put(struct Pack_Writer *writer, const char *name, const void *data, size_t size, Sint64 time);
+
+// writes the index and header, then compacts when the dead space passes the threshold (0..1 of the file)
+bool pack_close_writer(struct Pack_Writer *writer, float compact_threshold);
@@ -0,0 +1,294 @@
+#include "reflection.h"
+
+#include <SDL3/SDL_endian.h>
+
+/*
+  section layout, every field is a little endian Uint32:
+
+    version, num_resources, num_blocks, num_members, strings_size
+    resources: name, type, set, binding, slot, array_size, readonly, block
+    blocks:    name, size, first_member, num_members
+    members:   name, base_type, offset, size, vecsize, columns, array_size,
+               array_stride, matrix_stride, row_major, runtime_array, block
+    strings:   NUL terminated names, names are offsets into this table
+*/
+
+#define HEADER_FIELDS 5
+#define RESOURCE_FIELDS 8
+#define BLOCK_FIELDS 4
+#define MEMBER_FIELDS 12
+
+static Uint8 *put_le32(Uint8 *dst, Uint32 value)
+{
+  Uint32 tmp = SDL_Swap32LE(value);
+  SDL_memcpy(dst, &tmp, sizeof(Uint32));
+  return dst + sizeof(Uint32);
+}
+
+static const Uint8 *get_le32(const Uint8 *src, Uint32 *value)
+{
+  Uint32 tmp;
+  SDL_memcpy(&tmp, src, sizeof(Uint32));
+  *value = SDL_Swap32LE(tmp);
+  return src + sizeof(Uint32);
+}
+
+static size_t name_size(const char *name)
+{
+  return name == NULL || *name == '\0' ? 0 : SDL_strlen(name) + 1;
+}
+
+// appends a name to the string table and returns its offset, 0 is the empty string
+static Uint32 put_name(char *strings, size_t *strings_size, const char *name)
+{
+  size_t size = name_size(name);
+  if (size == 0)
+  {
+    return 0;
+  }
+
+  Uint32 offset = (Uint32)*strings_size;
+  SDL_memcpy(strings + offset, name, size);
+  *strings_size += size;
+  return offset;
+}
+
+Uint8 *reflection_encode(const SDL_SHADER_Reflection *reflection, size_t *size)
+{
+  Uint32 num_members = 0;
+  size_t strings_size = 1;
+
+  for (Uint32 i = 0; i < reflection->num_resources; i++)
+  {
+    strings_size += name_size(reflection->resources[i].name);
+  }
+
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    const SDL_SHADER_Block *block = &reflection->blocks[i];
+    strings_size += name_size(block->name);
+    num_members += block->num_members;
+
+    for (Uint32 j = 0; j < block->num_members; j++)
+    {
+      strings_size += name_size(block->members[j].name);
+    }
+  }
+
+  // build the string table first so the offsets are known
+  char *strings = SDL_calloc(strings_size, sizeof(char));
+  size_t strings_pos = 1;
+
+  size_t bin_size = sizeof(Uint32) * (HEADER_FIELDS
+    + RESOURCE_FIELDS * reflection->num_resources
+    + BLOCK_FIELDS * reflection->num_blocks
+    + MEMBER_FIELDS * num_members) + strings_size;
+
+  Uint8 *bin = SDL_malloc(bin_size);
+  Uint8 *p = bin;
+
+  p = put_le32(p, SDL_SHADER_REFLECTION_VERSION);
+  p = put_le32(p, reflection->num_resources);
+  p = put_le32(p, reflection->num_blocks);
+  p = put_le32(p, num_members);
+  p = put_le32(p, (Uint32)strings_size);
+
+  for (Uint32 i = 0; i < reflection->num_resources; i++)
+  {
+    const SDL_SHADER_Resource *resource = &reflection->resources[i];
+    p = put_le32(p, put_name(strings, &strings_pos, resource->name));
+    p = put_le32(p, resource->type);
+    p = put_le32(p, resource->set);
+    p = put_le32(p, resource->binding);
+    p = put_le32(p, resource->slot);
+    p = put_le32(p, resource->array_size);
+    p = put_le32(p, resource->readonly);
+    p = put_le32(p, (Uint32)resource->block);
+  }
+
+  Uint32 first_member = 0;
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    const SDL_SHADER_Block *block = &reflection->blocks[i];
+    p = put_le32(p, put_name(strings, &strings_pos, block->name));
+    p = put_le32(p, block->size);
+    p = put_le32(p, first_member);
+    p = put_le32(p, block->num_members);
+    first_member += block->num_members;
+  }
+
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    const SDL_SHADER_Block *block = &reflection->blocks[i];
+    for (Uint32 j = 0; j < block->num_members; j++)
+    {
+      const SDL_SHADER_Member *member = &block->members[j];
+      p = put_le32(p, put_name(strings, &strings_pos, member->name));
+      p = put_le32(p, member->base_type);
+      p = put_le32(p, member->offset);
+      p = put_le32(p, member->size);
+      p = put_le32(p, member->vecsize);
+      p = put_le32(p, member->columns);
+      p = put_le32(p, member->array_size);
+      p = put_le32(p, member->array_stride);
+      p = put_le32(p, member->matrix_stride);
+      p = put_le32(p, member->row_major);
+      p = put_le32(p, member->runtime_array);
+      p = put_le32(p, (Uint32)member->block);
+    }
+  }
+
+  SDL_memcpy(p, strings, strings_size);
+  SDL_free(strings);
+
+  *size = bin_size;
+  return bin;
+}
+
+SDL_SHADER_Reflection *reflection_decode(const Uint8 *data, size_t size)
+{
+  Uint32 version, num_resources, num_blocks, num_members, strings_size;
+
+  if (size < HEADER_FIELDS * sizeof(Uint32))
+  {
+    SDL_SetError("reflection section is truncated");
+    return NULL;
+  }
+
+  const Uint8 *p = data;
+  p = get_le32(p, &version);
+  p = get_le32(p, &num_resources);
+  p = get_le32(p, &num_blocks);
+  p = get_le32(p, &num_members);
+  p = get_le32(p, &strings_size);
+
+  if (version != SDL_SHADER_REFLECTION_VERSION)
+  {
+    SDL_SetError("unsupported reflection version %u", version);
+    return NULL;
+  }
+
+  Uint64 table_size = (Uint64)sizeof(Uint32) * (HEADER_FIELDS
+    + (Uint64)RESOURCE_FIELDS * num_resources
+    + (Uint64)BLOCK_FIELDS * num_blocks
+    + (Uint64)MEMBER_FIELDS * num_members);
+
+  if (table_size + strings_size != size || strings_size == 0 || data[size - 1] != '\0')
+  {
+    SDL_SetError("reflection section is corrupted");
+    return NULL;
+  }
+
+  const char *section_strings = (const char*)data + table_size;
+
+  // one allocation for everything, strings go last
+  size_t alloc_size = sizeof(SDL_SHADER_Reflection)
+    + num_resources * sizeof(SDL_SHADER_Resource)
+    + num_blocks * sizeof(SDL_SHADER_Block)
+    + num_members * sizeof(SDL_SHADER_Member)
+    + strings_size;
+
+  Uint8 *memory = SDL_malloc(alloc_size);
+  if (memory == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_SHADER_Reflection *reflection = (SDL_SHADER_Reflection*)memory;
+  SDL_SHADER_Resource *resources = (SDL_SHADER_Resource*)(reflection + 1);
+  SDL_SHADER_Block *blocks = (SDL_SHADER_Block*)(resources + num_resources);
+  SDL_SHADER_Member *members = (SDL_SHADER_Member*)(blocks + num_blocks);
+  char *strings = (char*)(members + num_members);
+  SDL_memcpy(strings, section_strings, strings_size);
+
+  reflection->num_resources = num_resources;
+  reflection->resources = resources;
+  reflection->num_blocks = num_blocks;
+  reflection->blocks = blocks;
+
+  Uint32 name, value;
+  bool valid = true;
+
+  for (Uint32 i = 0; i < num_resources; i++)
+  {
+    SDL_SHADER_Resource *resource = &resources[i];
+    p = get_le32(p, &name);
+    p = get_le32(p, &value);
+    resource->type = (SDL_SHADER_ResourceType)value;
+    p = get_le32(p, &resource->set);
+    p = get_le32(p, &resource->binding);
+    p = get_le32(p, &resource->slot);
+    p = get_le32(p, &resource->array_size);
+    p = get_le32(p, &value);
+    resource->readonly = value != 0;
+    p = get_le32(p, &value);
+    resource->block = (Sint32)value;
+
+    valid &= name < strings_size && resource->block >= -1 && resource->block < (Sint32)num_blocks;
+    resource->name = strings + (name < strings_size ? name : 0);
+  }
+
+  for (Uint32 i = 0; i < num_blocks; i++)
+  {
+    SDL_SHADER_Block *block = &blocks[i];
+    Uint32 first_member;
+    p = get_le32(p, &name);
+    p = get_le32(p, &block->size);
+    p = get_le32(p, &first_member);
+    p = get_le32(p, &block->num_members);
+
+    valid &= name < strings_size && first_member <= num_members && block->num_members <= num_members - first_member;
+    block->name = strings + (name < strings_size ? name : 0);
+    block->members = valid ? members + first_member : members;
+  }
+
+  for (Uint32 i = 0; i < num_members; i++)
+  {
+    SDL_SHADER_Member *member = &members[i];
+    p = get_le32(p, &name);
+    p = get_le32(p, &value);
+    member->base_type = (SDL_SHADER_BaseType)value;
+    p = get_le32(p, &member->offset);
+    p = get_le32(p, &member->size);
+    p = get_le32(p, &member->vecsize);
+    p = get_le32(p, &member->columns);
+    p = get_le32(p, &member->array_size);
+    p = get_le32(p, &member->array_stride);
+    p = get_le32(p, &member->matrix_stride);
+    p = get_le32(p, &value);
+    member->row_major = value != 0;
+    p = get_le32(p, &value);
+    member->runtime_array = value != 0;
+    p = get_le32(p, &value);
+    member->block = (Sint32)value;
+
+    valid &= name < strings_size && member->block >= -1 && member->block < (Sint32)num_blocks;
+    member->name = strings + (name < strings_size ? name : 0);
+  }
+
+  if (!valid)
+  {
+    SDL_free(memory);
+    SDL_SetError("reflection section is corrupted");
+    return NULL;
+  }
+
+  return reflection;
+}
+
+void reflection_free(SDL_SHADER_Reflection *reflection)
+{
+  if (reflection == NULL)
+  {
+    return;
+  }
+
+  for (Uint32 i = 0; i < reflection->num_blocks; i++)
+  {
+    SDL_free((void*)reflection->blocks[i].members);
+  }
+
+  SDL_free((void*)reflection->resources);
+  SDL_free((void*)reflection->blocks);
+  SDL_free(reflection);
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <SDL_shader/SDL_shader.h>
+
+#define SDL_SHADER_REFLECTION_VERSION 2
+
+// serializes reflection into the payload of a SDL_SHADER_SECTION_REFLECTION entry
+Uint8 *reflection_encode(const SDL_SHADER_Reflection *reflection, size_t *size);
+
+// parses a reflection section into a single allocation that SDL_free() releases
+SDL_SHADER_Reflection *reflection_decode(const Uint8 *data, size_t size);
+
+// frees reflection built by spirv_reflect()
+void reflection_free(SDL_SHADER_Reflection *reflection);
@@ -0,0 +1,302 @@
+#include "scan.h"
+
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_platform.h>
+#include <SDL3/SDL_thread.h>
+
+#ifdef SDL_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#define SCAN_MAX_THREADS 32
+
+struct Scan
+{
+  char *folder;              // with a trailing separator
+  bool recursive;
+  struct Vector *includes;
+  struct Vector *excludes;
+
+  SDL_Mutex *mutex;
+  SDL_Condition *condition;
+  struct Vector *queue;      // relative paths waiting for a stat
+  int pending;               // queued plus in flight
+  struct Vector *files;
+};
+
+struct Scan_Listing
+{
+  struct Scan *scan;
+  const char *prefix;        // relative path of the listed folder, NULL for the root
+};
+
+bool glob_match(const char *pattern, const char *path)
+{
+  while (*pattern != '\0')
+  {
+    // "**" spans folders, "**/" also matches no folder at all
+    if (pattern[0] == '*' && pattern[1] == '*')
+    {
+      pattern += 2;
+      bool slash = *pattern == '/';
+      if (slash)
+      {
+        pattern++;
+      }
+
+      for (const char *p = path; ; p++)
+      {
+        if ((!slash || p == path || p[-1] == '/') && glob_match(pattern, p))
+        {
+          return true;
+        }
+
+        if (*p == '\0')
+        {
+          return false;
+        }
+      }
+    }
+
+    // "*" stays within one path component
+    if (*pattern == '*')
+    {
+      pattern++;
+      for (const char *p = path; ; p++)
+      {
+        if (glob_match(pattern, p))
+        {
+          return true;
+        }
+
+        if (*p == '\0' || *p == '/')
+        {
+          return false;
+        }
+      }
+    }
+
+    if (*path == '\0')
+    {
+      return false;
+    }
+
+    if (*pattern == '?' ? *path == '/' : *pattern != *path)
+    {
+      return false;
+    }
+
+    pattern++;
+    path++;
+  }
+
+  return *path == '\0';
+}
+
+static bool scan_matches(struct Vector *patterns, const char *name)
+{
+  const char *file = SDL_strrchr(name, '/');
+  file = file != NULL ? file + 1 : name;
+
+  for (size_t i = 0; i < patterns->size; i++)
+  {
+    const char *pattern = vector_get(patterns, i);
+    if (glob_match(pattern, SDL_strchr(pattern, '/') != NULL ? name : file))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static SDL_EnumerationResult SDLCALL scan_entry(void *userdata, const char *dirname, const char *fname)
+{
+  struct Scan_Listing *listing = userdata;
+  struct Scan *scan = listing->scan;
+
+  char *name;
+  if (listing->prefix != NULL)
+  {
+    SDL_asprintf(&name, "%s/%s", listing->prefix, fname);
+  }
+  else
+  {
+    name = SDL_strdup(fname);
+  }
+
+  SDL_LockMutex(scan->mutex);
+  vector_push(scan->queue, name);
+  scan->pending++;
+  SDL_SignalCondition(scan->condition);
+  SDL_UnlockMutex(scan->mutex);
+
+  return SDL_ENUM_CONTINUE;
+}
+
+// true when the path itself is a symbolic link, or a junction on windows. SDL_GetPathInfo
+// only sees where it leads
+static bool is_link(const char *path)
+{
+#ifdef SDL_PLATFORM_WINDOWS
+  WCHAR *wide = (WCHAR*)SDL_iconv_string("UTF-16LE", "UTF-8", path, SDL_strlen(path) + 1);
+  DWORD attributes = wide != NULL ? GetFileAttributesW(wide) : INVALID_FILE_ATTRIBUTES;
+  SDL_free(wide);
+  return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+#else
+  struct stat info;
+  return lstat(path, &info) == 0 && S_ISLNK(info.st_mode);
+#endif
+}
+
+static void scan_path(struct Scan *scan, char *name)
+{
+  char *path;
+  SDL_asprintf(&path, "%s%s", scan->folder, name);
+
+  SDL_PathInfo info = {0};
+  if (!SDL_GetPathInfo(path, &info))
+  {
+    // vanished while scanning
+    SDL_free(name);
+  }
+  else if (info.type == SDL_PATHTYPE_DIRECTORY)
+  {
+    // excluded folders are never walked, and neither are linked ones: a link to a parent
+    // would be walked forever, and one to a sibling would list its files under two names
+    if (scan->recursive && !scan_matches(scan->excludes, name) && !is_link(path))
+    {
+      struct Scan_Listing listing = { scan, name };
+      SDL_EnumerateDirectory(path, scan_entry, &listing);
+    }
+
+    SDL_free(name);
+  }
+  else if (info.type == SDL_PATHTYPE_FILE
+        && (scan->includes->size == 0 || scan_matches(scan->includes, name))
+        && !scan_matches(scan->excludes, name))
+  {
+    struct Scan_File *file = SDL_malloc(sizeof(struct Scan_File));
+    file->name = name;
+    file->modify_time = info.modify_time;
+
+    SDL_LockMutex(scan->mutex);
+    vector_push(scan->files, file);
+    SDL_UnlockMutex(scan->mutex);
+  }
+  else
+  {
+    SDL_free(name);
+  }
+
+  SDL_free(path);
+}
+
+static int SDLCALL scan_worker(void *data)
+{
+  struct Scan *scan = data;
+
+  SDL_LockMutex(scan->mutex);
+  while (true)
+  {
+    while (scan->queue->size == 0 && scan->pending > 0)
+    {
+      SDL_WaitCondition(scan->condition, scan->mutex);
+    }
+
+    // nothing queued and nothing in flight that could queue more
+    if (scan->queue->size == 0)
+    {
+      break;
+    }
+
+    scan->queue->size--;
+    char *name = scan->queue->data[scan->queue->size];
+    SDL_UnlockMutex(scan->mutex);
+
+    scan_path(scan, name);
+
+    SDL_LockMutex(scan->mutex);
+    scan->pending--;
+    if (scan->pending == 0)
+    {
+      SDL_BroadcastCondition(scan->condition);
+    }
+  }
+  SDL_UnlockMutex(scan->mutex);
+
+  return 0;
+}
+
+static int SDLCALL compare_files(const void *a, const void *b)
+{
+  const struct Scan_File *file_a = *(const struct Scan_File**)a;
+  const struct Scan_File *file_b = *(const struct Scan_File**)b;
+  return SDL_strcmp(file_a->name, file_b->name);
+}
+
+struct Vector *scan_directory(const char *folder, bool recursive, struct Vector *includes, struct Vector *excludes)
+{
+  struct Scan scan;
+  size_t folder_size = SDL_strlen(folder);
+  char last = folder_size > 0 ? folder[folder_size - 1] : '/';
+  SDL_asprintf(&scan.folder, "%s%s", folder, last == '/' || last == '\\' ? "" : "/");
+
+  scan.recursive = recursive;
+  scan.includes = includes;
+  scan.excludes = excludes;
+  scan.mutex = SDL_CreateMutex();
+  scan.condition = SDL_CreateCondition();
+  scan.queue = vector_create(64);
+  scan.pending = 0;
+  scan.files = vector_create(64);
+
+  struct Scan_Listing listing = { &scan, NULL };
+  SDL_EnumerateDirectory(scan.folder, scan_entry, &listing);
+
+  if (scan.queue->size > 0)
+  {
+    // stat calls are mostly waiting on the file system, so use every core
+    SDL_Thread *threads[SCAN_MAX_THREADS];
+    int num_threads = SDL_clamp(SDL_GetNumLogicalCPUCores(), 1, SCAN_MAX_THREADS) - 1;
+
+    for (int i = 0; i < num_threads; i++)
+    {
+      threads[i] = SDL_CreateThread(scan_worker, "scan", &scan);
+    }
+
+    // the calling thread helps out, which also covers failing to create any threads
+    scan_worker(&scan);
+
+    for (int i = 0; i < num_threads; i++)
+    {
+      SDL_WaitThread(threads[i], NULL);
+    }
+  }
+
+  // listing order depends on the file system and on thread timing
+  SDL_qsort(scan.files->data, scan.files->size, sizeof(void*), compare_files);
+
+  vector_delete(scan.queue);
+  SDL_DestroyCondition(scan.condition);
+  SDL_DestroyMutex(scan.mutex);
+  SDL_free(scan.folder);
+
+  return scan.files;
+}
+
+void scan_free(struct Vector *files)
+{
+  for (size_t i = 0; i < files->size; i++)
+  {
+    struct Scan_File *file = vector_get(files, i);
+    SDL_free(file->name);
+    SDL_free(file);
+  }
+
+  vector_delete(files);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "vector.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+struct Scan_File
+{
+  char *name;          // path relative to the scanned folder, always "/" separated
+  SDL_Time modify_time;
+};
+
+// matches "*" and "?" within one path component and "**" across components
+bool glob_match(const char *pattern, const char *path);
+
+/*
+  lists the files in a folder, walking sub folders when recursive. directory
+  listings and stat calls are spread over a pool of threads. links to files
+  are listed like the files, links to folders are not walked.
+
+  a file is kept when it matches any include pattern (or there are none) and
+  no exclude pattern, excluded folders are not walked at all. patterns without
+  a "/" are matched against the file name, others against the relative path.
+
+  returns a vector of struct Scan_File sorted by name, free with scan_free
+*/
+struct Vector *scan_directory(const char *folder, bool recursive, struct Vector *includes, struct Vector *excludes);
+void scan_free(struct Vector *files);
@@ -0,0 +1,855 @@
+// struct ucred for SO_PEERCRED
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
+#include "server.h"
+#include "hash.h"
+#include "reflection.h"
+
+#include <SDL3/SDL_cpuinfo.h>
+#include <SDL3/SDL_endian.h>
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_platform.h>
+#include <SDL3/SDL_thread.h>
+
+#include <stdio.h>
+
+#ifndef SDL_PLATFORM_WINDOWS
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// results kept in memory before the oldest ones are dropped
+#define SERVER_CACHE_LIMIT (256 * 1024 * 1024)
+#define SERVER_CACHE_BUCKETS 4096
+
+// upper bounds for sizes read off the socket
+#define SERVER_MAX_STRINGS 4096
+#define SERVER_MAX_STRING (64 * 1024)
+#define SERVER_MAX_CODE (1024 * 1024 * 1024)
+
+struct Cache_Entry
+{
+  Uint8 key[HASH_SIZE];
+  void *blob;
+  size_t blob_size;
+  Uint8 *section;
+  size_t section_size;
+
+  struct Cache_Entry *next;   // in the same bucket
+  struct Cache_Entry *newer;  // in insertion order
+};
+
+struct Server
+{
+  bool silent;
+  SDL_Semaphore *slots;       // one per core, taken while compiling
+
+  SDL_Mutex *mutex;
+  struct Cache_Entry *buckets[SERVER_CACHE_BUCKETS];
+  struct Cache_Entry *oldest;
+  struct Cache_Entry *newest;
+  size_t cache_size;
+};
+
+static struct Server server;
+static volatile sig_atomic_t stopping;
+
+static void on_signal(int signal)
+{
+  stopping = 1;
+}
+
+static bool send_all(int connection, const void *data, size_t size)
+{
+  const Uint8 *p = data;
+  while (size > 0)
+  {
+    ssize_t count = send(connection, p, size, 0);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (count <= 0)
+    {
+      return false;
+    }
+
+    p += count;
+    size -= count;
+  }
+
+  return true;
+}
+
+static bool recv_all(int connection, void *data, size_t size)
+{
+  Uint8 *p = data;
+  while (size > 0)
+  {
+    ssize_t count = recv(connection, p, size, 0);
+    if (count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+
+    if (count <= 0)
+    {
+      return false;
+    }
+
+    p += count;
+    size -= count;
+  }
+
+  return true;
+}
+
+static bool send_le32(int connection, Uint32 value)
+{
+  Uint32 tmp = SDL_Swap32LE(value);
+  return send_all(connection, &tmp, sizeof(tmp));
+}
+
+static bool send_le64(int connection, Uint64 value)
+{
+  Uint64 tmp = SDL_Swap64LE(value);
+  return send_all(connection, &tmp, sizeof(tmp));
+}
+
+static bool recv_le32(int connection, Uint32 *value)
+{
+  Uint32 tmp;
+  if (!recv_all(connection, &tmp, sizeof(tmp)))
+  {
+    return false;
+  }
+
+  *value = SDL_Swap32LE(tmp);
+  return true;
+}
+
+static bool recv_le64(int connection, Uint64 *value)
+{
+  Uint64 tmp;
+  if (!recv_all(connection, &tmp, sizeof(tmp)))
+  {
+    return false;
+  }
+
+  *value = SDL_Swap64LE(tmp);
+  return true;
+}
+
+// a Uint64 size followed by the data, NULL data is sent as empty
+static bool send_payload(int connection, const void *data, size_t size)
+{
+  return send_le64(connection, data != NULL ? size : 0) && (data == NULL || send_all(connection, data, size));
+}
+
+static bool recv_payload(int connection, void **data, size_t *size)
+{
+  Uint64 payload_size;
+  if (!recv_le64(connection, &payload_size) || payload_size > SERVER_MAX_CODE)
+  {
+    return false;
+  }
+
+  *data = NULL;
+  *size = payload_size;
+
+  if (payload_size > 0)
+  {
+    // terminated like SDL_LoadFile, the compilers may read the source as a string
+    Uint8 *payload = SDL_malloc(payload_size + 1);
+    if (!recv_all(connection, payload, payload_size))
+    {
+      SDL_free(payload);
+      return false;
+    }
+
+    payload[payload_size] = '\0';
+    *data = payload;
+  }
+
+  return true;
+}
+
+static bool send_string(int connection, const char *string)
+{
+  Uint32 size = SDL_strlen(string);
+  return send_le32(connection, size) && send_all(connection, string, size);
+}
+
+// both sides send the same, a server built differently could give other blobs
+static bool send_handshake(int connection)
+{
+  Uint32 versions[COMPILE_NUM_VERSIONS];
+  compile_versions(versions);
+
+  bool sent = send_le32(connection, SERVER_MAGIC) && send_le32(connection, SERVER_VERSION);
+  for (int i = 0; sent && i < COMPILE_NUM_VERSIONS; i++)
+  {
+    sent = send_le32(connection, versions[i]);
+  }
+
+  return sent;
+}
+
+// false when the other side is gone or differs, with the reason in SDL_GetError
+static bool recv_handshake(int connection)
+{
+  Uint32 versions[COMPILE_NUM_VERSIONS];
+  compile_versions(versions);
+
+  Uint32 magic, version;
+  if (!recv_le32(connection, &magic) || !recv_le32(connection, &version))
+  {
+    return SDL_SetError("the connection closed before the handshake");
+  }
+
+  if (magic != SERVER_MAGIC)
+  {
+    return SDL_SetError("the other side is no sdlshader");
+  }
+
+  if (version != SERVER_VERSION)
+  {
+    return SDL_SetError("the other side speaks version %u instead of %u", (unsigned)version, (unsigned)SERVER_VERSION);
+  }
+
+  bool same = true;
+  for (int i = 0; i < COMPILE_NUM_VERSIONS; i++)
+  {
+    Uint32 other;
+    if (!recv_le32(connection, &other))
+    {
+      return SDL_SetError("the connection closed before the handshake");
+    }
+
+    same &= other == versions[i];
+  }
+
+  return same || SDL_SetError("the other side was built with other compilers");
+}
+
+// everything that changes the output, the file name only shows up in errors
+static void request_key(const struct SDL_SHADER_Settings *settings, Uint32 flags, const void *code, size_t code_size, Uint8 key[HASH_SIZE])
+{
+  Uint32 versions[COMPILE_NUM_VERSIONS];
+  compile_versions(versions);
+
+  struct Hash hash;
+  hash_begin(&hash);
+  hash_update_le32(&hash, SERVER_VERSION);
+  for (int i = 0; i < COMPILE_NUM_VERSIONS; i++)
+  {
+    hash_update_le32(&hash, versions[i]);
+  }
+
+  hash_update_le32(&hash, settings->type);
+  hash_update_le32(&hash, settings->lang);
+  hash_update_le32(&hash, settings->formats);
+  hash_update_le32(&hash, flags);
+  hash_update_string(&hash, settings->entry);
+
+  hash_update_le32(&hash, settings->defines->size);
+  for (size_t i = 0; i < settings->defines->size; i++)
+  {
+    hash_update_string(&hash, vector_get(settings->defines, i));
+  }
+
+  size_t num_constants = settings->constants != NULL ? settings->constants->size : 0;
+  hash_update_le32(&hash, num_constants);
+  for (size_t i = 0; i < num_constants; i++)
+  {
+    hash_update_string(&hash, vector_get(settings->constants, i));
+  }
+
+  hash_update(&hash, code, code_size);
+  hash_end(&hash, key);
+}
+
+static void *copy(const void *data, size_t size)
+{
+  if (data == NULL)
+  {
+    return NULL;
+  }
+
+  void *result = SDL_malloc(size);
+  SDL_memcpy(result, data, size);
+  return result;
+}
+
+static Uint32 cache_bucket(const Uint8 key[HASH_SIZE])
+{
+  return (key[0] | (key[1] << 8)) % SERVER_CACHE_BUCKETS;
+}
+
+// hands out copies, as the entry can be dropped once the lock is released
+static bool cache_find(const Uint8 key[HASH_SIZE], void **blob, size_t *blob_size, Uint8 **section, size_t *section_size)
+{
+  bool found = false;
+
+  SDL_LockMutex(server.mutex);
+  for (struct Cache_Entry *entry = server.buckets[cache_bucket(key)]; entry != NULL; entry = entry->next)
+  {
+    if (SDL_memcmp(entry->key, key, HASH_SIZE) == 0)
+    {
+      *blob = copy(entry->blob, entry->blob_size);
+      *blob_size = entry->blob_size;
+      *section = copy(entry->section, entry->section_size);
+      *section_size = entry->section_size;
+      found = true;
+      break;
+    }
+  }
+  SDL_UnlockMutex(server.mutex);
+
+  return found;
+}
+
+static void cache_insert(const Uint8 key[HASH_SIZE], const void *blob, size_t blob_size, const Uint8 *section, size_t section_size)
+{
+  struct Cache_Entry *entry = SDL_calloc(1, sizeof(struct Cache_Entry));
+  SDL_memcpy(entry->key, key, HASH_SIZE);
+  entry->blob = copy(blob, blob_size);
+  entry->blob_size = blob_size;
+  entry->section = copy(section, section_size);
+  entry->section_size = section_size;
+
+  Uint32 bucket = cache_bucket(key);
+
+  SDL_LockMutex(server.mutex);
+  entry->next = server.buckets[bucket];
+  server.buckets[bucket] = entry;
+
+  if (server.newest != NULL)
+  {
+    server.newest->newer = entry;
+  }
+  else
+  {
+    server.oldest = entry;
+  }
+
+  server.newest = entry;
+  server.cache_size += blob_size + section_size;
+
+  // drop the oldest results once over budget, but never the one just added
+  while (server.cache_size > SERVER_CACHE_LIMIT && server.oldest != entry)
+  {
+    struct Cache_Entry *oldest = server.oldest;
+    server.oldest = oldest->newer;
+
+    struct Cache_Entry **link = &server.buckets[cache_bucket(oldest->key)];
+    while (*link != oldest)
+    {
+      link = &(*link)->next;
+    }
+    *link = oldest->next;
+
+    server.cache_size -= oldest->blob_size + oldest->section_size;
+    SDL_free(oldest->blob);
+    SDL_free(oldest->section);
+    SDL_free(oldest);
+  }
+  SDL_UnlockMutex(server.mutex);
+}
+
+// answers one request, false once the client is gone
+static bool serve_request(int connection)
+{
+  Uint32 type, lang, formats, flags, num_strings, num_constants;
+  if (!recv_le32(connection, &type) || !recv_le32(connection, &lang) || !recv_le32(connection, &formats)
+   || !recv_le32(connection, &flags) || !recv_le32(connection, &num_strings) || !recv_le32(connection, &num_constants)
+   || num_strings < 2 || num_strings > SERVER_MAX_STRINGS || num_constants > num_strings - 2)
+  {
+    return false;
+  }
+
+  // entry, filename, the defines, then the last num_constants are spec constants
+  char **strings = SDL_calloc(num_strings, sizeof(char*));
+  bool received = true;
+
+  for (Uint32 i = 0; i < num_strings && received; i++)
+  {
+    Uint32 string_size;
+    received = recv_le32(connection, &string_size) && string_size <= SERVER_MAX_STRING;
+
+    if (received)
+    {
+      strings[i] = SDL_calloc(string_size + 1, sizeof(char));
+      received = recv_all(connection, strings[i], string_size);
+    }
+  }
+
+  void *code = NULL;
+  size_t code_size = 0;
+  received = received && recv_payload(connection, &code, &code_size);
+
+  // anything else would index past the compilers' tables
+  bool valid = type <= SDL_SHADER_TYPE_COMPUTE && lang >= SDL_SHADER_LANG_GLSL && lang <= SDL_SHADER_LANG_HLSL;
+
+  bool served = false;
+  if (received && !valid)
+  {
+    const char *log = "ERROR: the compile server got an unknown shader type or language.\n";
+    served = send_le32(connection, 1)
+          && send_payload(connection, NULL, 0)
+          && send_payload(connection, NULL, 0)
+          && send_payload(connection, log, SDL_strlen(log));
+  }
+  else if (received)
+  {
+    struct SDL_SHADER_Settings settings;
+    settings.type = type;
+    settings.lang = lang;
+    settings.formats = formats;
+    settings.entry = strings[0];
+    settings.filename = strings[1];
+    settings.reflect = (flags & SERVER_FLAG_REFLECT) != 0;
+    settings.defines = vector_create(num_strings);
+    settings.constants = vector_create(num_constants + 1);
+
+    for (Uint32 i = 2; i < num_strings - num_constants; i++)
+    {
+      vector_push(settings.defines, strings[i]);
+    }
+
+    for (Uint32 i = num_strings - num_constants; i < num_strings; i++)
+    {
+      vector_push(settings.constants, strings[i]);
+    }
+
+    Uint8 key[HASH_SIZE];
+    request_key(&settings, flags, code, code_size, key);
+
+    void *blob = NULL;
+    size_t blob_size = 0;
+    Uint8 *section = NULL;
+    size_t section_size = 0;
+    char *log = NULL;
+
+    bool cached = cache_find(key, &blob, &blob_size, &section, &section_size);
+    if (!cached)
+    {
+      SDL_SHADER_Reflection *reflection = NULL;
+
+      SDL_WaitSemaphore(server.slots);
+      compile_capture_begin(&log);
+      blob = compile(code, code_size, &settings, (flags & SERVER_FLAG_WANT_REFLECTION) ? &reflection : NULL, &blob_size);
+      compile_capture_end();
+      SDL_SignalSemaphore(server.slots);
+
+      if (reflection != NULL)
+      {
+        section = reflection_encode(reflection, &section_size);
+        SDL_free(reflection);
+      }
+
+      // failures are not cached, the log names the file they happened in
+      if (blob != NULL)
+      {
+        cache_insert(key, blob, blob_size, section, section_size);
+      }
+    }
+
+    if (!server.silent)
+    {
+      printf("COMPILING: \"%s\"%s.\n", settings.filename, cached ? " (cached)" : "");
+    }
+
+    served = send_le32(connection, blob != NULL ? 0 : 1)
+          && send_payload(connection, blob, blob_size)
+          && send_payload(connection, section, section_size)
+          && send_payload(connection, log, log != NULL ? SDL_strlen(log) : 0);
+
+    vector_delete(settings.defines);
+    vector_delete(settings.constants);
+    SDL_free(blob);
+    SDL_free(section);
+    SDL_free(log);
+  }
+
+  for (Uint32 i = 0; i < num_strings; i++)
+  {
+    SDL_free(strings[i]);
+  }
+
+  SDL_free(strings);
+  SDL_free(code);
+  return served;
+}
+
+static int SDLCALL serve_connection(void *data)
+{
+  int connection = (int)(intptr_t)data;
+
+  // a client that differs compiles locally once it sees the connection close
+  if (send_handshake(connection) && recv_handshake(connection))
+  {
+    while (serve_request(connection))
+    {
+    }
+  }
+
+  close(connection);
+  return 0;
+}
+
+char *server_default_path(void)
+{
+  char *path;
+  const char *runtime = SDL_getenv("XDG_RUNTIME_DIR");
+
+  if (runtime != NULL && *runtime != '\0')
+  {
+    SDL_asprintf(&path, "%s/sdlshader.sock", runtime);
+  }
+  else
+  {
+    // a folder only we can enter, so nobody else can put a socket at the path first. when it
+    // can't be made private the peer check in server_connect still refuses other users
+    char *folder;
+    SDL_asprintf(&folder, "/tmp/sdlshader-%u", (unsigned)getuid());
+    mkdir(folder, S_IRWXU);
+
+    struct stat info;
+    if (lstat(folder, &info) == 0 && S_ISDIR(info.st_mode) && info.st_uid == getuid() && (info.st_mode & (S_IRWXG | S_IRWXO)) != 0)
+    {
+      chmod(folder, S_IRWXU);
+    }
+
+    SDL_asprintf(&path, "%s/sdlshader.sock", folder);
+    SDL_free(folder);
+  }
+
+  return path;
+}
+
+// true when the other end of a connection runs as the same user
+static bool same_user(int connection)
+{
+  uid_t uid;
+
+#ifdef SO_PEERCRED
+  struct ucred credentials;
+  socklen_t size = sizeof(credentials);
+  if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &credentials, &size) != 0)
+  {
+    return false;
+  }
+  uid = credentials.uid;
+#else
+  gid_t gid;
+  if (getpeereid(connection, &uid, &gid) != 0)
+  {
+    return false;
+  }
+#endif
+
+  return uid == getuid();
+}
+
+static bool socket_address(const char *path, struct sockaddr_un *address)
+{
+  SDL_zerop(address);
+  address->sun_family = AF_UNIX;
+
+  if (SDL_strlen(path) >= sizeof(address->sun_path))
+  {
+    return SDL_SetError("socket path \"%s\" is too long", path);
+  }
+
+  SDL_strlcpy(address->sun_path, path, sizeof(address->sun_path));
+  return true;
+}
+
+static int open_connection(const char *path)
+{
+  struct sockaddr_un address;
+  if (!socket_address(path, &address))
+  {
+    return -1;
+  }
+
+  int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (connection < 0)
+  {
+    SDL_SetError("%s", strerror(errno));
+    return -1;
+  }
+
+  if (connect(connection, (struct sockaddr*)&address, sizeof(address)) != 0)
+  {
+    SDL_SetError("%s", strerror(errno));
+    close(connection);
+    return -1;
+  }
+
+  // anybody could have bound the path, only a server of our own user is trusted with compiles
+  if (!same_user(connection))
+  {
+    SDL_SetError("the server on \"%s\" runs as another user", path);
+    close(connection);
+    return -1;
+  }
+
+  // a server going away must not kill the client
+  signal(SIGPIPE, SIG_IGN);
+  return connection;
+}
+
+bool server_run(const char *path, bool silent)
+{
+  struct sockaddr_un address;
+  if (!socket_address(path, &address))
+  {
+    return false;
+  }
+
+  // only a socket left behind by a server that is gone may be replaced, whatever its version
+  int probe = open_connection(path);
+  if (probe >= 0)
+  {
+    server_disconnect(probe);
+    return SDL_SetError("a server is already running on \"%s\"", path);
+  }
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+  {
+    return SDL_SetError("%s", strerror(errno));
+  }
+
+  // never delete whatever else the path names
+  struct stat info;
+  if (lstat(path, &info) == 0)
+  {
+    if (!S_ISSOCK(info.st_mode))
+    {
+      close(listener);
+      return SDL_SetError("\"%s\" exists and is not a socket", path);
+    }
+
+    unlink(path);
+  }
+
+  // other users must not feed this server, the socket is private from the moment it exists
+  mode_t mask = umask(S_IRWXG | S_IRWXO);
+  bool bound = bind(listener, (struct sockaddr*)&address, sizeof(address)) == 0;
+  umask(mask);
+
+  if (!bound || listen(listener, 64) != 0)
+  {
+    SDL_SetError("%s", strerror(errno));
+    close(listener);
+    return false;
+  }
+
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  int num_slots = SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+  server.silent = silent;
+  server.slots = SDL_CreateSemaphore(num_slots);
+  server.mutex = SDL_CreateMutex();
+
+  if (!silent)
+  {
+    printf("SERVING: \"%s\" with %d compile slots.\n", path, num_slots);
+  }
+
+  while (!stopping)
+  {
+    // wake up regularly to notice signals
+    struct pollfd poll_info = { listener, POLLIN, 0 };
+    if (poll(&poll_info, 1, 250) <= 0)
+    {
+      continue;
+    }
+
+    int connection = accept(listener, NULL, NULL);
+    if (connection < 0)
+    {
+      continue;
+    }
+
+    if (!same_user(connection))
+    {
+      close(connection);
+      continue;
+    }
+
+    SDL_Thread *thread = SDL_CreateThread(serve_connection, "serve", (void*)(intptr_t)connection);
+    if (thread == NULL)
+    {
+      close(connection);
+      continue;
+    }
+
+    SDL_DetachThread(thread);
+  }
+
+  close(listener);
+
+  if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+  {
+    unlink(path);
+  }
+
+  // connections may still be in flight, the cache goes away with the process
+  return true;
+}
+
+int server_connect(const char *path)
+{
+  int connection = open_connection(path);
+  if (connection < 0)
+  {
+    return -1;
+  }
+
+  if (!send_handshake(connection) || !recv_handshake(connection))
+  {
+    close(connection);
+    return -1;
+  }
+
+  return connection;
+}
+
+void server_disconnect(int connection)
+{
+  close(connection);
+}
+
+void *server_compile(int connection, void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size, bool *delivered)
+{
+  *delivered = false;
+  *size = 0;
+
+  Uint32 flags = 0;
+  if (settings->reflect)
+  {
+    flags |= SERVER_FLAG_REFLECT;
+  }
+
+  if (reflection != NULL)
+  {
+    flags |= SERVER_FLAG_WANT_REFLECTION;
+  }
+
+  size_t num_constants = settings->constants != NULL ? settings->constants->size : 0;
+
+  bool sent = send_le32(connection, settings->type)
+           && send_le32(connection, settings->lang)
+           && send_le32(connection, settings->formats)
+           && send_le32(connection, flags)
+           && send_le32(connection, 2 + settings->defines->size + num_constants)
+           && send_le32(connection, num_constants)
+           && send_string(connection, settings->entry)
+           && send_string(connection, settings->filename);
+
+  for (size_t i = 0; i < settings->defines->size && sent; i++)
+  {
+    sent = send_string(connection, vector_get(settings->defines, i));
+  }
+
+  for (size_t i = 0; i < num_constants && sent; i++)
+  {
+    sent = send_string(connection, vector_get(settings->constants, i));
+  }
+
+  sent = sent && send_payload(connection, code, code_size);
+
+  Uint32 status;
+  void *blob = NULL;
+  size_t blob_size = 0;
+  void *section = NULL;
+  size_t section_size = 0;
+  void *log = NULL;
+  size_t log_size = 0;
+
+  if (!sent
+   || !recv_le32(connection, &status)
+   || !recv_payload(connection, &blob, &blob_size)
+   || !recv_payload(connection, &section, &section_size)
+   || !recv_payload(connection, &log, &log_size))
+  {
+    SDL_free(blob);
+    SDL_free(section);
+    return NULL;
+  }
+
+  *delivered = true;
+
+  // errors show up in this process like a local compile, the log of a working compile only has warnings
+  if (status != 0)
+  {
+    compile_error("%.*s", (int)log_size, log != NULL ? (char*)log : "");
+  }
+  else if (log != NULL)
+  {
+    compile_warning("%.*s", (int)log_size, (char*)log);
+  }
+
+  SDL_free(log);
+
+  if (reflection != NULL && section != NULL)
+  {
+    *reflection = reflection_decode(section, section_size);
+  }
+
+  SDL_free(section);
+
+  if (status != 0)
+  {
+    SDL_free(blob);
+    return NULL;
+  }
+
+  *size = blob_size;
+  return blob;
+}
+
+#else
+
+char *server_default_path(void)
+{
+  return SDL_strdup("sdlshader.sock");
+}
+
+bool server_run(const char *path, bool silent)
+{
+  return SDL_SetError("compile servers need unix sockets");
+}
+
+int server_connect(const char *path)
+{
+  SDL_SetError("compile servers need unix sockets");
+  return -1;
+}
+
+void server_disconnect(int connection)
+{
+}
+
+void *server_compile(int connection, void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size, bool *delivered)
+{
+  *delivered = false;
+  *size = 0;
+  return NULL;
+}
+
+#endif
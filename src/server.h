@@ -0,0 +1,42 @@
+#pragma once
+#include "compile.h"
+
+/*
+  a compile server keeps the compilers warm and shares a result cache between
+  every sdlshader process of a build. clients talk to it over a unix socket.
+  both sides start with a handshake and close the connection when the other
+  side differs, the client then compiles locally. after that each request is
+  answered in order on the same connection:
+
+    handshake: Uint32 SERVER_MAGIC, Uint32 SERVER_VERSION,
+               Uint32 compiler versions[COMPILE_NUM_VERSIONS]
+    request:  Uint32 type, Uint32 lang, Uint32 formats, Uint32 flags,
+              Uint32 num_strings, Uint32 num_constants,
+              per string: Uint32 size, chars (entry, filename, defines..., spec constants...)
+              Uint64 code_size, code
+    response: Uint32 status, Uint64 blob_size, blob,
+              Uint64 reflection_size, reflection section, Uint64 log_size, log
+
+  all values are little endian, a status of 0 means the blob is valid. the log
+  holds the errors the compile printed.
+*/
+
+#define SERVER_MAGIC   0x52534453  // "SDSR"
+#define SERVER_VERSION 1           // bump when requests, responses or the compile output change
+
+#define SERVER_FLAG_REFLECT         (1u << 0)  // store the reflection section in the blob
+#define SERVER_FLAG_WANT_REFLECTION (1u << 1)  // send the reflection back for headers
+
+// the socket used when none is given, free with SDL_free
+char *server_default_path(void);
+
+// serves compile requests until interrupted
+bool server_run(const char *path, bool silent);
+
+// returns a connection after the handshake or -1
+int server_connect(const char *path);
+void server_disconnect(int connection);
+
+// compiles on the server, the same as compile(). delivered is false when the
+// server could not be reached, the connection is unusable after that.
+void *server_compile(int connection, void *code, size_t code_size, const struct SDL_SHADER_Settings *settings, SDL_SHADER_Reflection **reflection, size_t *size, bool *delivered);
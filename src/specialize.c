@@ -0,0 +1,1326 @@
+#include "specialize.h"
+#include "spirv.h"
+
+#include <SDL3/SDL_error.h>
+
+// the operations the evaluator folds, in function bodies and in OpSpecConstantOp
+enum
+{
+  SPECIALIZE_OP_UCONVERT = 113,
+  SPECIALIZE_OP_SCONVERT = 114,
+  SPECIALIZE_OP_SNEGATE = 126,
+  SPECIALIZE_OP_IADD = 128,
+  SPECIALIZE_OP_ISUB = 130,
+  SPECIALIZE_OP_IMUL = 132,
+  SPECIALIZE_OP_UDIV = 134,
+  SPECIALIZE_OP_SDIV = 135,
+  SPECIALIZE_OP_UMOD = 137,
+  SPECIALIZE_OP_SREM = 138,
+  SPECIALIZE_OP_SMOD = 139,
+  SPECIALIZE_OP_LOGICAL_EQUAL = 164,
+  SPECIALIZE_OP_LOGICAL_NOT_EQUAL = 165,
+  SPECIALIZE_OP_LOGICAL_OR = 166,
+  SPECIALIZE_OP_LOGICAL_AND = 167,
+  SPECIALIZE_OP_LOGICAL_NOT = 168,
+  SPECIALIZE_OP_SELECT = 169,
+  SPECIALIZE_OP_IEQUAL = 170,
+  SPECIALIZE_OP_INOT_EQUAL = 171,
+  SPECIALIZE_OP_UGREATER_THAN = 172,
+  SPECIALIZE_OP_SGREATER_THAN = 173,
+  SPECIALIZE_OP_UGREATER_THAN_EQUAL = 174,
+  SPECIALIZE_OP_SGREATER_THAN_EQUAL = 175,
+  SPECIALIZE_OP_ULESS_THAN = 176,
+  SPECIALIZE_OP_SLESS_THAN = 177,
+  SPECIALIZE_OP_ULESS_THAN_EQUAL = 178,
+  SPECIALIZE_OP_SLESS_THAN_EQUAL = 179,
+  SPECIALIZE_OP_SHIFT_RIGHT_LOGICAL = 194,
+  SPECIALIZE_OP_SHIFT_RIGHT_ARITHMETIC = 195,
+  SPECIALIZE_OP_SHIFT_LEFT_LOGICAL = 196,
+  SPECIALIZE_OP_BITWISE_OR = 197,
+  SPECIALIZE_OP_BITWISE_XOR = 198,
+  SPECIALIZE_OP_BITWISE_AND = 199,
+  SPECIALIZE_OP_NOT = 200
+};
+
+// per id
+enum
+{
+  SPECIALIZE_KNOWN = 1 << 0,    // a scalar bool or integer whose value is known while compiling
+  SPECIALIZE_FIXED = 1 << 1,    // a plain constant, or one after baking
+  SPECIALIZE_BAKED = 1 << 2,    // a spec constant that becomes a plain one
+  SPECIALIZE_REMOVED = 1 << 3   // defined by code that is left out
+};
+
+struct Specialize_Block
+{
+  size_t start;         // word offset of the OpLabel
+  size_t merge;         // word offset of the merge instruction, 0 when there is none
+  size_t terminator;    // word offset of the terminator
+  size_t end;
+  Uint32 label;
+  Uint32 taken;         // the only target of a folded branch, 0 when not folded
+  Uint32 stub_branch;   // the loop header an unreachable continue target branches to
+  bool reachable;
+  bool stub;            // unreachable but named by a merge, only keeps its label and a terminator
+};
+
+struct Specialize_Function
+{
+  size_t start;
+  size_t end;
+  Uint32 id;
+  Uint32 first_block;
+  Uint32 num_blocks;
+  bool removed;
+};
+
+struct Specialize_Module
+{
+  struct SPIRV_Module module;
+  size_t functions;     // word offset of the first function
+  bool defaults;        // unbaked spec constants are known at their defaults, for analysis only
+
+  Uint8 *flags;         // per id
+  Uint64 *values;       // per id, the bits of known and baked constants
+  Uint32 *types;        // per id, the result type
+  Uint32 *labels;       // per id, the block of a label plus one
+
+  struct Specialize_Block *blocks;
+  Uint32 num_blocks;
+  struct Specialize_Function *funcs;
+  Uint32 num_funcs;
+
+  bool workgroup_fixed; // the WorkgroupSize builtin is made of plain constants
+  Uint32 workgroup[3];
+};
+
+static bool has_flag(const struct Specialize_Module *sm, Uint32 id, Uint8 flag)
+{
+  return id < sm->module.bound && (sm->flags[id] & flag) != 0;
+}
+
+static Uint64 width_mask(Uint32 width)
+{
+  return width >= 64 ? ~(Uint64)0 : ((Uint64)1 << width) - 1;
+}
+
+static Sint64 sign_extend(Uint64 value, Uint32 width)
+{
+  if (width == 0 || width >= 64)
+  {
+    return (Sint64)value;
+  }
+
+  Uint64 sign = (Uint64)1 << (width - 1);
+  return (Sint64)(((value & width_mask(width)) ^ sign) - sign);
+}
+
+static const Uint32 *type_inst(const struct Specialize_Module *sm, Uint32 type)
+{
+  return type < sm->module.bound ? sm->module.ids[type].inst : NULL;
+}
+
+// the width of a bool or integer type, 0 for types the evaluator doesn't fold
+static Uint32 scalar_width(const struct Specialize_Module *sm, Uint32 type)
+{
+  const Uint32 *inst = type_inst(sm, type);
+  if (inst == NULL)
+  {
+    return 0;
+  }
+
+  if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_BOOL)
+  {
+    return 1;
+  }
+
+  if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_INT && SPIRV_WORD_COUNT(inst[0]) >= 4 && inst[2] <= 64)
+  {
+    return inst[2];
+  }
+
+  return 0;
+}
+
+static bool is_terminator(Uint32 opcode)
+{
+  return (opcode >= SPIRV_OP_BRANCH && opcode <= SPIRV_OP_UNREACHABLE)
+      || opcode == 4416   // OpTerminateInvocation
+      || opcode == 4448   // OpIgnoreIntersectionKHR
+      || opcode == 4449   // OpTerminateRayKHR
+      || opcode == 5294;  // OpEmitMeshTasksEXT
+}
+
+static bool is_annotation(Uint32 opcode)
+{
+  return opcode == SPIRV_OP_NAME || opcode == SPIRV_OP_MEMBER_NAME || opcode == SPIRV_OP_DECORATE || opcode == SPIRV_OP_MEMBER_DECORATE
+      || opcode == SPIRV_OP_DECORATE_ID || opcode == SPIRV_OP_DECORATE_STRING || opcode == SPIRV_OP_MEMBER_DECORATE_STRING;
+}
+
+// the result id of an instruction in a function, 0 when it has none
+static Uint32 body_result(const Uint32 *inst, Uint32 word_count)
+{
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_LABEL:
+      return word_count >= 2 ? inst[1] : 0;
+
+    case 0:     // OpNop
+    case SPIRV_OP_LINE:
+    case SPIRV_OP_NO_LINE:
+    case SPIRV_OP_STORE:
+    case 63:    // OpCopyMemory
+    case 64:    // OpCopyMemorySized
+    case 99:    // OpImageWrite
+    case 218:   // OpEmitVertex .. OpEndStreamPrimitive
+    case 219:
+    case 220:
+    case 221:
+    case 224:   // OpControlBarrier
+    case 225:   // OpMemoryBarrier
+    case 228:   // OpAtomicStore
+    case SPIRV_OP_LOOP_MERGE:
+    case SPIRV_OP_SELECTION_MERGE:
+    case 256:   // OpLifetimeStart
+    case 257:   // OpLifetimeStop
+    case 5380:  // OpDemoteToHelperInvocation
+      return 0;
+
+    default:
+      return !is_terminator(SPIRV_OPCODE(inst[0])) && word_count >= 3 ? inst[2] : 0;
+  }
+}
+
+// folds an integer or logical operation on known operands
+static bool evaluate(const struct Specialize_Module *sm, Uint32 opcode, Uint32 type, const Uint32 *operands, Uint32 count, Uint64 *result)
+{
+  Uint32 width = scalar_width(sm, type);
+  Uint32 arity = opcode == SPECIALIZE_OP_SELECT ? 3
+               : (opcode == SPECIALIZE_OP_UCONVERT || opcode == SPECIALIZE_OP_SCONVERT || opcode == SPECIALIZE_OP_SNEGATE
+               || opcode == SPECIALIZE_OP_LOGICAL_NOT || opcode == SPECIALIZE_OP_NOT) ? 1 : 2;
+
+  if (width == 0 || count != arity)
+  {
+    return false;
+  }
+
+  Uint64 a[3];
+  for (Uint32 i = 0; i < count; i++)
+  {
+    if (!has_flag(sm, operands[i], SPECIALIZE_KNOWN))
+    {
+      return false;
+    }
+    a[i] = sm->values[operands[i]];
+  }
+
+  // comparisons and conversions work in the width of their operands
+  Uint32 operand_width = scalar_width(sm, sm->types[operands[0]]);
+  Sint64 sa = sign_extend(a[0], operand_width);
+  Sint64 sb = count > 1 ? sign_extend(a[1], operand_width) : 0;
+  Uint64 value;
+
+  switch (opcode)
+  {
+    case SPECIALIZE_OP_UCONVERT: value = a[0]; break;
+    case SPECIALIZE_OP_SCONVERT: value = (Uint64)sa; break;
+    case SPECIALIZE_OP_SNEGATE: value = 0 - a[0]; break;
+    case SPECIALIZE_OP_NOT: value = ~a[0]; break;
+    case SPECIALIZE_OP_IADD: value = a[0] + a[1]; break;
+    case SPECIALIZE_OP_ISUB: value = a[0] - a[1]; break;
+    case SPECIALIZE_OP_IMUL: value = a[0] * a[1]; break;
+    case SPECIALIZE_OP_BITWISE_OR: value = a[0] | a[1]; break;
+    case SPECIALIZE_OP_BITWISE_XOR: value = a[0] ^ a[1]; break;
+    case SPECIALIZE_OP_BITWISE_AND: value = a[0] & a[1]; break;
+
+    case SPECIALIZE_OP_UDIV:
+    case SPECIALIZE_OP_UMOD:
+      if (a[1] == 0)
+      {
+        return false;
+      }
+      value = opcode == SPECIALIZE_OP_UDIV ? a[0] / a[1] : a[0] % a[1];
+      break;
+
+    case SPECIALIZE_OP_SDIV:
+    case SPECIALIZE_OP_SREM:
+    case SPECIALIZE_OP_SMOD:
+      // undefined in SPIR-V, left to the driver
+      if (sb == 0 || (sb == -1 && sa == SDL_MIN_SINT64))
+      {
+        return false;
+      }
+
+      if (opcode == SPECIALIZE_OP_SDIV)
+      {
+        value = (Uint64)(sa / sb);
+      }
+      else
+      {
+        // SMod takes the sign of the divisor
+        Sint64 remainder = sa % sb;
+        if (opcode == SPECIALIZE_OP_SMOD && remainder != 0 && (remainder < 0) != (sb < 0))
+        {
+          remainder += sb;
+        }
+        value = (Uint64)remainder;
+      }
+      break;
+
+    case SPECIALIZE_OP_SHIFT_RIGHT_LOGICAL:
+    case SPECIALIZE_OP_SHIFT_RIGHT_ARITHMETIC:
+    case SPECIALIZE_OP_SHIFT_LEFT_LOGICAL:
+      if (a[1] >= operand_width)
+      {
+        return false;
+      }
+
+      if (opcode == SPECIALIZE_OP_SHIFT_LEFT_LOGICAL)
+      {
+        value = a[0] << a[1];
+      }
+      else if (opcode == SPECIALIZE_OP_SHIFT_RIGHT_LOGICAL)
+      {
+        value = (a[0] & width_mask(operand_width)) >> a[1];
+      }
+      else
+      {
+        value = sa < 0 ? ~(~(Uint64)sa >> a[1]) : (Uint64)sa >> a[1];
+      }
+      break;
+
+    case SPECIALIZE_OP_LOGICAL_EQUAL:
+    case SPECIALIZE_OP_IEQUAL: value = a[0] == a[1]; break;
+    case SPECIALIZE_OP_LOGICAL_NOT_EQUAL:
+    case SPECIALIZE_OP_INOT_EQUAL: value = a[0] != a[1]; break;
+    case SPECIALIZE_OP_LOGICAL_OR: value = a[0] || a[1]; break;
+    case SPECIALIZE_OP_LOGICAL_AND: value = a[0] && a[1]; break;
+    case SPECIALIZE_OP_LOGICAL_NOT: value = !a[0]; break;
+    case SPECIALIZE_OP_SELECT: value = a[0] ? a[1] : a[2]; break;
+    case SPECIALIZE_OP_UGREATER_THAN: value = a[0] > a[1]; break;
+    case SPECIALIZE_OP_SGREATER_THAN: value = sa > sb; break;
+    case SPECIALIZE_OP_UGREATER_THAN_EQUAL: value = a[0] >= a[1]; break;
+    case SPECIALIZE_OP_SGREATER_THAN_EQUAL: value = sa >= sb; break;
+    case SPECIALIZE_OP_ULESS_THAN: value = a[0] < a[1]; break;
+    case SPECIALIZE_OP_SLESS_THAN: value = sa < sb; break;
+    case SPECIALIZE_OP_ULESS_THAN_EQUAL: value = a[0] <= a[1]; break;
+    case SPECIALIZE_OP_SLESS_THAN_EQUAL: value = sa <= sb; break;
+
+    default:
+      return false;
+  }
+
+  *result = value & width_mask(width);
+  return true;
+}
+
+static void set_known(struct Specialize_Module *sm, Uint32 id, Uint32 type, Uint64 value)
+{
+  sm->flags[id] |= SPECIALIZE_KNOWN;
+  sm->types[id] = type;
+  sm->values[id] = value;
+}
+
+// the last "KEY=VALUE" that names a spec constant, NULL when none does
+static const char *requested(const struct Specialize_Module *sm, Uint32 id, struct Vector *constants)
+{
+  const struct SPIRV_Id *info = &sm->module.ids[id];
+
+  for (size_t i = constants != NULL ? constants->size : 0; i > 0; i--)
+  {
+    const char *constant = vector_get(constants, i - 1);
+    const char *equals = SDL_strchr(constant, '=');
+    if (equals == NULL || equals == constant)
+    {
+      continue;
+    }
+
+    size_t key_size = equals - constant;
+    bool numeric = true;
+    for (size_t c = 0; c < key_size && numeric; c++)
+    {
+      numeric = constant[c] >= '0' && constant[c] <= '9';
+    }
+
+    if (numeric)
+    {
+      if ((info->flags & SPIRV_FLAG_SPEC_ID) && SDL_strtoul(constant, NULL, 10) == info->spec_id)
+      {
+        return constant;
+      }
+    }
+    else if (info->name != NULL && SDL_strlen(info->name) == key_size && SDL_strncmp(info->name, constant, key_size) == 0)
+    {
+      return constant;
+    }
+  }
+
+  return NULL;
+}
+
+// reads a value given for a constant of the type into the bits of its literal
+static bool parse_value(const struct Specialize_Module *sm, Uint32 type, const char *text, Uint64 *value)
+{
+  const Uint32 *inst = type_inst(sm, type);
+  if (inst == NULL)
+  {
+    return false;
+  }
+
+  char *end = NULL;
+
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_TYPE_BOOL:
+      if (SDL_strcmp(text, "true") == 0 || SDL_strcmp(text, "1") == 0)
+      {
+        *value = 1;
+        return true;
+      }
+
+      *value = 0;
+      return SDL_strcmp(text, "false") == 0 || SDL_strcmp(text, "0") == 0;
+
+    case SPIRV_OP_TYPE_INT:
+    {
+      Uint32 width = inst[2];
+      if (width > 64)
+      {
+        return false;
+      }
+
+      if (inst[3] != 0)
+      {
+        Sint64 number = SDL_strtoll(text, &end, 0);
+        Sint64 limit = width >= 64 ? SDL_MAX_SINT64 : (Sint64)(width_mask(width) >> 1);
+        *value = (Uint64)number & width_mask(width);
+        return end != text && *end == '\0' && number <= limit && number >= -limit - 1;
+      }
+
+      Uint64 number = SDL_strtoull(text, &end, 0);
+      *value = number;
+      return end != text && *end == '\0' && text[0] != '-' && number <= width_mask(width);
+    }
+
+    case SPIRV_OP_TYPE_FLOAT:
+    {
+      double number = SDL_strtod(text, &end);
+      if (end == text || *end != '\0')
+      {
+        return false;
+      }
+
+      if (inst[2] == 32)
+      {
+        float single = (float)number;
+        Uint32 bits;
+        SDL_memcpy(&bits, &single, sizeof(bits));
+        *value = bits;
+        return true;
+      }
+
+      if (inst[2] == 64)
+      {
+        SDL_memcpy(value, &number, sizeof(*value));
+        return true;
+      }
+
+      return false;
+    }
+
+    default:
+      return false;
+  }
+}
+
+// the literal of an OpConstant as bits
+static Uint64 literal_value(const Uint32 *inst, Uint32 word_count)
+{
+  Uint64 value = inst[3];
+  if (word_count >= 5)
+  {
+    value |= (Uint64)inst[4] << 32;
+  }
+  return value;
+}
+
+// finds which constants are plain and known, baking the requested spec constants on the way
+static bool specialize_constants(struct Specialize_Module *sm, struct Vector *constants)
+{
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < sm->functions; pos += word_count)
+  {
+    inst = &sm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+    if (opcode < SPIRV_OP_CONSTANT_TRUE || opcode > SPIRV_OP_SPEC_CONSTANT_OP || word_count < 3 || inst[2] >= sm->module.bound)
+    {
+      continue;
+    }
+
+    Uint32 type = inst[1];
+    Uint32 id = inst[2];
+    sm->types[id] = type;
+
+    switch (opcode)
+    {
+      case SPIRV_OP_CONSTANT_TRUE:
+      case SPIRV_OP_CONSTANT_FALSE:
+        sm->flags[id] |= SPECIALIZE_FIXED;
+        set_known(sm, id, type, opcode == SPIRV_OP_CONSTANT_TRUE);
+        break;
+
+      case SPIRV_OP_CONSTANT:
+        sm->flags[id] |= SPECIALIZE_FIXED;
+        if (word_count >= 4 && scalar_width(sm, type) != 0)
+        {
+          set_known(sm, id, type, literal_value(inst, word_count) & width_mask(scalar_width(sm, type)));
+        }
+        break;
+
+      case SPIRV_OP_SPEC_CONSTANT_TRUE:
+      case SPIRV_OP_SPEC_CONSTANT_FALSE:
+      case SPIRV_OP_SPEC_CONSTANT:
+      {
+        const char *constant = requested(sm, id, constants);
+        Uint64 value = opcode == SPIRV_OP_SPEC_CONSTANT_TRUE;
+
+        if (constant != NULL)
+        {
+          if (!parse_value(sm, type, SDL_strchr(constant, '=') + 1, &value))
+          {
+            return SDL_SetError("\"%s\" doesn't fit the type of the specialization constant", constant);
+          }
+
+          sm->flags[id] |= SPECIALIZE_FIXED | SPECIALIZE_BAKED;
+          sm->values[id] = value;
+        }
+        else if (!sm->defaults)
+        {
+          break;
+        }
+        else if (opcode == SPIRV_OP_SPEC_CONSTANT)
+        {
+          value = word_count >= 4 ? literal_value(inst, word_count) : 0;
+        }
+
+        if (scalar_width(sm, type) != 0)
+        {
+          set_known(sm, id, type, value & width_mask(scalar_width(sm, type)));
+        }
+        break;
+      }
+
+      case SPIRV_OP_SPEC_CONSTANT_OP:
+      {
+        Uint64 value;
+        if (word_count < 5 || !evaluate(sm, inst[3], type, &inst[4], word_count - 4, &value))
+        {
+          break;
+        }
+
+        set_known(sm, id, type, value);
+
+        bool fixed = true;
+        for (Uint32 i = 4; i < word_count && fixed; i++)
+        {
+          fixed = has_flag(sm, inst[i], SPECIALIZE_FIXED);
+        }
+
+        if (fixed)
+        {
+          sm->flags[id] |= SPECIALIZE_FIXED | SPECIALIZE_BAKED;
+        }
+        break;
+      }
+
+      case SPIRV_OP_SPEC_CONSTANT_COMPOSITE:
+      {
+        bool fixed = true;
+        for (Uint32 i = 3; i < word_count && fixed; i++)
+        {
+          fixed = has_flag(sm, inst[i], SPECIALIZE_FIXED);
+        }
+
+        if (fixed)
+        {
+          sm->flags[id] |= SPECIALIZE_FIXED | SPECIALIZE_BAKED;
+        }
+        break;
+      }
+
+      default:
+        // composites, nulls and samplers
+        if (opcode < SPIRV_OP_SPEC_CONSTANT_TRUE)
+        {
+          sm->flags[id] |= SPECIALIZE_FIXED;
+        }
+        break;
+    }
+  }
+
+  return true;
+}
+
+// the workgroup size from the WorkgroupSize builtin, LocalSizeId or LocalSize, in that order
+static bool find_workgroup(const struct Specialize_Module *sm, Uint32 size[3], bool *fixed)
+{
+  *fixed = false;
+
+  for (Uint32 id = 1; id < sm->module.bound; id++)
+  {
+    const struct SPIRV_Id *info = &sm->module.ids[id];
+    if (!(info->flags & SPIRV_FLAG_BUILTIN) || info->builtin != SPIRV_BUILTIN_WORKGROUP_SIZE || info->inst == NULL
+      || SPIRV_WORD_COUNT(info->inst[0]) < 6)
+    {
+      continue;
+    }
+
+    const Uint32 *inst = info->inst;
+    if (has_flag(sm, inst[3], SPECIALIZE_KNOWN) && has_flag(sm, inst[4], SPECIALIZE_KNOWN) && has_flag(sm, inst[5], SPECIALIZE_KNOWN))
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        size[i] = (Uint32)sm->values[inst[3 + i]];
+      }
+
+      *fixed = has_flag(sm, id, SPECIALIZE_FIXED);
+      return true;
+    }
+  }
+
+  const Uint32 *local_size = NULL;
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < sm->functions; pos += word_count)
+  {
+    inst = &sm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_EXECUTION_MODE_ID && word_count >= 6 && inst[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID
+      && has_flag(sm, inst[3], SPECIALIZE_KNOWN) && has_flag(sm, inst[4], SPECIALIZE_KNOWN) && has_flag(sm, inst[5], SPECIALIZE_KNOWN))
+    {
+      for (int i = 0; i < 3; i++)
+      {
+        size[i] = (Uint32)sm->values[inst[3 + i]];
+      }
+
+      *fixed = has_flag(sm, inst[3], SPECIALIZE_FIXED) && has_flag(sm, inst[4], SPECIALIZE_FIXED) && has_flag(sm, inst[5], SPECIALIZE_FIXED);
+      return true;
+    }
+
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_EXECUTION_MODE && word_count >= 6 && inst[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE)
+    {
+      local_size = inst;
+    }
+  }
+
+  if (local_size != NULL)
+  {
+    size[0] = local_size[3];
+    size[1] = local_size[4];
+    size[2] = local_size[5];
+    *fixed = true;
+    return true;
+  }
+
+  return false;
+}
+
+static bool specialize_open(struct Specialize_Module *sm, const void *code, size_t code_size, struct Vector *constants, bool defaults)
+{
+  SDL_zerop(sm);
+  sm->defaults = defaults;
+
+  if (!spirv_parse(&sm->module, code, code_size))
+  {
+    return false;
+  }
+
+  Uint32 bound = sm->module.bound;
+  sm->flags = SDL_calloc(bound, sizeof(Uint8));
+  sm->values = SDL_calloc(bound, sizeof(Uint64));
+  sm->types = SDL_calloc(bound, sizeof(Uint32));
+  sm->labels = SDL_calloc(bound, sizeof(Uint32));
+  sm->functions = sm->module.word_count;
+
+  if (sm->flags == NULL || sm->values == NULL || sm->types == NULL || sm->labels == NULL)
+  {
+    return false;
+  }
+
+  const Uint32 *inst;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < sm->module.word_count; pos += word_count)
+  {
+    inst = &sm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_FUNCTION)
+    {
+      sm->functions = pos;
+      break;
+    }
+  }
+
+  if (!specialize_constants(sm, constants))
+  {
+    return false;
+  }
+
+  bool fixed;
+  sm->workgroup_fixed = find_workgroup(sm, sm->workgroup, &fixed) && fixed;
+  return true;
+}
+
+static void specialize_close(struct Specialize_Module *sm)
+{
+  spirv_free(&sm->module);
+  SDL_free(sm->flags);
+  SDL_free(sm->values);
+  SDL_free(sm->types);
+  SDL_free(sm->labels);
+  SDL_free(sm->blocks);
+  SDL_free(sm->funcs);
+}
+
+// splits the functions into blocks and evaluates what can be known inside them
+static bool read_functions(struct Specialize_Module *sm)
+{
+  const Uint32 *words = sm->module.words;
+  Uint32 word_count;
+
+  for (size_t pos = sm->functions; pos < sm->module.word_count; pos += word_count)
+  {
+    word_count = SPIRV_WORD_COUNT(words[pos]);
+    sm->num_blocks += SPIRV_OPCODE(words[pos]) == SPIRV_OP_LABEL;
+    sm->num_funcs += SPIRV_OPCODE(words[pos]) == SPIRV_OP_FUNCTION;
+  }
+
+  sm->blocks = SDL_calloc(sm->num_blocks + 1, sizeof(struct Specialize_Block));
+  sm->funcs = SDL_calloc(sm->num_funcs + 1, sizeof(struct Specialize_Function));
+  if (sm->blocks == NULL || sm->funcs == NULL)
+  {
+    return false;
+  }
+
+  struct Specialize_Function *function = NULL;
+  struct Specialize_Block *block = NULL;
+  Uint32 num_blocks = 0;
+  Uint32 num_funcs = 0;
+
+  for (size_t pos = sm->functions; pos < sm->module.word_count; pos += word_count)
+  {
+    const Uint32 *inst = &words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+    if (opcode == SPIRV_OP_FUNCTION)
+    {
+      if (function != NULL || word_count < 3)
+      {
+        return SDL_SetError("SPIR-V module has a function without an end");
+      }
+
+      function = &sm->funcs[num_funcs++];
+      function->start = pos;
+      function->id = inst[2];
+      function->first_block = num_blocks;
+    }
+
+    if (function == NULL)
+    {
+      return SDL_SetError("SPIR-V module has code outside of functions");
+    }
+
+    if (opcode == SPIRV_OP_FUNCTION_END)
+    {
+      if (block != NULL)
+      {
+        return SDL_SetError("SPIR-V module has a block without a terminator");
+      }
+
+      function->end = pos + word_count;
+      function->num_blocks = num_blocks - function->first_block;
+      function = NULL;
+      continue;
+    }
+
+    if (opcode == SPIRV_OP_LABEL)
+    {
+      if (block != NULL || word_count < 2 || inst[1] >= sm->module.bound)
+      {
+        return SDL_SetError("SPIR-V module has a block without a terminator");
+      }
+
+      block = &sm->blocks[num_blocks++];
+      block->start = pos;
+      block->label = inst[1];
+      sm->labels[inst[1]] = num_blocks;
+      continue;
+    }
+
+    if (block != NULL && (opcode == SPIRV_OP_SELECTION_MERGE || opcode == SPIRV_OP_LOOP_MERGE))
+    {
+      block->merge = pos;
+    }
+
+    if (is_terminator(opcode))
+    {
+      if (block == NULL)
+      {
+        return SDL_SetError("SPIR-V module has a terminator outside of a block");
+      }
+
+      block->terminator = pos;
+      block->end = pos + word_count;
+      block = NULL;
+      continue;
+    }
+
+    Uint32 id = body_result(inst, word_count);
+    if (id == 0 || id >= sm->module.bound)
+    {
+      continue;
+    }
+
+    sm->types[id] = inst[1];
+
+    Uint64 value;
+    if (word_count >= 4 && evaluate(sm, opcode, inst[1], &inst[3], word_count - 3, &value))
+    {
+      set_known(sm, id, inst[1], value);
+    }
+  }
+
+  if (function != NULL)
+  {
+    return SDL_SetError("SPIR-V module has a function without an end");
+  }
+
+  return true;
+}
+
+static struct Specialize_Block *find_block(const struct Specialize_Module *sm, Uint32 label)
+{
+  return label < sm->module.bound && sm->labels[label] != 0 ? &sm->blocks[sm->labels[label] - 1] : NULL;
+}
+
+// how many words a case literal of the switch takes
+static Uint32 case_words(const struct Specialize_Module *sm, const Uint32 *inst)
+{
+  return inst[1] < sm->module.bound && scalar_width(sm, sm->types[inst[1]]) > 32 ? 2 : 1;
+}
+
+// the i-th block a block can branch to, 0 past the last one
+static Uint32 successor(const struct Specialize_Module *sm, const struct Specialize_Block *block, Uint32 i)
+{
+  if (block->taken != 0)
+  {
+    return i == 0 ? block->taken : 0;
+  }
+
+  const Uint32 *inst = &sm->module.words[block->terminator];
+  Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_BRANCH:
+      return i == 0 && word_count >= 2 ? inst[1] : 0;
+
+    case SPIRV_OP_BRANCH_CONDITIONAL:
+      return i < 2 && word_count >= 4 ? inst[2 + i] : 0;
+
+    case SPIRV_OP_SWITCH:
+    {
+      if (i == 0)
+      {
+        return word_count >= 3 ? inst[2] : 0;
+      }
+
+      // literal and label pairs follow the default
+      size_t at = 2 + (size_t)i * (case_words(sm, inst) + 1);
+      return at < word_count ? inst[at] : 0;
+    }
+
+    default:
+      return 0;
+  }
+}
+
+static bool branches_to(const struct Specialize_Module *sm, const struct Specialize_Block *block, Uint32 label)
+{
+  Uint32 target;
+  for (Uint32 i = 0; (target = successor(sm, block, i)) != 0; i++)
+  {
+    if (target == label)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// picks the target of conditional branches and switches on known values, loop headers are left alone
+static void fold_branches(struct Specialize_Module *sm)
+{
+  for (Uint32 b = 0; b < sm->num_blocks; b++)
+  {
+    struct Specialize_Block *block = &sm->blocks[b];
+    const Uint32 *inst = &sm->module.words[block->terminator];
+    Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (block->merge != 0 && SPIRV_OPCODE(sm->module.words[block->merge]) == SPIRV_OP_LOOP_MERGE)
+    {
+      continue;
+    }
+
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_BRANCH_CONDITIONAL && word_count >= 4 && has_flag(sm, inst[1], SPECIALIZE_KNOWN))
+    {
+      block->taken = sm->values[inst[1]] ? inst[2] : inst[3];
+    }
+    else if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_SWITCH && word_count >= 3 && has_flag(sm, inst[1], SPECIALIZE_KNOWN))
+    {
+      Uint32 literal_words = case_words(sm, inst);
+      Uint64 mask = width_mask(scalar_width(sm, sm->types[inst[1]]));
+      block->taken = inst[2];
+
+      for (size_t at = 3; at + literal_words < word_count; at += literal_words + 1)
+      {
+        Uint64 literal = inst[at];
+        if (literal_words == 2)
+        {
+          literal |= (Uint64)inst[at + 1] << 32;
+        }
+
+        if ((literal & mask) == sm->values[inst[1]])
+        {
+          block->taken = inst[at + literal_words];
+          break;
+        }
+      }
+    }
+  }
+}
+
+// marks the blocks a function can still reach, and the unreachable ones a merge names as stubs
+static void find_reachable(struct Specialize_Module *sm, const struct Specialize_Function *function, Uint32 *stack)
+{
+  if (function->num_blocks == 0)
+  {
+    return;
+  }
+
+  Uint32 count = 0;
+  stack[count++] = function->first_block;
+  sm->blocks[function->first_block].reachable = true;
+
+  while (count > 0)
+  {
+    struct Specialize_Block *block = &sm->blocks[stack[--count]];
+    Uint32 target;
+
+    for (Uint32 i = 0; (target = successor(sm, block, i)) != 0; i++)
+    {
+      struct Specialize_Block *next = find_block(sm, target);
+      if (next != NULL && !next->reachable)
+      {
+        next->reachable = true;
+        stack[count++] = (Uint32)(next - sm->blocks);
+      }
+    }
+  }
+
+  for (Uint32 b = function->first_block; b < function->first_block + function->num_blocks; b++)
+  {
+    struct Specialize_Block *block = &sm->blocks[b];
+    if (!block->reachable || block->merge == 0 || block->taken != 0)
+    {
+      continue;
+    }
+
+    const Uint32 *merge = &sm->module.words[block->merge];
+    struct Specialize_Block *merge_block = find_block(sm, merge[1]);
+    if (merge_block != NULL && !merge_block->reachable)
+    {
+      merge_block->stub = true;
+    }
+
+    // continue targets go back to their header
+    if (SPIRV_OPCODE(merge[0]) == SPIRV_OP_LOOP_MERGE && SPIRV_WORD_COUNT(merge[0]) >= 3)
+    {
+      struct Specialize_Block *continue_block = find_block(sm, merge[2]);
+      if (continue_block != NULL && !continue_block->reachable)
+      {
+        continue_block->stub = true;
+        continue_block->stub_branch = block->label;
+      }
+    }
+  }
+}
+
+static void remove_results(struct Specialize_Module *sm, size_t start, size_t end)
+{
+  Uint32 word_count;
+  for (size_t pos = start; pos < end; pos += word_count)
+  {
+    const Uint32 *inst = &sm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    Uint32 id = SPIRV_OPCODE(inst[0]) == SPIRV_OP_FUNCTION || SPIRV_OPCODE(inst[0]) == SPIRV_OP_FUNCTION_PARAMETER
+              ? inst[2] : body_result(inst, word_count);
+    if (id != 0 && id < sm->module.bound)
+    {
+      sm->flags[id] |= SPECIALIZE_REMOVED;
+    }
+  }
+}
+
+// removes functions that no kept code calls anymore, until nothing changes
+static bool remove_functions(struct Specialize_Module *sm)
+{
+  bool *called = SDL_calloc(sm->module.bound, sizeof(bool));
+  if (called == NULL)
+  {
+    return false;
+  }
+
+  bool changed = true;
+  while (changed)
+  {
+    changed = false;
+    SDL_memset(called, 0, sm->module.bound * sizeof(bool));
+
+    Uint32 word_count;
+    for (size_t pos = SPIRV_HEADER_WORDS; pos < sm->functions; pos += word_count)
+    {
+      const Uint32 *inst = &sm->module.words[pos];
+      word_count = SPIRV_WORD_COUNT(inst[0]);
+      if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_ENTRY_POINT && word_count >= 3 && inst[2] < sm->module.bound)
+      {
+        called[inst[2]] = true;
+      }
+    }
+
+    for (Uint32 f = 0; f < sm->num_funcs; f++)
+    {
+      const struct Specialize_Function *function = &sm->funcs[f];
+      for (Uint32 b = function->first_block; !function->removed && b < function->first_block + function->num_blocks; b++)
+      {
+        const struct Specialize_Block *block = &sm->blocks[b];
+        for (size_t pos = block->start; block->reachable && pos < block->end; pos += word_count)
+        {
+          const Uint32 *inst = &sm->module.words[pos];
+          word_count = SPIRV_WORD_COUNT(inst[0]);
+          if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_FUNCTION_CALL && word_count >= 4 && inst[3] < sm->module.bound)
+          {
+            called[inst[3]] = true;
+          }
+        }
+      }
+    }
+
+    for (Uint32 f = 0; f < sm->num_funcs; f++)
+    {
+      struct Specialize_Function *function = &sm->funcs[f];
+
+      // declarations without a body are linked in, they stay
+      if (!function->removed && function->num_blocks > 0 && function->id < sm->module.bound && !called[function->id])
+      {
+        function->removed = true;
+        changed = true;
+      }
+    }
+  }
+
+  SDL_free(called);
+  return true;
+}
+
+static size_t put_constant(const struct Specialize_Module *sm, Uint32 type, Uint32 id, Uint32 *copy, size_t count)
+{
+  const Uint32 *inst = type_inst(sm, type);
+  Uint64 value = sm->values[id];
+
+  if (inst != NULL && SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_BOOL)
+  {
+    copy[count++] = (3u << 16) | (value ? SPIRV_OP_CONSTANT_TRUE : SPIRV_OP_CONSTANT_FALSE);
+    copy[count++] = type;
+    copy[count++] = id;
+    return count;
+  }
+
+  Uint32 width = inst != NULL && SPIRV_WORD_COUNT(inst[0]) >= 3 ? inst[2] : 32;
+  bool is_signed = inst != NULL && SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_INT && inst[3] != 0;
+
+  // narrow signed literals are sign extended to the word
+  if (width < 32 && is_signed)
+  {
+    value = (Uint64)sign_extend(value, width);
+  }
+
+  copy[count++] = ((width > 32 ? 5u : 4u) << 16) | SPIRV_OP_CONSTANT;
+  copy[count++] = type;
+  copy[count++] = id;
+  copy[count++] = (Uint32)value;
+  if (width > 32)
+  {
+    copy[count++] = (Uint32)(value >> 32);
+  }
+  return count;
+}
+
+static size_t put_local_size(const Uint32 *inst, const Uint32 size[3], Uint32 *copy, size_t count)
+{
+  copy[count++] = (6u << 16) | SPIRV_OP_EXECUTION_MODE;
+  copy[count++] = inst[1];
+  copy[count++] = SPIRV_EXECUTION_MODE_LOCAL_SIZE;
+  copy[count++] = size[0];
+  copy[count++] = size[1];
+  copy[count++] = size[2];
+  return count;
+}
+
+// copies an instruction before the functions, baking constants and dropping what is gone
+static size_t copy_global(const struct Specialize_Module *sm, const Uint32 *inst, Uint32 *copy, size_t count)
+{
+  Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+  Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+  if (is_annotation(opcode) && word_count >= 2)
+  {
+    if (has_flag(sm, inst[1], SPECIALIZE_REMOVED))
+    {
+      return count;
+    }
+
+    // only spec constants take a SpecId
+    if (opcode == SPIRV_OP_DECORATE && word_count >= 3 && inst[2] == SPIRV_DECORATION_SPEC_ID && has_flag(sm, inst[1], SPECIALIZE_BAKED))
+    {
+      return count;
+    }
+  }
+
+  if (opcode == SPIRV_OP_EXECUTION_MODE && word_count >= 6 && inst[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE && sm->workgroup_fixed)
+  {
+    return put_local_size(inst, sm->workgroup, copy, count);
+  }
+
+  if (opcode == SPIRV_OP_EXECUTION_MODE_ID && word_count >= 6 && inst[2] == SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID)
+  {
+    Uint32 size[3];
+    bool fixed = true;
+    for (int i = 0; i < 3 && fixed; i++)
+    {
+      fixed = has_flag(sm, inst[3 + i], SPECIALIZE_FIXED) && has_flag(sm, inst[3 + i], SPECIALIZE_KNOWN);
+      size[i] = fixed ? (Uint32)sm->values[inst[3 + i]] : 0;
+    }
+
+    if (sm->workgroup_fixed || fixed)
+    {
+      return put_local_size(inst, sm->workgroup_fixed ? sm->workgroup : size, copy, count);
+    }
+  }
+
+  if (opcode >= SPIRV_OP_SPEC_CONSTANT_TRUE && opcode <= SPIRV_OP_SPEC_CONSTANT_OP && word_count >= 3 && has_flag(sm, inst[2], SPECIALIZE_BAKED))
+  {
+    if (opcode != SPIRV_OP_SPEC_CONSTANT_COMPOSITE)
+    {
+      return put_constant(sm, inst[1], inst[2], copy, count);
+    }
+
+    SDL_memcpy(&copy[count], inst, word_count * sizeof(Uint32));
+    copy[count] = (word_count << 16) | SPIRV_OP_CONSTANT_COMPOSITE;
+    return count + word_count;
+  }
+
+  SDL_memcpy(&copy[count], inst, word_count * sizeof(Uint32));
+  return count + word_count;
+}
+
+// copies a kept block, folded branches lose their merge and phis lose the edges that are gone
+static size_t copy_block(const struct Specialize_Module *sm, const struct Specialize_Block *block, Uint32 *copy, size_t count)
+{
+  if (block->stub)
+  {
+    copy[count++] = (2u << 16) | SPIRV_OP_LABEL;
+    copy[count++] = block->label;
+
+    if (block->stub_branch != 0)
+    {
+      copy[count++] = (2u << 16) | SPIRV_OP_BRANCH;
+      copy[count++] = block->stub_branch;
+    }
+    else
+    {
+      copy[count++] = (1u << 16) | SPIRV_OP_UNREACHABLE;
+    }
+    return count;
+  }
+
+  Uint32 word_count;
+  for (size_t pos = block->start; pos < block->end; pos += word_count)
+  {
+    const Uint32 *inst = &sm->module.words[pos];
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (block->taken != 0 && pos == block->merge)
+    {
+      continue;
+    }
+
+    if (block->taken != 0 && pos == block->terminator)
+    {
+      copy[count++] = (2u << 16) | SPIRV_OP_BRANCH;
+      copy[count++] = block->taken;
+      continue;
+    }
+
+    if (SPIRV_OPCODE(inst[0]) != SPIRV_OP_PHI)
+    {
+      SDL_memcpy(&copy[count], inst, word_count * sizeof(Uint32));
+      count += word_count;
+      continue;
+    }
+
+    size_t start = count;
+    copy[count++] = inst[0];
+    copy[count++] = inst[1];
+    copy[count++] = inst[2];
+
+    for (Uint32 i = 3; i + 1 < word_count; i += 2)
+    {
+      const struct Specialize_Block *parent = find_block(sm, inst[i + 1]);
+      if (parent == NULL || (parent->reachable && branches_to(sm, parent, block->label)))
+      {
+        copy[count++] = inst[i];
+        copy[count++] = inst[i + 1];
+      }
+    }
+
+    copy[start] = ((Uint32)(count - start) << 16) | SPIRV_OP_PHI;
+  }
+
+  return count;
+}
+
+// copies the module with the constants baked and the dead code left out, free with SDL_free
+static Uint32 *specialize_copy(struct Specialize_Module *sm, size_t *size)
+{
+  const Uint32 *words = sm->module.words;
+
+  // stubs can be a word longer than the block they replace
+  Uint32 *copy = SDL_malloc((sm->module.word_count + sm->num_blocks) * sizeof(Uint32));
+  if (copy == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_memcpy(copy, words, SPIRV_HEADER_WORDS * sizeof(Uint32));
+  size_t count = SPIRV_HEADER_WORDS;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < sm->functions; pos += word_count)
+  {
+    word_count = SPIRV_WORD_COUNT(words[pos]);
+    count = copy_global(sm, &words[pos], copy, count);
+  }
+
+  for (Uint32 f = 0; f < sm->num_funcs; f++)
+  {
+    const struct Specialize_Function *function = &sm->funcs[f];
+    if (function->removed)
+    {
+      continue;
+    }
+
+    // the declaration and parameters, then the blocks, then OpFunctionEnd
+    size_t body = function->num_blocks > 0 ? sm->blocks[function->first_block].start : function->end;
+    size_t tail = function->num_blocks > 0 ? sm->blocks[function->first_block + function->num_blocks - 1].end : function->end;
+
+    SDL_memcpy(&copy[count], &words[function->start], (body - function->start) * sizeof(Uint32));
+    count += body - function->start;
+
+    for (Uint32 b = function->first_block; b < function->first_block + function->num_blocks; b++)
+    {
+      if (sm->blocks[b].reachable || sm->blocks[b].stub)
+      {
+        count = copy_block(sm, &sm->blocks[b], copy, count);
+      }
+    }
+
+    SDL_memcpy(&copy[count], &words[tail], (function->end - tail) * sizeof(Uint32));
+    count += function->end - tail;
+  }
+
+  *size = count * sizeof(Uint32);
+  return copy;
+}
+
+void *spirv_specialize(const void *code, size_t code_size, struct Vector *constants, size_t *size)
+{
+  struct Specialize_Module sm;
+  Uint32 *stack = NULL;
+  Uint32 *specialized = NULL;
+
+  if (specialize_open(&sm, code, code_size, constants, false) && read_functions(&sm))
+  {
+    fold_branches(&sm);
+
+    stack = SDL_malloc((sm.num_blocks + 1) * sizeof(Uint32));
+    for (Uint32 f = 0; stack != NULL && f < sm.num_funcs; f++)
+    {
+      find_reachable(&sm, &sm.funcs[f], stack);
+    }
+
+    if (stack != NULL && remove_functions(&sm))
+    {
+      // the annotations of everything left out go as well
+      for (Uint32 f = 0; f < sm.num_funcs; f++)
+      {
+        const struct Specialize_Function *function = &sm.funcs[f];
+        if (function->removed)
+        {
+          remove_results(&sm, function->start, function->end);
+          continue;
+        }
+
+        for (Uint32 b = function->first_block; b < function->first_block + function->num_blocks; b++)
+        {
+          const struct Specialize_Block *block = &sm.blocks[b];
+          if (!block->reachable)
+          {
+            remove_results(&sm, block->stub ? block->start + SPIRV_WORD_COUNT(sm.module.words[block->start]) : block->start, block->end);
+          }
+        }
+      }
+
+      specialized = specialize_copy(&sm, size);
+    }
+  }
+
+  SDL_free(stack);
+  specialize_close(&sm);
+  return specialized;
+}
+
+bool spirv_workgroup_size(const void *code, size_t code_size, Uint32 size[3])
+{
+  struct Specialize_Module sm;
+  bool found = false;
+
+  if (specialize_open(&sm, code, code_size, NULL, true))
+  {
+    bool fixed;
+    found = find_workgroup(&sm, size, &fixed);
+  }
+
+  specialize_close(&sm);
+  return found;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "vector.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+/*
+  bakes specialization constants into a SPIR-V module, so every back-end gets the code a
+  driver would produce after specializing it:
+
+    - constants given as "ID=VALUE" or "NAME=VALUE" become plain constants, the last value
+      of a constant wins and those the module doesn't have are ignored. booleans take
+      true/false, numbers are read like C literals
+    - spec constant operations and composites that end up depending on plain constants only
+      are folded, integer and logical operations are evaluated
+    - selections and switches on a constant branch straight to the taken block, blocks that
+      can't be reached anymore and functions nobody calls are removed
+    - LocalSize follows a workgroup size made of baked constants
+
+  returns the new module, free it with SDL_free, or NULL when a value doesn't fit its constant.
+*/
+void *spirv_specialize(const void *code, size_t code_size, struct Vector *constants, size_t *size);
+
+// the workgroup size of a compute module with spec constants at their defaults, which is what runs
+// since SDL_gpu never specializes. false when the module sets none.
+bool spirv_workgroup_size(const void *code, size_t code_size, Uint32 size[3]);
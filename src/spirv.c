@@ -0,0 +1,532 @@
+#include "spirv.h"
+#include "reflection.h"
+
+#include <SDL3/SDL_error.h>
+
+// the result id of the instructions the reflection cares about, 0 for everything else
+static Uint32 result_id(const Uint32 *inst, Uint32 word_count)
+{
+  Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+  // OpTypeVoid .. OpTypePipeStorage, except OpTypeForwardPointer
+  if (opcode >= SPIRV_OP_TYPE_VOID && opcode <= 38 && word_count >= 2)
+  {
+    return inst[1];
+  }
+
+  // OpConstantTrue .. OpSpecConstantOp, OpFunction and OpVariable
+  if (((opcode >= 41 && opcode <= 52) || opcode == SPIRV_OP_FUNCTION || opcode == SPIRV_OP_VARIABLE) && word_count >= 3)
+  {
+    return inst[2];
+  }
+
+  return 0;
+}
+
+static void decorate(Uint32 *flags, Uint32 decoration, const Uint32 *literal, bool has_literal, struct SPIRV_Id *id, struct SPIRV_Member *member)
+{
+  Uint32 value = has_literal ? *literal : 0;
+
+  switch (decoration)
+  {
+    case SPIRV_DECORATION_BLOCK: *flags |= SPIRV_FLAG_BLOCK; break;
+    case SPIRV_DECORATION_BUFFER_BLOCK: *flags |= SPIRV_FLAG_BUFFER_BLOCK; break;
+    case SPIRV_DECORATION_ROW_MAJOR: *flags |= SPIRV_FLAG_ROW_MAJOR; break;
+    case SPIRV_DECORATION_NON_WRITABLE: *flags |= SPIRV_FLAG_NON_WRITABLE; break;
+    default: break;
+  }
+
+  if (!has_literal)
+  {
+    return;
+  }
+
+  if (member != NULL)
+  {
+    if (decoration == SPIRV_DECORATION_OFFSET)
+    {
+      member->offset = value;
+    }
+    else if (decoration == SPIRV_DECORATION_MATRIX_STRIDE)
+    {
+      member->matrix_stride = value;
+    }
+    return;
+  }
+
+  switch (decoration)
+  {
+    case SPIRV_DECORATION_DESCRIPTOR_SET: *flags |= SPIRV_FLAG_SET; id->set = value; break;
+    case SPIRV_DECORATION_BINDING: *flags |= SPIRV_FLAG_BINDING; id->binding = value; break;
+    case SPIRV_DECORATION_LOCATION: *flags |= SPIRV_FLAG_LOCATION; id->location = value; break;
+    case SPIRV_DECORATION_BUILTIN: *flags |= SPIRV_FLAG_BUILTIN; id->builtin = value; break;
+    case SPIRV_DECORATION_SPEC_ID: *flags |= SPIRV_FLAG_SPEC_ID; id->spec_id = value; break;
+    case SPIRV_DECORATION_ARRAY_STRIDE: id->array_stride = value; break;
+    default: break;
+  }
+}
+
+bool spirv_parse(struct SPIRV_Module *module, const void *code, size_t code_size)
+{
+  SDL_zerop(module);
+
+  if (code_size % sizeof(Uint32) != 0 || code_size < SPIRV_HEADER_WORDS * sizeof(Uint32))
+  {
+    return SDL_SetError("SPIR-V module has an invalid size");
+  }
+
+  const Uint32 *words = code;
+  if (words[0] != SPIRV_MAGIC)
+  {
+    return SDL_SetError("SPIR-V module has an invalid magic number");
+  }
+
+  module->words = words;
+  module->word_count = code_size / sizeof(Uint32);
+  module->bound = words[3];
+  module->ids = SDL_calloc(module->bound, sizeof(struct SPIRV_Id));
+
+  if (module->ids == NULL)
+  {
+    return false;
+  }
+
+  // find the definitions first, decorations come before the types they decorate
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < module->word_count;)
+  {
+    const Uint32 *inst = &words[pos];
+    Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (word_count == 0 || word_count > module->word_count - pos)
+    {
+      spirv_free(module);
+      return SDL_SetError("SPIR-V module is truncated");
+    }
+
+    Uint32 id = result_id(inst, word_count);
+    if (id != 0 && id < module->bound)
+    {
+      module->ids[id].inst = inst;
+
+      if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_STRUCT && word_count > 2)
+      {
+        module->ids[id].num_members = word_count - 2;
+        module->ids[id].members = SDL_calloc(word_count - 2, sizeof(struct SPIRV_Member));
+      }
+    }
+
+    pos += word_count;
+  }
+
+  // names and decorations
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < module->word_count;)
+  {
+    const Uint32 *inst = &words[pos];
+    Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+    pos += word_count;
+
+    if (word_count < 3 || inst[1] >= module->bound)
+    {
+      continue;
+    }
+
+    struct SPIRV_Id *id = &module->ids[inst[1]];
+
+    if (opcode == SPIRV_OP_NAME)
+    {
+      id->name = (const char*)&inst[2];
+    }
+    else if (opcode == SPIRV_OP_MEMBER_NAME && word_count >= 4 && inst[2] < id->num_members)
+    {
+      id->members[inst[2]].name = (const char*)&inst[3];
+    }
+    else if (opcode == SPIRV_OP_DECORATE)
+    {
+      decorate(&id->flags, inst[2], &inst[3], word_count >= 4, id, NULL);
+    }
+    else if (opcode == SPIRV_OP_MEMBER_DECORATE && word_count >= 4 && inst[2] < id->num_members)
+    {
+      struct SPIRV_Member *member = &id->members[inst[2]];
+      decorate(&member->flags, inst[3], &inst[4], word_count >= 5, id, member);
+    }
+  }
+
+  return true;
+}
+
+void spirv_free(struct SPIRV_Module *module)
+{
+  if (module->ids != NULL)
+  {
+    for (Uint32 i = 0; i < module->bound; i++)
+    {
+      SDL_free(module->ids[i].members);
+    }
+  }
+
+  SDL_free(module->ids);
+  SDL_zerop(module);
+}
+
+bool spirv_constant(const struct SPIRV_Module *module, Uint32 id, Uint32 *value)
+{
+  if (id >= module->bound || module->ids[id].inst == NULL)
+  {
+    return false;
+  }
+
+  const Uint32 *inst = module->ids[id].inst;
+  Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+  if ((opcode == SPIRV_OP_CONSTANT || opcode == SPIRV_OP_SPEC_CONSTANT) && SPIRV_WORD_COUNT(inst[0]) >= 4)
+  {
+    *value = inst[3];
+    return true;
+  }
+
+  return false;
+}
+
+Uint32 spirv_variable_type(const struct SPIRV_Module *module, Uint32 variable, Uint32 *storage_class)
+{
+  if (variable >= module->bound || module->ids[variable].inst == NULL)
+  {
+    return 0;
+  }
+
+  const Uint32 *inst = module->ids[variable].inst;
+  if (SPIRV_OPCODE(inst[0]) != SPIRV_OP_VARIABLE || inst[1] >= module->bound)
+  {
+    return 0;
+  }
+
+  const Uint32 *pointer = module->ids[inst[1]].inst;
+  if (pointer == NULL || SPIRV_OPCODE(pointer[0]) != SPIRV_OP_TYPE_POINTER)
+  {
+    return 0;
+  }
+
+  if (storage_class != NULL)
+  {
+    *storage_class = inst[3];
+  }
+
+  return pointer[3] < module->bound ? pointer[3] : 0;
+}
+
+struct Builder
+{
+  const struct SPIRV_Module *module;
+
+  SDL_SHADER_Resource *resources;
+  Uint32 num_resources;
+
+  SDL_SHADER_Block *blocks;
+  Uint32 num_blocks;
+
+  Sint32 *type_blocks;
+};
+
+static const Uint32 *type_inst(const struct SPIRV_Module *module, Uint32 type)
+{
+  return type < module->bound ? module->ids[type].inst : NULL;
+}
+
+// strips array types and returns the element type.
+// count is the number of flattened elements, 0 for runtime arrays.
+static Uint32 peel_arrays(const struct SPIRV_Module *module, Uint32 type, bool *is_array, Uint32 *count, Uint32 *stride)
+{
+  const Uint32 *inst = type_inst(module, type);
+  *is_array = false;
+  *count = 1;
+
+  while (inst != NULL && (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_ARRAY || SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_RUNTIME_ARRAY))
+  {
+    *is_array = true;
+    *stride = module->ids[type].array_stride;
+
+    Uint32 length = 0;
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_RUNTIME_ARRAY || !spirv_constant(module, inst[3], &length))
+    {
+      *count = 0;
+    }
+    else
+    {
+      *count *= length;
+    }
+
+    type = inst[2];
+    inst = type_inst(module, type);
+  }
+
+  return type;
+}
+
+static SDL_SHADER_BaseType scalar_type(const Uint32 *inst, Uint32 *size)
+{
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_TYPE_BOOL:
+      *size = 4;
+      return SDL_SHADER_BASETYPE_BOOL;
+
+    case SPIRV_OP_TYPE_INT:
+      *size = inst[2] / 8;
+      if (inst[2] == 64)
+      {
+        return inst[3] ? SDL_SHADER_BASETYPE_INT64 : SDL_SHADER_BASETYPE_UINT64;
+      }
+      return inst[3] ? SDL_SHADER_BASETYPE_INT : SDL_SHADER_BASETYPE_UINT;
+
+    case SPIRV_OP_TYPE_FLOAT:
+      *size = inst[2] / 8;
+      if (inst[2] == 16)
+      {
+        return SDL_SHADER_BASETYPE_HALF;
+      }
+      return inst[2] == 64 ? SDL_SHADER_BASETYPE_DOUBLE : SDL_SHADER_BASETYPE_FLOAT;
+
+    default:
+      *size = 0;
+      return SDL_SHADER_BASETYPE_UNKNOWN;
+  }
+}
+
+static Sint32 add_block(struct Builder *builder, Uint32 type);
+
+static void fill_member(struct Builder *builder, Uint32 type, const struct SPIRV_Member *decoration, SDL_SHADER_Member *member)
+{
+  const struct SPIRV_Module *module = builder->module;
+  bool is_array;
+  Uint32 count;
+  Uint32 stride = 0;
+
+  member->name = decoration->name;
+  member->offset = decoration->offset;
+  member->matrix_stride = decoration->matrix_stride;
+  member->row_major = (decoration->flags & SPIRV_FLAG_ROW_MAJOR) != 0;
+  member->vecsize = 1;
+  member->columns = 1;
+  member->block = -1;
+
+  type = peel_arrays(module, type, &is_array, &count, &stride);
+  member->array_size = is_array ? count : 0;
+  member->array_stride = is_array ? stride : 0;
+  member->runtime_array = is_array && count == 0;
+
+  const Uint32 *inst = type_inst(module, type);
+  Uint32 scalar_size = 0;
+  Uint32 element_size = 0;
+
+  if (inst == NULL)
+  {
+    member->base_type = SDL_SHADER_BASETYPE_UNKNOWN;
+  }
+  else if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_STRUCT)
+  {
+    member->base_type = SDL_SHADER_BASETYPE_STRUCT;
+    member->block = add_block(builder, type);
+    element_size = member->block >= 0 ? builder->blocks[member->block].size : 0;
+  }
+  else
+  {
+    if (SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_MATRIX)
+    {
+      member->columns = inst[3];
+      inst = type_inst(module, inst[2]);
+    }
+
+    if (inst != NULL && SPIRV_OPCODE(inst[0]) == SPIRV_OP_TYPE_VECTOR)
+    {
+      member->vecsize = inst[3];
+      inst = type_inst(module, inst[2]);
+    }
+
+    member->base_type = inst != NULL ? scalar_type(inst, &scalar_size) : SDL_SHADER_BASETYPE_UNKNOWN;
+
+    if (member->columns > 1)
+    {
+      element_size = (member->row_major ? member->vecsize : member->columns) * member->matrix_stride;
+    }
+    else
+    {
+      element_size = member->vecsize * scalar_size;
+    }
+  }
+
+  member->size = is_array ? count * stride : element_size;
+}
+
+static Sint32 add_block(struct Builder *builder, Uint32 type)
+{
+  const struct SPIRV_Module *module = builder->module;
+
+  if (builder->type_blocks[type] >= 0)
+  {
+    return builder->type_blocks[type];
+  }
+
+  // reserve the slot first, nested structs are added while filling members
+  Sint32 index = (Sint32)builder->num_blocks;
+  builder->blocks = SDL_realloc(builder->blocks, (builder->num_blocks + 1) * sizeof(SDL_SHADER_Block));
+  builder->num_blocks += 1;
+  builder->type_blocks[type] = index;
+
+  const struct SPIRV_Id *id = &module->ids[type];
+  SDL_SHADER_Member *members = SDL_calloc(id->num_members ? id->num_members : 1, sizeof(SDL_SHADER_Member));
+  Uint32 size = 0;
+
+  for (Uint32 i = 0; i < id->num_members; i++)
+  {
+    fill_member(builder, id->inst[2 + i], &id->members[i], &members[i]);
+    size = SDL_max(size, members[i].offset + members[i].size);
+  }
+
+  SDL_SHADER_Block *block = &builder->blocks[index];
+  block->name = id->name;
+  block->size = size;
+  block->num_members = id->num_members;
+  block->members = members;
+
+  return index;
+}
+
+static int compare_resources(const void *a, const void *b)
+{
+  const SDL_SHADER_Resource *x = a;
+  const SDL_SHADER_Resource *y = b;
+
+  if (x->type != y->type)
+  {
+    return x->type < y->type ? -1 : 1;
+  }
+  if (x->set != y->set)
+  {
+    return x->set < y->set ? -1 : 1;
+  }
+  if (x->binding != y->binding)
+  {
+    return x->binding < y->binding ? -1 : 1;
+  }
+  return 0;
+}
+
+SDL_SHADER_Reflection *spirv_reflect(const struct SPIRV_Module *module)
+{
+  struct Builder builder = {0};
+  builder.module = module;
+  builder.type_blocks = SDL_malloc(module->bound * sizeof(Sint32));
+
+  for (Uint32 i = 0; i < module->bound; i++)
+  {
+    builder.type_blocks[i] = -1;
+  }
+
+  for (Uint32 variable = 0; variable < module->bound; variable++)
+  {
+    Uint32 storage_class;
+    Uint32 type = spirv_variable_type(module, variable, &storage_class);
+
+    if (type == 0 || (storage_class != SPIRV_STORAGE_UNIFORM_CONSTANT && storage_class != SPIRV_STORAGE_UNIFORM && storage_class != SPIRV_STORAGE_STORAGE_BUFFER))
+    {
+      continue;
+    }
+
+    const struct SPIRV_Id *id = &module->ids[variable];
+    bool is_array;
+    Uint32 count;
+    Uint32 stride = 0;
+
+    type = peel_arrays(module, type, &is_array, &count, &stride);
+    const Uint32 *inst = type_inst(module, type);
+    if (inst == NULL)
+    {
+      continue;
+    }
+
+    SDL_SHADER_Resource resource = {0};
+    resource.name = id->name;
+    resource.set = id->set;
+    resource.binding = id->binding;
+    resource.array_size = count;
+    resource.readonly = (id->flags & SPIRV_FLAG_NON_WRITABLE) != 0;
+    resource.block = -1;
+
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+
+    if (opcode == SPIRV_OP_TYPE_SAMPLED_IMAGE)
+    {
+      resource.type = SDL_SHADER_RESOURCE_SAMPLER;
+      resource.readonly = true;
+    }
+    else if (opcode == SPIRV_OP_TYPE_IMAGE && SPIRV_WORD_COUNT(inst[0]) >= 9)
+    {
+      // sampled is 1 for textures and 2 for storage images
+      resource.type = inst[7] == 2 ? SDL_SHADER_RESOURCE_STORAGE_TEXTURE : SDL_SHADER_RESOURCE_SAMPLER;
+      resource.readonly |= inst[7] != 2;
+    }
+    else if (opcode == SPIRV_OP_TYPE_STRUCT)
+    {
+      const struct SPIRV_Id *block = &module->ids[type];
+
+      if (storage_class == SPIRV_STORAGE_STORAGE_BUFFER || (block->flags & SPIRV_FLAG_BUFFER_BLOCK))
+      {
+        resource.type = SDL_SHADER_RESOURCE_STORAGE_BUFFER;
+
+        // a buffer is read only when every member is
+        bool members_readonly = block->num_members > 0;
+        for (Uint32 i = 0; i < block->num_members; i++)
+        {
+          members_readonly &= (block->members[i].flags & SPIRV_FLAG_NON_WRITABLE) != 0;
+        }
+        resource.readonly |= members_readonly;
+      }
+      else
+      {
+        resource.type = SDL_SHADER_RESOURCE_UNIFORM_BUFFER;
+        resource.readonly = true;
+      }
+
+      if (resource.name == NULL || *resource.name == '\0')
+      {
+        resource.name = block->name;
+      }
+
+      resource.block = add_block(&builder, type);
+    }
+    else
+    {
+      // separate samplers are paired with their texture
+      continue;
+    }
+
+    builder.resources = SDL_realloc(builder.resources, (builder.num_resources + 1) * sizeof(SDL_SHADER_Resource));
+    builder.resources[builder.num_resources] = resource;
+    builder.num_resources += 1;
+  }
+
+  if (builder.num_resources > 1)
+  {
+    SDL_qsort(builder.resources, builder.num_resources, sizeof(SDL_SHADER_Resource), compare_resources);
+  }
+
+  // SDL_gpu counts every type from 0, compute keeps read only and read write storage in separate sets
+  for (Uint32 i = 0; i < builder.num_resources; i++)
+  {
+    SDL_SHADER_Resource *resource = &builder.resources[i];
+    const SDL_SHADER_Resource *previous = i > 0 ? &builder.resources[i - 1] : NULL;
+    bool same = previous != NULL && previous->type == resource->type && previous->set == resource->set;
+    resource->slot = same ? previous->slot + 1 : 0;
+  }
+
+  SDL_free(builder.type_blocks);
+
+  SDL_SHADER_Reflection *reflection = SDL_malloc(sizeof(SDL_SHADER_Reflection));
+  reflection->num_resources = builder.num_resources;
+  reflection->resources = builder.resources;
+  reflection->num_blocks = builder.num_blocks;
+  reflection->blocks = builder.blocks;
+
+  return reflection;
+}
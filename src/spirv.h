@@ -0,0 +1,171 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+
+#define SPIRV_MAGIC 0x07230203
+#define SPIRV_HEADER_WORDS 5
+
+#define SPIRV_OPCODE(word) ((word) & 0xFFFF)
+#define SPIRV_WORD_COUNT(word) ((word) >> 16)
+
+enum
+{
+  SPIRV_OP_NAME = 5,
+  SPIRV_OP_MEMBER_NAME = 6,
+  SPIRV_OP_LINE = 8,
+  SPIRV_OP_EXT_INST_IMPORT = 11,
+  SPIRV_OP_EXT_INST = 12,
+  SPIRV_OP_ENTRY_POINT = 15,
+  SPIRV_OP_EXECUTION_MODE = 16,
+  SPIRV_OP_TYPE_VOID = 19,
+  SPIRV_OP_TYPE_BOOL = 20,
+  SPIRV_OP_TYPE_INT = 21,
+  SPIRV_OP_TYPE_FLOAT = 22,
+  SPIRV_OP_TYPE_VECTOR = 23,
+  SPIRV_OP_TYPE_MATRIX = 24,
+  SPIRV_OP_TYPE_IMAGE = 25,
+  SPIRV_OP_TYPE_SAMPLER = 26,
+  SPIRV_OP_TYPE_SAMPLED_IMAGE = 27,
+  SPIRV_OP_TYPE_ARRAY = 28,
+  SPIRV_OP_TYPE_RUNTIME_ARRAY = 29,
+  SPIRV_OP_TYPE_STRUCT = 30,
+  SPIRV_OP_TYPE_POINTER = 32,
+  SPIRV_OP_CONSTANT_TRUE = 41,
+  SPIRV_OP_CONSTANT_FALSE = 42,
+  SPIRV_OP_CONSTANT = 43,
+  SPIRV_OP_CONSTANT_COMPOSITE = 44,
+  SPIRV_OP_SPEC_CONSTANT_TRUE = 48,
+  SPIRV_OP_SPEC_CONSTANT_FALSE = 49,
+  SPIRV_OP_SPEC_CONSTANT = 50,
+  SPIRV_OP_SPEC_CONSTANT_COMPOSITE = 51,
+  SPIRV_OP_SPEC_CONSTANT_OP = 52,
+  SPIRV_OP_FUNCTION = 54,
+  SPIRV_OP_FUNCTION_PARAMETER = 55,
+  SPIRV_OP_FUNCTION_END = 56,
+  SPIRV_OP_FUNCTION_CALL = 57,
+  SPIRV_OP_VARIABLE = 59,
+  SPIRV_OP_LOAD = 61,
+  SPIRV_OP_STORE = 62,
+  SPIRV_OP_ACCESS_CHAIN = 65,
+  SPIRV_OP_IN_BOUNDS_ACCESS_CHAIN = 66,
+  SPIRV_OP_DECORATE = 71,
+  SPIRV_OP_MEMBER_DECORATE = 72,
+  SPIRV_OP_PHI = 245,
+  SPIRV_OP_LOOP_MERGE = 246,
+  SPIRV_OP_SELECTION_MERGE = 247,
+  SPIRV_OP_LABEL = 248,
+  SPIRV_OP_BRANCH = 249,
+  SPIRV_OP_BRANCH_CONDITIONAL = 250,
+  SPIRV_OP_SWITCH = 251,
+  SPIRV_OP_KILL = 252,
+  SPIRV_OP_RETURN = 253,
+  SPIRV_OP_RETURN_VALUE = 254,
+  SPIRV_OP_UNREACHABLE = 255,
+  SPIRV_OP_NO_LINE = 317,
+  SPIRV_OP_EXECUTION_MODE_ID = 331,
+  SPIRV_OP_DECORATE_ID = 332,
+  SPIRV_OP_DECORATE_STRING = 5632,
+  SPIRV_OP_MEMBER_DECORATE_STRING = 5633
+};
+
+enum
+{
+  SPIRV_DECORATION_SPEC_ID = 1,
+  SPIRV_DECORATION_BLOCK = 2,
+  SPIRV_DECORATION_BUFFER_BLOCK = 3,
+  SPIRV_DECORATION_ROW_MAJOR = 4,
+  SPIRV_DECORATION_ARRAY_STRIDE = 6,
+  SPIRV_DECORATION_MATRIX_STRIDE = 7,
+  SPIRV_DECORATION_BUILTIN = 11,
+  SPIRV_DECORATION_NON_WRITABLE = 24,
+  SPIRV_DECORATION_LOCATION = 30,
+  SPIRV_DECORATION_COMPONENT = 31,
+  SPIRV_DECORATION_BINDING = 33,
+  SPIRV_DECORATION_DESCRIPTOR_SET = 34,
+  SPIRV_DECORATION_OFFSET = 35
+};
+
+enum
+{
+  SPIRV_EXECUTION_MODEL_VERTEX = 0,
+  SPIRV_EXECUTION_MODEL_FRAGMENT = 4
+};
+
+enum
+{
+  SPIRV_EXECUTION_MODE_LOCAL_SIZE = 17,
+  SPIRV_EXECUTION_MODE_LOCAL_SIZE_ID = 38
+};
+
+enum
+{
+  SPIRV_BUILTIN_WORKGROUP_SIZE = 25
+};
+
+enum
+{
+  SPIRV_STORAGE_UNIFORM_CONSTANT = 0,
+  SPIRV_STORAGE_INPUT = 1,
+  SPIRV_STORAGE_UNIFORM = 2,
+  SPIRV_STORAGE_OUTPUT = 3,
+  SPIRV_STORAGE_PUSH_CONSTANT = 9,
+  SPIRV_STORAGE_STORAGE_BUFFER = 12
+};
+
+// flags for decorations that were present on an id or member
+enum
+{
+  SPIRV_FLAG_SET = 1 << 0,
+  SPIRV_FLAG_BINDING = 1 << 1,
+  SPIRV_FLAG_LOCATION = 1 << 2,
+  SPIRV_FLAG_BLOCK = 1 << 3,
+  SPIRV_FLAG_BUFFER_BLOCK = 1 << 4,
+  SPIRV_FLAG_NON_WRITABLE = 1 << 5,
+  SPIRV_FLAG_ROW_MAJOR = 1 << 6,
+  SPIRV_FLAG_BUILTIN = 1 << 7,
+  SPIRV_FLAG_SPEC_ID = 1 << 8
+};
+
+struct SPIRV_Member
+{
+  const char *name;
+  Uint32 flags;
+  Uint32 offset;
+  Uint32 matrix_stride;
+};
+
+struct SPIRV_Id
+{
+  const Uint32 *inst;   // the instruction defining this id, NULL if none
+  const char *name;     // points into the module, NULL if unnamed
+  Uint32 flags;
+  Uint32 set;
+  Uint32 binding;
+  Uint32 location;
+  Uint32 array_stride;
+  Uint32 builtin;
+  Uint32 spec_id;
+
+  Uint32 num_members;
+  struct SPIRV_Member *members;
+};
+
+// an indexed view of a SPIR-V module, the code must outlive it
+struct SPIRV_Module
+{
+  const Uint32 *words;
+  size_t word_count;
+  Uint32 bound;
+  struct SPIRV_Id *ids;
+};
+
+bool spirv_parse(struct SPIRV_Module *module, const void *code, size_t code_size);
+void spirv_free(struct SPIRV_Module *module);
+
+// the value of an integer OpConstant or the default of an OpSpecConstant
+bool spirv_constant(const struct SPIRV_Module *module, Uint32 id, Uint32 *value);
+
+// returns the type id of a variable's pointee, or 0
+Uint32 spirv_variable_type(const struct SPIRV_Module *module, Uint32 variable, Uint32 *storage_class);
+
+// builds the reflection of every resource in the module, free it with reflection_free()
+struct SDL_SHADER_Reflection *spirv_reflect(const struct SPIRV_Module *module);
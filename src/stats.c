@@ -0,0 +1,414 @@
+#include "stats.h"
+#include "compile.h"
+#include "spirv.h"
+
+#include <SDL3/SDL_iostream.h>
+
+#define STATS_NONE 0xFFFFFFFFu
+
+static const SDL_GPUShaderFormat formats[STATS_FORMATS] = {
+  SDL_GPU_SHADERFORMAT_SPIRV,
+  SDL_GPU_SHADERFORMAT_DXBC,
+  SDL_GPU_SHADERFORMAT_DXIL,
+  SDL_GPU_SHADERFORMAT_MSL
+};
+
+static const char *format_names[STATS_FORMATS] = { "spv", "dxbc", "dxil", "msl" };
+
+static const char *type_names[] = { "vertex", "fragment", "compute" };
+
+static bool is_type(const struct SPIRV_Module *module, Uint32 id)
+{
+  const Uint32 *inst = id < module->bound ? module->ids[id].inst : NULL;
+  return inst != NULL && SPIRV_OPCODE(inst[0]) >= SPIRV_OP_TYPE_VOID && SPIRV_OPCODE(inst[0]) <= 39;
+}
+
+// how many scalars a value of the type holds, opaque types count as one
+static Uint32 components(const struct SPIRV_Module *module, Uint32 type, int depth)
+{
+  const Uint32 *inst = type < module->bound ? module->ids[type].inst : NULL;
+  if (inst == NULL || depth > 8)
+  {
+    return 1;
+  }
+
+  Uint32 word_count = SPIRV_WORD_COUNT(inst[0]);
+  switch (SPIRV_OPCODE(inst[0]))
+  {
+    case SPIRV_OP_TYPE_VOID:
+      return 0;
+
+    case SPIRV_OP_TYPE_VECTOR:
+      return word_count >= 4 ? inst[3] : 1;
+
+    case SPIRV_OP_TYPE_MATRIX:
+      return word_count >= 4 ? inst[3] * components(module, inst[2], depth + 1) : 1;
+
+    case SPIRV_OP_TYPE_ARRAY:
+    {
+      Uint32 length;
+      return word_count >= 4 && spirv_constant(module, inst[3], &length) ? length * components(module, inst[2], depth + 1) : 1;
+    }
+
+    case SPIRV_OP_TYPE_STRUCT:
+    {
+      Uint32 sum = 0;
+      for (Uint32 i = 2; i < word_count; i++)
+      {
+        sum += components(module, inst[i], depth + 1);
+      }
+      return sum;
+    }
+
+    default:
+      return 1;
+  }
+}
+
+// the registers a result takes, function variables hold their whole value while other pointers are just addresses
+static Uint32 result_size(const struct SPIRV_Module *module, const Uint32 *inst)
+{
+  const Uint32 *type = module->ids[inst[1]].inst;
+
+  if (SPIRV_OPCODE(type[0]) == SPIRV_OP_TYPE_POINTER)
+  {
+    return SPIRV_OPCODE(inst[0]) == SPIRV_OP_VARIABLE && SPIRV_WORD_COUNT(type[0]) >= 4 ? components(module, type[3], 0) : 0;
+  }
+
+  return components(module, inst[1], 0);
+}
+
+bool stats_spirv(const void *code, size_t size, struct Stats *stats)
+{
+  struct SPIRV_Module module;
+  if (!spirv_parse(&module, code, size))
+  {
+    return false;
+  }
+
+  Uint32 bound = module.bound;
+  Uint32 *defs = SDL_malloc(bound * sizeof(Uint32));   // instruction index of the definition
+  Uint32 *ends = SDL_malloc(bound * sizeof(Uint32));   // instruction index of the last use
+  Uint32 *weights = SDL_calloc(bound, sizeof(Uint32));
+  Uint32 *values = SDL_malloc(bound * sizeof(Uint32)); // ids defined in the current function
+  Uint32 *loop_headers = SDL_malloc(bound * sizeof(Uint32));
+  Uint32 *loop_merges = SDL_malloc(bound * sizeof(Uint32));
+  SDL_memset(defs, 0xFF, bound * sizeof(Uint32));
+
+  stats->instructions = 0;
+  stats->registers = 0;
+  stats->loops = 0;
+  stats->branches = 0;
+
+  bool in_function = false;
+  Uint32 first = 0;
+  Uint32 header = 0;
+  Uint32 num_values = 0;
+  Uint32 num_loops = 0;
+  Uint32 index = 0;
+  Uint32 word_count;
+
+  for (size_t pos = SPIRV_HEADER_WORDS; pos < module.word_count; pos += word_count, index++)
+  {
+    const Uint32 *inst = &module.words[pos];
+    Uint32 opcode = SPIRV_OPCODE(inst[0]);
+    word_count = SPIRV_WORD_COUNT(inst[0]);
+
+    if (opcode == SPIRV_OP_FUNCTION)
+    {
+      in_function = true;
+      first = header = index;
+      num_values = num_loops = 0;
+      continue;
+    }
+
+    if (!in_function || opcode == SPIRV_OP_LINE || opcode == SPIRV_OP_NO_LINE)
+    {
+      continue;
+    }
+
+    if (opcode == SPIRV_OP_FUNCTION_END)
+    {
+      in_function = false;
+
+      // values from before a loop that are used inside it stay alive for every iteration, inner loops first
+      for (Uint32 l = num_loops; l-- > 0;)
+      {
+        Uint32 merge = loop_merges[l] < bound ? defs[loop_merges[l]] : STATS_NONE;
+        for (Uint32 v = 0; merge != STATS_NONE && v < num_values; v++)
+        {
+          Uint32 id = values[v];
+          if (defs[id] < loop_headers[l] && ends[id] >= loop_headers[l] && ends[id] < merge)
+          {
+            ends[id] = merge;
+          }
+        }
+      }
+
+      // the peak of the live ranges
+      Uint32 length = index - first + 2;
+      Sint64 *deltas = SDL_calloc(length, sizeof(Sint64));
+      for (Uint32 v = 0; v < num_values; v++)
+      {
+        Uint32 id = values[v];
+        deltas[defs[id] - first] += weights[id];
+        deltas[ends[id] - first + 1] -= weights[id];
+      }
+
+      Sint64 live = 0;
+      for (Uint32 i = 0; i < length; i++)
+      {
+        live += deltas[i];
+        if (live > (Sint64)stats->registers)
+        {
+          stats->registers = (Uint32)live;
+        }
+      }
+
+      SDL_free(deltas);
+      continue;
+    }
+
+    // operands that are values of this function extend their range
+    bool has_result = word_count >= 3 && is_type(&module, inst[1]) && inst[2] < bound;
+    for (Uint32 i = has_result ? 3 : 1; i < word_count; i++)
+    {
+      if (inst[i] < bound && defs[inst[i]] != STATS_NONE && defs[inst[i]] >= first)
+      {
+        ends[inst[i]] = index;
+      }
+    }
+
+    if (opcode == SPIRV_OP_LABEL && word_count >= 2 && inst[1] < bound)
+    {
+      defs[inst[1]] = ends[inst[1]] = header = index;
+      continue;
+    }
+
+    if (opcode == SPIRV_OP_LOOP_MERGE && word_count >= 2)
+    {
+      loop_headers[num_loops] = header;
+      loop_merges[num_loops] = inst[1];
+      num_loops++;
+      stats->loops++;
+      continue;
+    }
+
+    // only annotates the branch after it
+    if (opcode == SPIRV_OP_SELECTION_MERGE)
+    {
+      continue;
+    }
+
+    if (opcode == SPIRV_OP_BRANCH_CONDITIONAL || opcode == SPIRV_OP_SWITCH)
+    {
+      stats->branches++;
+    }
+
+    if (has_result && defs[inst[2]] == STATS_NONE && num_values < bound)
+    {
+      defs[inst[2]] = ends[inst[2]] = index;
+      weights[inst[2]] = result_size(&module, inst);
+      values[num_values++] = inst[2];
+    }
+
+    if (opcode != SPIRV_OP_FUNCTION_PARAMETER)
+    {
+      stats->instructions++;
+    }
+  }
+
+  SDL_free(defs);
+  SDL_free(ends);
+  SDL_free(weights);
+  SDL_free(values);
+  SDL_free(loop_headers);
+  SDL_free(loop_merges);
+  spirv_free(&module);
+  return true;
+}
+
+bool stats_blob(const void *data, size_t size, SDL_GPUShaderFormat kept, struct Stats *stats)
+{
+  struct SDL_SHADER_Blob blob;
+  if (!decode(data, size, &blob))
+  {
+    return SDL_SetError("not a compiled shader");
+  }
+
+  stats->type = blob.type;
+  stats->num_samplers = blob.num_samplers;
+  stats->num_storage_textures = blob.num_storage_textures;
+  stats->num_storage_buffers = blob.num_storage_buffers;
+  stats->num_uniform_buffers = blob.num_uniform_buffers;
+  stats->num_storage_textures_readonly = blob.num_storage_textures_readonly;
+  stats->num_storage_buffers_readonly = blob.num_storage_buffers_readonly;
+  stats->thread_x = blob.thread_x;
+  stats->thread_y = blob.thread_y;
+  stats->thread_z = blob.thread_z;
+
+  bool analyzed = false;
+  for (int f = 0; f < STATS_FORMATS; f++)
+  {
+    stats->sizes[f] = 0;
+
+    for (Uint32 i = 0; i < blob.num_shaders; i++)
+    {
+      struct SDL_SHADER_Code *shader = blob.shaders[i];
+      if (shader->format != formats[f])
+      {
+        continue;
+      }
+
+      if (formats[f] & kept)
+      {
+        stats->sizes[f] = shader->code_size;
+      }
+
+      if (formats[f] == SDL_GPU_SHADERFORMAT_SPIRV)
+      {
+        analyzed = stats_spirv(shader->code, shader->code_size, stats);
+      }
+    }
+  }
+
+  SDL_free(blob.shaders);
+  return analyzed || SDL_SetError("no SPIR-V to analyze");
+}
+
+static int SDLCALL heavier(const void *a, const void *b)
+{
+  const struct Stats *x = *(const struct Stats* const*)a;
+  const struct Stats *y = *(const struct Stats* const*)b;
+
+  if (x->instructions != y->instructions)
+  {
+    return x->instructions > y->instructions ? -1 : 1;
+  }
+
+  return SDL_strcmp(x->name, y->name);
+}
+
+static int SDLCALL by_name(const void *a, const void *b)
+{
+  return SDL_strcmp((*(const struct Stats* const*)a)->name, (*(const struct Stats* const*)b)->name);
+}
+
+char *stats_text(struct Stats **stats, int count)
+{
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  if (io == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_qsort(stats, count, sizeof(struct Stats*), heavier);
+
+  SDL_IOprintf(io, "%8s %6s %6s %9s %5s %5s %5s %5s %-11s", "instrs", "regs", "loops", "branches", "smp", "tex", "buf", "ubo", "threads");
+  for (int f = 0; f < STATS_FORMATS; f++)
+  {
+    SDL_IOprintf(io, " %8s", format_names[f]);
+  }
+  SDL_IOprintf(io, "  %s\n", "name");
+
+  for (int i = 0; i < count; i++)
+  {
+    const struct Stats *s = stats[i];
+    char threads[48] = "-";
+
+    if (s->type == SDL_SHADER_TYPE_COMPUTE)
+    {
+      SDL_snprintf(threads, sizeof(threads), "%ux%ux%u", s->thread_x, s->thread_y, s->thread_z);
+    }
+
+    SDL_IOprintf(io, "%8u %6u %6u %9u %5u %5u %5u %5u %-11s", s->instructions, s->registers, s->loops, s->branches, s->num_samplers,
+      s->num_storage_textures + s->num_storage_textures_readonly, s->num_storage_buffers + s->num_storage_buffers_readonly, s->num_uniform_buffers, threads);
+
+    for (int f = 0; f < STATS_FORMATS; f++)
+    {
+      if (s->sizes[f] == 0)
+      {
+        SDL_IOprintf(io, " %8s", "-");
+      }
+      else
+      {
+        SDL_IOprintf(io, " %8" SDL_PRIu64, s->sizes[f]);
+      }
+    }
+
+    SDL_IOprintf(io, "  %s\n", s->name);
+  }
+
+  return take_text(io, NULL);
+}
+
+// writes a JSON string, escaping what paths can contain
+static void json_string(SDL_IOStream *io, const char *text)
+{
+  SDL_IOprintf(io, "\"");
+
+  for (const char *c = text; *c != '\0'; c++)
+  {
+    if (*c == '"' || *c == '\\')
+    {
+      SDL_IOprintf(io, "\\%c", *c);
+    }
+    else if ((unsigned char)*c < 0x20)
+    {
+      SDL_IOprintf(io, "\\u%04x", (unsigned char)*c);
+    }
+    else
+    {
+      SDL_IOprintf(io, "%c", *c);
+    }
+  }
+
+  SDL_IOprintf(io, "\"");
+}
+
+char *stats_json(struct Stats **stats, int count)
+{
+  SDL_IOStream *io = SDL_IOFromDynamicMem();
+  if (io == NULL)
+  {
+    return NULL;
+  }
+
+  SDL_qsort(stats, count, sizeof(struct Stats*), by_name);
+
+  SDL_IOprintf(io, "{\n  \"shaders\": [\n");
+
+  for (int i = 0; i < count; i++)
+  {
+    const struct Stats *s = stats[i];
+
+    SDL_IOprintf(io, "    {\"name\": ");
+    json_string(io, s->name);
+    SDL_IOprintf(io, ", \"stage\": \"%s\"", type_names[s->type]);
+    SDL_IOprintf(io, ", \"instructions\": %u, \"registers\": %u, \"loops\": %u, \"branches\": %u", s->instructions, s->registers, s->loops, s->branches);
+    SDL_IOprintf(io, ", \"samplers\": %u, \"storage_textures\": %u, \"storage_buffers\": %u, \"uniform_buffers\": %u",
+      s->num_samplers, s->num_storage_textures, s->num_storage_buffers, s->num_uniform_buffers);
+
+    if (s->type == SDL_SHADER_TYPE_COMPUTE)
+    {
+      SDL_IOprintf(io, ", \"readonly_storage_textures\": %u, \"readonly_storage_buffers\": %u, \"threads\": [%u, %u, %u]",
+        s->num_storage_textures_readonly, s->num_storage_buffers_readonly, s->thread_x, s->thread_y, s->thread_z);
+    }
+
+    SDL_IOprintf(io, ", \"sizes\": {");
+    bool first = true;
+    for (int f = 0; f < STATS_FORMATS; f++)
+    {
+      if (s->sizes[f] != 0)
+      {
+        SDL_IOprintf(io, "%s\"%s\": %" SDL_PRIu64, first ? "" : ", ", format_names[f], s->sizes[f]);
+        first = false;
+      }
+    }
+
+    SDL_IOprintf(io, "}}%s\n", i + 1 < count ? "," : "");
+  }
+
+  SDL_IOprintf(io, "  ]\n}\n");
+  return take_text(io, NULL);
+}
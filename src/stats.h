@@ -0,0 +1,45 @@
+#pragma once
+#include "common.h"
+
+/*
+  rough figures of compiled shaders for finding the heavy ones and catching
+  regressions between builds. the complexity comes from the SPIR-V in the
+  blob, the resources and sizes from its header.
+*/
+
+#define STATS_FORMATS 4
+
+struct Stats
+{
+  char *name;
+  SDL_SHADER_Type type;
+
+  Uint32 instructions;  // in function bodies, without labels, merges and debug lines
+  Uint32 registers;     // most scalar values alive at once, an estimate of register pressure
+  Uint32 loops;
+  Uint32 branches;      // conditional branches and switches
+
+  Uint32 num_samplers;
+  Uint32 num_storage_textures;
+  Uint32 num_storage_buffers;
+  Uint32 num_uniform_buffers;
+  Uint32 num_storage_textures_readonly;
+  Uint32 num_storage_buffers_readonly;
+  Uint32 thread_x;
+  Uint32 thread_y;
+  Uint32 thread_z;
+
+  Uint64 sizes[STATS_FORMATS]; // spv, dxbc, dxil and msl, 0 when not compiled
+};
+
+// fills the complexity figures from a SPIR-V module
+bool stats_spirv(const void *code, size_t size, struct Stats *stats);
+
+// fills everything but the name from a blob that holds SPIR-V, only the sizes of the given formats are kept
+bool stats_blob(const void *data, size_t size, SDL_GPUShaderFormat formats, struct Stats *stats);
+
+// a table with the heaviest shaders first, free with SDL_free
+char *stats_text(struct Stats **stats, int count);
+
+// one JSON object per shader sorted by name so reports diff well, free with SDL_free
+char *stats_json(struct Stats **stats, int count);
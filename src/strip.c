@@ -0,0 +1,133 @@
+#include "strip.h"
+#include "common.h"
+#include "compile.h"
+#include "pack.h"
+
+#include <SDL3/SDL_filesystem.h>
+
+void *strip_blob(const void *data, size_t size, SDL_GPUShaderFormat formats, size_t *stripped_size)
+{
+  struct SDL_SHADER_Blob blob;
+
+  if (!decode(data, size, &blob))
+  {
+    SDL_SetError("not a compiled shader");
+    return NULL;
+  }
+
+  // a blob without code would only fail once it is loaded
+  if (!(blob.formats & formats))
+  {
+    SDL_SetError("none of the formats to keep were compiled");
+    SDL_free(blob.shaders);
+    return NULL;
+  }
+
+  // sections are no shader format, they stay
+  Uint32 kept = 0;
+  for (Uint32 i = 0; i < blob.num_shaders; i++)
+  {
+    if ((blob.shaders[i]->format & formats) || (blob.shaders[i]->format & SDL_SHADER_SECTION_REFLECTION))
+    {
+      blob.shaders[kept++] = blob.shaders[i];
+    }
+  }
+
+  blob.num_shaders = kept;
+  blob.formats &= formats;
+  void *stripped = encode(&blob, stripped_size);
+
+  SDL_free(blob.shaders);
+  return stripped;
+}
+
+bool strip_pack(const char *path, const char *target, SDL_GPUShaderFormat formats)
+{
+  SDL_IOStream *io = SDL_IOFromFile(path, "rb");
+  if (io == NULL)
+  {
+    return false;
+  }
+
+  struct Pack pack;
+  if (!pack_read(io, &pack))
+  {
+    SDL_CloseIO(io);
+    return false;
+  }
+
+  // a fresh pack, entries of an older copy must not survive
+  char *tmp;
+  SDL_asprintf(&tmp, "%s.tmp", target);
+  SDL_RemovePath(tmp);
+
+  // create the folder of the target and try again
+  struct Pack_Writer writer;
+  bool opened = pack_open_writer(&writer, tmp);
+  if (!opened)
+  {
+    const char *slash = SDL_strrchr(target, '/');
+    const char *backslash = SDL_strrchr(target, '\\');
+    const char *separator = backslash > slash ? backslash : slash;
+
+    if (separator != NULL)
+    {
+      char *folder = SDL_strndup(target, separator - target);
+      SDL_CreateDirectory(folder);
+      SDL_free(folder);
+      opened = pack_open_writer(&writer, tmp);
+    }
+  }
+  bool success = opened;
+
+  for (Uint32 i = 0; success && i < pack.num_entries; i++)
+  {
+    struct Pack_Entry *entry = &pack.entries[i];
+    Uint8 *data = SDL_malloc(entry->size ? entry->size : 1);
+
+    if (SDL_SeekIO(io, (Sint64)entry->offset, SDL_IO_SEEK_SET) < 0 || SDL_ReadIO(io, data, entry->size) != entry->size)
+    {
+      success = SDL_SetError("\"%s\" is truncated", entry->name);
+    }
+    else
+    {
+      size_t stripped_size;
+      void *stripped = strip_blob(data, entry->size, formats, &stripped_size);
+
+      if (stripped == NULL)
+      {
+        // the error is formatted into the buffer it comes from
+        char *reason = SDL_strdup(SDL_GetError());
+        success = SDL_SetError("\"%s\": %s", entry->name, reason);
+        SDL_free(reason);
+      }
+      else
+      {
+        success = pack_put(&writer, entry->name, stripped, stripped_size, entry->time);
+      }
+
+      SDL_free(stripped);
+    }
+
+    SDL_free(data);
+  }
+
+  if (opened)
+  {
+    success = pack_close_writer(&writer, 1.0f) && success;
+  }
+
+  if (success)
+  {
+    success = SDL_RenamePath(tmp, target);
+  }
+  else
+  {
+    SDL_RemovePath(tmp);
+  }
+
+  SDL_free(tmp);
+  pack_free(&pack);
+  SDL_CloseIO(io);
+  return success;
+}
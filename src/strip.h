@@ -0,0 +1,14 @@
+#pragma once
+#include <SDL3/SDL_gpu.h>
+
+/*
+  strips compiled shaders down to the formats a platform loads, without
+  recompiling them. sections like the reflection are always kept.
+*/
+
+// returns a new blob with only the code of the given formats, NULL when data is not a blob or has
+// none of them. free with SDL_free
+void *strip_blob(const void *data, size_t size, SDL_GPUShaderFormat formats, size_t *stripped_size);
+
+// writes a copy of a pack with every blob stripped, the modify times are kept
+bool strip_pack(const char *path, const char *target, SDL_GPUShaderFormat formats);